@@ -1,4 +1,4 @@
-/* noise.h - v0.3 - public domain data structures - nickscha 2025
+/* noise.h - v0.4 - public domain data structures - nickscha 2025
 
 A C89 standard compliant, single header, nostdlib (no C Standard Library) Noise Generation (NOISE).
 
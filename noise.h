@@ -1,4 +1,4 @@
-/* noise.h - v0.3 - public domain data structures - nickscha 2025
+/* noise.h - v0.4 - public domain data structures - nickscha 2025
 
 A C89 standard compliant, single header, nostdlib (no C Standard Library) Noise Generation (NOISE).
 
@@ -28,11 +28,109 @@ LICENSE
 
 #define NOISE_API static
 
+#define NOISE_VERSION_MAJOR 0
+#define NOISE_VERSION_MINOR 4
+
 static unsigned char noise_permutations[512];
 static unsigned int noise_lcg_state;
+static unsigned int noise_seed_value; /* seed of the current permutation table */
 static float noise_gradient_2_lut[8][2] = {{1, 1}, {-1, 1}, {1, -1}, {-1, -1}, {1, 0}, {-1, 0}, {0, 1}, {0, -1}};
 static float noise_gradient_3_lut[16][3] = {{1, 1, 0}, {-1, 1, 0}, {1, -1, 0}, {-1, -1, 0}, {1, 0, 1}, {-1, 0, 1}, {1, 0, -1}, {-1, 0, -1}, {0, 1, 1}, {0, -1, 1}, {0, 1, -1}, {0, -1, -1}, {1, 1, 0}, {-1, 1, 0}, {0, -1, 1}, {0, -1, -1}};
 
+/* #############################################################################
+ * # PROFILING
+ * #############################################################################
+ *
+ * Define NOISE_PROFILE before including noise.h to see where a bake spends its work.
+ * Without it every NOISE_PROFILE_* macro expands to nothing and no state exists.
+ *
+ *   samples          fBm sums produced (scalar fBm calls and batch/tile/channel outputs)
+ *   octaves          base noise evaluations, one per octave of every sample
+ *   lattice          lattice corners hashed by those evaluations
+ *   erosion_cells    cells visited by the erosion passes over all iterations
+ *   erosion_active   of those, the cells that actually moved material
+ *   api_calls/ticks  calls and elapsed ticks per grid-level entry point (noise_profile_api)
+ *
+ * Ticks come from a caller-supplied clock (rdtsc, clock_gettime, QueryPerformanceCounter, ...)
+ * so the library stays nostdlib; without one only the counts are recorded. Counters are
+ * doubles so they stay exact up to 2^53 without C99 long long. The state is global and
+ * unsynchronized; profile one thread at a time.
+ */
+#ifdef NOISE_PROFILE
+
+typedef enum noise_profile_api
+{
+  NOISE_PROFILE_API_BATCH = 0,
+  NOISE_PROFILE_API_TILE,
+  NOISE_PROFILE_API_VOLUME,
+  NOISE_PROFILE_API_CHANNELS,
+  NOISE_PROFILE_API_HEIGHTMAP_DERIVE,
+  NOISE_PROFILE_API_TILEABLE_BAKE,
+  NOISE_PROFILE_API_SPECTRAL,
+  NOISE_PROFILE_API_EROSION_THERMAL,
+  NOISE_PROFILE_API_EROSION_HYDRAULIC,
+  NOISE_PROFILE_API_EROSION_WIND,
+  NOISE_PROFILE_API_COUNT
+
+} noise_profile_api;
+
+typedef double (*noise_profile_clock_function)(void);
+
+typedef struct noise_profile
+{
+  double samples;
+  double octaves;
+  double lattice;
+  double erosion_cells;
+  double erosion_active;
+  double api_calls[NOISE_PROFILE_API_COUNT];
+  double api_ticks[NOISE_PROFILE_API_COUNT];
+
+} noise_profile;
+
+static noise_profile noise_profile_state;
+static double noise_profile_start[NOISE_PROFILE_API_COUNT];
+static noise_profile_clock_function noise_profile_clock;
+
+NOISE_API NOISE_INLINE double noise_profile_now(void)
+{
+  return noise_profile_clock ? noise_profile_clock() : 0.0;
+}
+
+NOISE_API NOISE_INLINE void noise_profile_set_clock(noise_profile_clock_function clock)
+{
+  noise_profile_clock = clock;
+}
+
+NOISE_API NOISE_INLINE void noise_profile_reset(void)
+{
+  static noise_profile zero;
+  noise_profile_state = zero;
+}
+
+NOISE_API NOISE_INLINE void noise_profile_snapshot(noise_profile *out)
+{
+  *out = noise_profile_state;
+}
+
+#define NOISE_PROFILE_SAMPLES(n) (noise_profile_state.samples += (double)(n))
+#define NOISE_PROFILE_OCTAVE(lookups) (noise_profile_state.octaves += 1.0, noise_profile_state.lattice += (double)(lookups))
+#define NOISE_PROFILE_EROSION_CELLS(n) (noise_profile_state.erosion_cells += (double)(n))
+#define NOISE_PROFILE_EROSION_ACTIVE(n) (noise_profile_state.erosion_active += (double)(n))
+#define NOISE_PROFILE_BEGIN(api) (noise_profile_start[api] = noise_profile_now())
+#define NOISE_PROFILE_END(api) (noise_profile_state.api_calls[api] += 1.0, noise_profile_state.api_ticks[api] += noise_profile_now() - noise_profile_start[api])
+
+#else
+
+#define NOISE_PROFILE_SAMPLES(n)
+#define NOISE_PROFILE_OCTAVE(lookups)
+#define NOISE_PROFILE_EROSION_CELLS(n)
+#define NOISE_PROFILE_EROSION_ACTIVE(n)
+#define NOISE_PROFILE_BEGIN(api)
+#define NOISE_PROFILE_END(api)
+
+#endif /* NOISE_PROFILE */
+
 NOISE_API NOISE_INLINE void noise_swap_byte(unsigned char *a, unsigned char *b)
 {
   unsigned char t = *a;
@@ -103,47 +201,218 @@ NOISE_API NOISE_INLINE float noise_dot3(float g[3], float x, float y, float z)
   return g[0] * x + g[1] * y + g[2] * z;
 }
 
+/* 1 / sqrt(x) for x > 0 without the C standard library: bit-level estimate refined by two Newton steps */
+NOISE_API NOISE_INLINE float noise_rsqrt(float x)
+{
+  union
+  {
+    float f;
+    unsigned int i;
+  } u;
+  float half = 0.5f * x;
+
+  u.f = x;
+  u.i = 0x5f3759dfu - (u.i >> 1);
+  u.f = u.f * (1.5f - half * u.f * u.f);
+  u.f = u.f * (1.5f - half * u.f * u.f);
+
+  return u.f;
+}
+
+NOISE_API NOISE_INLINE float noise_sqrt(float x)
+{
+  return x > 0.0f ? x * noise_rsqrt(x) : 0.0f;
+}
+
+#define NOISE_PI 3.14159265f
+
+/* sin(x) without the C standard library: range reduction to [-pi/2, pi/2] and a degree 11 Taylor polynomial (error ~1e-7) */
+NOISE_API NOISE_INLINE float noise_sin(float x)
+{
+  float x2;
+
+  x -= 2.0f * NOISE_PI * noise_floor((x + NOISE_PI) * (0.5f / NOISE_PI));
+  x = x > 0.5f * NOISE_PI ? NOISE_PI - x : (x < -0.5f * NOISE_PI ? -NOISE_PI - x : x);
+  x2 = x * x;
+
+  return x * (1.0f - x2 / 6.0f * (1.0f - x2 / 20.0f * (1.0f - x2 / 42.0f * (1.0f - x2 / 72.0f * (1.0f - x2 / 110.0f)))));
+}
+
+NOISE_API NOISE_INLINE float noise_cos(float x)
+{
+  return noise_sin(x + 0.5f * NOISE_PI);
+}
+
+/* log2(x) for x > 0: exponent bits plus an atanh series of the mantissa (error ~1e-6) */
+NOISE_API NOISE_INLINE float noise_log2(float x)
+{
+  union
+  {
+    float f;
+    unsigned int i;
+  } u;
+  float e, t, t2;
+
+  u.f = x;
+  e = (float)((int)((u.i >> 23) & 255u) - 127);
+  u.i = (u.i & 0x007fffffu) | 0x3f800000u; /* mantissa in [1, 2) */
+  t = (u.f - 1.0f) / (u.f + 1.0f);
+  t2 = t * t;
+
+  return e + 2.8853901f * t * (1.0f + t2 * (1.0f / 3.0f + t2 * (1.0f / 5.0f + t2 * (1.0f / 7.0f + t2 / 9.0f)))); /* 2 / ln 2 */
+}
+
+/* 2^x: integer part into the exponent bits, fraction by a degree 7 polynomial (error ~1e-6) */
+NOISE_API NOISE_INLINE float noise_exp2(float x)
+{
+  union
+  {
+    float f;
+    unsigned int i;
+  } u;
+  float i, f;
+
+  if (x < -126.0f)
+  {
+    return 0.0f;
+  }
+
+  x = x > 127.0f ? 127.0f : x;
+  i = noise_floor(x);
+  f = (x - i) * 0.69314718f; /* ln 2 */
+  u.i = (unsigned int)((int)i + 127) << 23;
+
+  return u.f * (1.0f + f * (1.0f + f / 2.0f * (1.0f + f / 3.0f * (1.0f + f / 4.0f * (1.0f + f / 5.0f * (1.0f + f / 6.0f * (1.0f + f / 7.0f)))))));
+}
+
+NOISE_API NOISE_INLINE float noise_pow(float x, float y)
+{
+  return x > 0.0f ? noise_exp2(y * noise_log2(x)) : 0.0f;
+}
+
 NOISE_API NOISE_INLINE float noise_hash(float n)
 {
   float f = noise_fract(n * 0.3183099f);
   return noise_fract(n * 17.0f * f);
 }
 
+/* sequential generator kept for existing callers, the library itself uses noise_random_u32 */
 NOISE_API NOISE_INLINE unsigned noise_lcg_next(void)
 {
   noise_lcg_state = noise_lcg_state * 1664525u + 1013904223u;
   return noise_lcg_state;
 }
 
-NOISE_API NOISE_INLINE void noise_seed(unsigned int seed)
+/* #############################################################################
+ * # Random number functions
+ * #############################################################################
+ *
+ * Stateless counter-based generator: the value at (seed, stream, index) is a hash, so any
+ * element of any stream can be computed directly. Workers draw from their own stream (or
+ * their own index range) without sharing a state word, and results do not depend on how
+ * the work was split. Each stream is a SplitMix-style Weyl sequence run through a 32-bit
+ * integer finalizer whose low bits are as good as its high bits.
+ */
+NOISE_API NOISE_INLINE unsigned int noise_random_mix(unsigned int x)
+{
+  x ^= x >> 16;
+  x *= 0x7feb352du;
+  x ^= x >> 15;
+  x *= 0x846ca68bu;
+  x ^= x >> 16;
+  return x;
+}
+
+NOISE_API NOISE_INLINE unsigned int noise_random_key(unsigned int seed, unsigned int stream)
+{
+  return noise_random_mix(seed ^ noise_random_mix(stream + 0x632be5abu));
+}
+
+NOISE_API NOISE_INLINE unsigned int noise_random_u32(unsigned int seed, unsigned int stream, unsigned int index)
+{
+  return noise_random_mix(noise_random_key(seed, stream) + index * 0x9e3779b9u);
+}
+
+/* uniform in [0, 1) with 24 bits */
+NOISE_API NOISE_INLINE float noise_random_float(unsigned int seed, unsigned int stream, unsigned int index)
+{
+  return (float)(noise_random_u32(seed, stream, index) >> 8) * (1.0f / 16777216.0f);
+}
+
+/* uniform in [0, n) for any n as the high 32 bits of r * n (multiply-shift, no modulo bias from low bits).
+   The 64 bit product is assembled from 16 bit halves since C89 has no 64 bit integer. */
+NOISE_API NOISE_INLINE unsigned int noise_random_below(unsigned int r, unsigned int n)
+{
+  unsigned int rl = r & 0xffffu, rh = r >> 16;
+  unsigned int nl = n & 0xffffu, nh = n >> 16;
+  unsigned int t = rh * nl + ((rl * nl) >> 16);
+  unsigned int w = (t & 0xffffu) + rl * nh;
+
+  return rh * nh + (t >> 16) + (w >> 16);
+}
+
+/* out[i] = noise_random_u32(seed, stream, first + i), independent lanes the compiler can vectorize */
+NOISE_API NOISE_INLINE void noise_random_fill_u32(unsigned int *out, int count, unsigned int seed, unsigned int stream, unsigned int first)
+{
+  unsigned int key = noise_random_key(seed, stream) + first * 0x9e3779b9u;
+  int i;
+
+  for (i = 0; i < count; ++i)
+  {
+    out[i] = noise_random_mix(key + (unsigned int)i * 0x9e3779b9u);
+  }
+}
+
+/* out[i] = noise_random_float(seed, stream, first + i) */
+NOISE_API NOISE_INLINE void noise_random_fill_float(float *out, int count, unsigned int seed, unsigned int stream, unsigned int first)
+{
+  unsigned int key = noise_random_key(seed, stream) + first * 0x9e3779b9u;
+  int i;
+
+  for (i = 0; i < count; ++i)
+  {
+    out[i] = (float)(noise_random_mix(key + (unsigned int)i * 0x9e3779b9u) >> 8) * (1.0f / 16777216.0f);
+  }
+}
+
+/* fills a 512 entry table (256 shuffled entries, repeated) the way noise_seed fills the
+ * global one, for kernels that take their table explicitly */
+NOISE_API NOISE_INLINE void noise_permutation_build(unsigned char *perm, unsigned int seed)
 {
   int i;
-  noise_lcg_state = seed;
 
   for (i = 0; i < 256; ++i)
   {
-    noise_permutations[i] = (unsigned char)i;
+    perm[i] = (unsigned char)i;
   }
 
+  /* Fisher-Yates on stream 0 of the counter-based generator */
   for (i = 255; i > 0; --i)
   {
-    unsigned r = noise_lcg_next() % (unsigned int)(i + 1);
-    noise_swap_byte(&noise_permutations[i], &noise_permutations[(int)r]);
+    unsigned r = noise_random_below(noise_random_u32(seed, 0, (unsigned int)i), (unsigned int)(i + 1));
+    noise_swap_byte(&perm[i], &perm[(int)r]);
   }
 
   for (i = 0; i < 256; ++i)
   {
-    noise_permutations[256 + i] = noise_permutations[i];
+    perm[256 + i] = perm[i];
   }
 }
 
+NOISE_API NOISE_INLINE void noise_seed(unsigned int seed)
+{
+  noise_lcg_state = seed;
+  noise_seed_value = seed;
+
+  noise_permutation_build(noise_permutations, seed);
+}
+
 /* #############################################################################
  * # Perlin Noise functions
  * #############################################################################
  */
-NOISE_API NOISE_INLINE float noise_perlin_2(float x, float y, float frequency)
+NOISE_API NOISE_INLINE float noise_perlin_2_table(const unsigned char *perm, float x, float y, float frequency)
 {
-  unsigned char *perm = noise_permutations;
   int X, Y, aa, ab, ba, bb;
   float xf, yf, u, v, x1, x2, y1;
   float floor_x, floor_y;
@@ -161,6 +430,8 @@ NOISE_API NOISE_INLINE float noise_perlin_2(float x, float y, float frequency)
   u = noise_fade(xf);
   v = noise_fade(yf);
 
+  NOISE_PROFILE_OCTAVE(4);
+
   aa = perm[perm[X] + Y];
   ab = perm[perm[X] + Y + 1];
   ba = perm[perm[X + 1] + Y];
@@ -175,9 +446,13 @@ NOISE_API NOISE_INLINE float noise_perlin_2(float x, float y, float frequency)
   return y1 * 0.70710678f; /* normalize -1 to 1 */
 }
 
-NOISE_API NOISE_INLINE float noise_perlin_3(float x, float y, float z, float freq)
+NOISE_API NOISE_INLINE float noise_perlin_2(float x, float y, float frequency)
+{
+  return noise_perlin_2_table(noise_permutations, x, y, frequency);
+}
+
+NOISE_API NOISE_INLINE float noise_perlin_3_table(const unsigned char *perm, float x, float y, float z, float freq)
 {
-  unsigned char *perm = noise_permutations;
   int X, Y, Z, aaa, aba, aab, abb, baa, bba, bab, bbb;
   float xf, yf, zf, u, v, w, x1, x2, y1, y2;
   float floor_x, floor_y, floor_z;
@@ -200,6 +475,8 @@ NOISE_API NOISE_INLINE float noise_perlin_3(float x, float y, float z, float fre
   v = noise_fade(yf);
   w = noise_fade(zf);
 
+  NOISE_PROFILE_OCTAVE(8);
+
   aaa = perm[perm[perm[X] + Y] + Z];
   aba = perm[perm[perm[X] + Y + 1] + Z];
   aab = perm[perm[perm[X] + Y] + Z + 1];
@@ -224,11 +501,18 @@ NOISE_API NOISE_INLINE float noise_perlin_3(float x, float y, float z, float fre
   return noise_lerp(y1, y2, w) * 0.70710678f; /* normalize -1 to 1 */
 }
 
+NOISE_API NOISE_INLINE float noise_perlin_3(float x, float y, float z, float freq)
+{
+  return noise_perlin_3_table(noise_permutations, x, y, z, freq);
+}
+
 NOISE_API NOISE_INLINE float noise_perlin_2_fbm(float x, float y, float frequency, int octaves, float lacunarity, float gain)
 {
   int i;
   float sum = 0, amp = 1, f = frequency, norm = 0;
 
+  NOISE_PROFILE_SAMPLES(1);
+
   for (i = 0; i < octaves; ++i)
   {
     sum += amp * noise_perlin_2(x, y, f);
@@ -248,6 +532,8 @@ NOISE_API NOISE_INLINE float noise_perlin_2_fbm_rotation(float x, float y, float
   p[0] = x * frequency;
   p[1] = y * frequency;
 
+  NOISE_PROFILE_SAMPLES(1);
+
   for (i = 0; i < octaves; ++i)
   {
     float tmp[2];
@@ -272,6 +558,8 @@ NOISE_API NOISE_INLINE float noise_perlin_3_fbm(float x, float y, float z, float
   int i;
   float sum = 0, amp = 1, f = frequency, norm = 0;
 
+  NOISE_PROFILE_SAMPLES(1);
+
   for (i = 0; i < octaves; ++i)
   {
     sum += amp * noise_perlin_3(x, y, z, f);
@@ -293,6 +581,8 @@ NOISE_API NOISE_INLINE float noise_perlin_3_fbm_rotation(float x, float y, float
   p[1] = y * frequency;
   p[2] = z * frequency;
 
+  NOISE_PROFILE_SAMPLES(1);
+
   for (i = 0; i < octaves; ++i)
   {
     float tmp[3];
@@ -322,7 +612,7 @@ NOISE_API NOISE_INLINE float noise_perlin_3_fbm_rotation(float x, float y, float
 #define NOISE_SIMPLEX_F3 (1.0f / 3.0f)
 #define NOISE_SIMPLEX_G3 (1.0f / 6.0f)
 
-NOISE_API NOISE_INLINE float noise_simplex_2(float x, float y, float frequency)
+NOISE_API NOISE_INLINE float noise_simplex_2_table(const unsigned char *perm, float x, float y, float frequency)
 {
   int i, j, gi0, gi1, gi2;
   float n0, n1, n2; /* noise contributions from the three corners */
@@ -367,11 +657,13 @@ NOISE_API NOISE_INLINE float noise_simplex_2(float x, float y, float frequency)
   jj = j & 255;
 
   /* Using permutation table to pick gradients */
-  idx = (int)noise_permutations[ii + noise_permutations[jj]];
+  NOISE_PROFILE_OCTAVE(3);
+
+  idx = (int)perm[ii + perm[jj]];
   gi0 = idx & 7; /* use 8 2D gradients */
-  idx = (int)noise_permutations[ii + i1 + noise_permutations[jj + j1]];
+  idx = (int)perm[ii + i1 + perm[jj + j1]];
   gi1 = idx & 7;
-  idx = (int)noise_permutations[ii + 1 + noise_permutations[jj + 1]];
+  idx = (int)perm[ii + 1 + perm[jj + 1]];
   gi2 = idx & 7;
 
   /* Calculate the contribution from the three corners */
@@ -415,7 +707,12 @@ NOISE_API NOISE_INLINE float noise_simplex_2(float x, float y, float frequency)
   return 70.0f * (n0 + n1 + n2);
 }
 
-NOISE_API NOISE_INLINE float noise_simplex_3(float x, float y, float z, float frequency)
+NOISE_API NOISE_INLINE float noise_simplex_2(float x, float y, float frequency)
+{
+  return noise_simplex_2_table(noise_permutations, x, y, frequency);
+}
+
+NOISE_API NOISE_INLINE float noise_simplex_3_table(const unsigned char *perm, float x, float y, float z, float frequency)
 {
   float n0, n1, n2, n3;
   float s, t;
@@ -532,13 +829,15 @@ NOISE_API NOISE_INLINE float noise_simplex_3(float x, float y, float z, float fr
   jj = j & 255;
   kk = k & 255;
 
-  idx = (int)noise_permutations[ii + noise_permutations[jj + noise_permutations[kk]]];
+  NOISE_PROFILE_OCTAVE(4);
+
+  idx = (int)perm[ii + perm[jj + perm[kk]]];
   gi0 = idx & 15; /* use 16 3D gradients */
-  idx = (int)noise_permutations[ii + i1 + noise_permutations[jj + j1 + noise_permutations[kk + k1]]];
+  idx = (int)perm[ii + i1 + perm[jj + j1 + perm[kk + k1]]];
   gi1 = idx & 15;
-  idx = (int)noise_permutations[ii + i2 + noise_permutations[jj + j2 + noise_permutations[kk + k2]]];
+  idx = (int)perm[ii + i2 + perm[jj + j2 + perm[kk + k2]]];
   gi2 = idx & 15;
-  idx = (int)noise_permutations[ii + 1 + noise_permutations[jj + 1 + noise_permutations[kk + 1]]];
+  idx = (int)perm[ii + 1 + perm[jj + 1 + perm[kk + 1]]];
   gi3 = idx & 15;
 
   /* Calculate the contribution from the four corners */
@@ -594,6 +893,11 @@ NOISE_API NOISE_INLINE float noise_simplex_3(float x, float y, float z, float fr
   return 32.0f * (n0 + n1 + n2 + n3);
 }
 
+NOISE_API NOISE_INLINE float noise_simplex_3(float x, float y, float z, float frequency)
+{
+  return noise_simplex_3_table(noise_permutations, x, y, z, frequency);
+}
+
 NOISE_API NOISE_INLINE float noise_simplex_2_fbm(float x, float y, float frequency, int octaves, float lacunarity, float gain)
 {
   int i;
@@ -602,6 +906,8 @@ NOISE_API NOISE_INLINE float noise_simplex_2_fbm(float x, float y, float frequen
   float f = frequency;
   float norm = 0.0f;
 
+  NOISE_PROFILE_SAMPLES(1);
+
   for (i = 0; i < octaves; ++i)
   {
     sum += amp * noise_simplex_2(x, y, f);
@@ -621,6 +927,8 @@ NOISE_API NOISE_INLINE float noise_simplex_3_fbm(float x, float y, float z, floa
   float f = frequency;
   float norm = 0.0f;
 
+  NOISE_PROFILE_SAMPLES(1);
+
   for (i = 0; i < octaves; ++i)
   {
     sum += amp * noise_simplex_3(x, y, z, f);
@@ -650,6 +958,8 @@ NOISE_API NOISE_INLINE float noise_simplex_2_fbm_rotation(
   p[0] = x * frequency;
   p[1] = y * frequency;
 
+  NOISE_PROFILE_SAMPLES(1);
+
   for (i = 0; i < octaves; ++i)
   {
     /* sample noise */
@@ -686,6 +996,8 @@ NOISE_API NOISE_INLINE float noise_simplex_3_fbm_rotation(
   p[1] = y * frequency;
   p[2] = z * frequency;
 
+  NOISE_PROFILE_SAMPLES(1);
+
   for (i = 0; i < octaves; ++i)
   {
     /* sample noise */
@@ -704,15 +1016,181 @@ NOISE_API NOISE_INLINE float noise_simplex_3_fbm_rotation(
   return sum / norm;
 }
 
+/* Vector-valued simplex noise: up to three decorrelated channels from one lattice traversal.
+ *
+ * All channels share the skew, cell location, corner offsets and falloff; only the
+ * gradient differs. Channel 0 uses the same gradient set as noise_simplex_2, channel 1
+ * the next three bits of the corner hash and channel 2 a second permutation lookup.
+ */
+NOISE_API NOISE_INLINE void noise_simplex_2_vec(float x, float y, float frequency, int channels, float *out)
+{
+  float s, t, xs, ys;
+  float cx[3], cy[3];
+  int cidx[3];
+  int i, j, ii, jj, i1, j1, k;
+
+  x *= frequency;
+  y *= frequency;
+
+  /* Skew the input space to determine which simplex cell we're in */
+  s = (x + y) * NOISE_SIMPLEX_F2;
+  xs = x + s;
+  ys = y + s;
+  i = (int)noise_floor(xs);
+  j = (int)noise_floor(ys);
+
+  t = (float)(i + j) * NOISE_SIMPLEX_G2;
+  cx[0] = x - (float)i + t; /* unskew the cell origin back to (x,y) space */
+  cy[0] = y - (float)j + t;
+
+  i1 = cx[0] > cy[0] ? 1 : 0;
+  j1 = 1 - i1;
+
+  /* Offsets for the other corners */
+  cx[1] = cx[0] - (float)i1 + NOISE_SIMPLEX_G2;
+  cy[1] = cy[0] - (float)j1 + NOISE_SIMPLEX_G2;
+  cx[2] = cx[0] - 1.0f + 2.0f * NOISE_SIMPLEX_G2;
+  cy[2] = cy[0] - 1.0f + 2.0f * NOISE_SIMPLEX_G2;
+
+  ii = i & 255;
+  jj = j & 255;
+
+  NOISE_PROFILE_OCTAVE(3);
+
+  cidx[0] = (int)noise_permutations[ii + noise_permutations[jj]];
+  cidx[1] = (int)noise_permutations[ii + i1 + noise_permutations[jj + j1]];
+  cidx[2] = (int)noise_permutations[ii + 1 + noise_permutations[jj + 1]];
+
+  for (k = 0; k < channels; ++k)
+  {
+    out[k] = 0.0f;
+  }
+
+  /* Calculate the contribution from the three corners for every channel */
+  for (k = 0; k < 3; ++k)
+  {
+    float tk = 0.5f - cx[k] * cx[k] - cy[k] * cy[k];
+
+    if (tk < 0.0f)
+    {
+      continue;
+    }
+
+    tk = tk * tk;
+    tk = tk * tk;
+
+    out[0] += tk * noise_dot2(noise_gradient_2_lut[cidx[k] & 7], cx[k], cy[k]);
+
+    if (channels > 1)
+    {
+      out[1] += tk * noise_dot2(noise_gradient_2_lut[(cidx[k] >> 3) & 7], cx[k], cy[k]);
+    }
+
+    if (channels > 2)
+    {
+      out[2] += tk * noise_dot2(noise_gradient_2_lut[noise_permutations[cidx[k]] & 7], cx[k], cy[k]);
+    }
+  }
+
+  for (k = 0; k < channels; ++k)
+  {
+    out[k] *= 70.0f;
+  }
+}
+
+NOISE_API NOISE_INLINE void noise_simplex_2_vec2(float x, float y, float frequency, float out[2])
+{
+  noise_simplex_2_vec(x, y, frequency, 2, out);
+}
+
+NOISE_API NOISE_INLINE void noise_simplex_2_vec3(float x, float y, float frequency, float out[3])
+{
+  noise_simplex_2_vec(x, y, frequency, 3, out);
+}
+
+NOISE_API NOISE_INLINE void noise_simplex_2_vec2_fbm(float x, float y, float frequency, int octaves, float lacunarity, float gain, float out[2])
+{
+  int i;
+  float amp = 1.0f;
+  float f = frequency;
+  float norm = 0.0f;
+  float v[2];
+
+  out[0] = 0.0f;
+  out[1] = 0.0f;
+
+  NOISE_PROFILE_SAMPLES(1);
+
+  for (i = 0; i < octaves; ++i)
+  {
+    noise_simplex_2_vec2(x, y, f, v);
+    out[0] += amp * v[0];
+    out[1] += amp * v[1];
+    norm += amp;
+    f *= lacunarity;
+    amp *= gain;
+  }
+
+  out[0] /= norm;
+  out[1] /= norm;
+}
+
+NOISE_API NOISE_INLINE void noise_simplex_2_vec2_fbm_rotation(
+    float x, float y,
+    float frequency,
+    int octaves,
+    float lacunarity,
+    float gain,
+    float rotation[2][2],
+    float out[2])
+{
+  int i;
+  float amp = 1.0f;
+  float norm = 0.0f;
+  float p[2];
+  float tmp[2];
+  float v[2];
+
+  p[0] = x * frequency;
+  p[1] = y * frequency;
+  out[0] = 0.0f;
+  out[1] = 0.0f;
+
+  NOISE_PROFILE_SAMPLES(1);
+
+  for (i = 0; i < octaves; ++i)
+  {
+    /* sample noise */
+    noise_simplex_2_vec2(p[0], p[1], 1.0f, v);
+    out[0] += amp * v[0];
+    out[1] += amp * v[1];
+    norm += amp;
+
+    /* rotate and scale */
+    noise_m2x2_mul(rotation, p, tmp);
+    p[0] = tmp[0] * lacunarity;
+    p[1] = tmp[1] * lacunarity;
+
+    amp *= gain;
+  }
+
+  out[0] /= norm;
+  out[1] /= norm;
+}
+
+/* The warp offsets are the two channels of one vector-valued sample, so both share
+ * a single lattice traversal per octave.
+ */
 NOISE_API NOISE_INLINE float noise_simplex_2_domain_warp(
     float x, float y,
     float frequency,
     float amplitude)
 {
-  float wx = noise_simplex_2(x + 5.2f, y + 1.3f, frequency) * amplitude;
-  float wy = noise_simplex_2(x + 8.5f, y + 2.8f, frequency) * amplitude;
+  float warp[2];
 
-  return noise_simplex_2(x + wx, y + wy, frequency);
+  noise_simplex_2_vec2(x + 5.2f, y + 1.3f, frequency, warp);
+
+  return noise_simplex_2(x + warp[0] * amplitude, y + warp[1] * amplitude, frequency);
 }
 
 NOISE_API NOISE_INLINE float noise_simplex_2_domain_warp_fbm(
@@ -723,10 +1201,11 @@ NOISE_API NOISE_INLINE float noise_simplex_2_domain_warp_fbm(
     float gain,
     float amplitude)
 {
-  float warp_x = noise_simplex_2_fbm(x + 5.2f, y + 1.3f, frequency, octaves, lacunarity, gain) * amplitude;
-  float warp_y = noise_simplex_2_fbm(x + 8.5f, y + 2.8f, frequency, octaves, lacunarity, gain) * amplitude;
+  float warp[2];
+
+  noise_simplex_2_vec2_fbm(x + 5.2f, y + 1.3f, frequency, octaves, lacunarity, gain, warp);
 
-  return noise_simplex_2_fbm(x + warp_x, y + warp_y, frequency, octaves, lacunarity, gain);
+  return noise_simplex_2_fbm(x + warp[0] * amplitude, y + warp[1] * amplitude, frequency, octaves, lacunarity, gain);
 }
 
 NOISE_API NOISE_INLINE float noise_simplex_2_domain_warp_fbm_rotation(
@@ -738,10 +1217,11 @@ NOISE_API NOISE_INLINE float noise_simplex_2_domain_warp_fbm_rotation(
     float amplitude,
     float rotation[2][2])
 {
-  float warp_x = noise_simplex_2_fbm_rotation(x + 5.2f, y + 1.3f, frequency, octaves, lacunarity, gain, rotation) * amplitude;
-  float warp_y = noise_simplex_2_fbm_rotation(x + 8.5f, y + 2.8f, frequency, octaves, lacunarity, gain, rotation) * amplitude;
+  float warp[2];
 
-  return noise_simplex_2_fbm_rotation(x + warp_x, y + warp_y, frequency, octaves, lacunarity, gain, rotation);
+  noise_simplex_2_vec2_fbm_rotation(x + 5.2f, y + 1.3f, frequency, octaves, lacunarity, gain, rotation, warp);
+
+  return noise_simplex_2_fbm_rotation(x + warp[0] * amplitude, y + warp[1] * amplitude, frequency, octaves, lacunarity, gain, rotation);
 }
 
 /* #############################################################################
@@ -770,6 +1250,8 @@ NOISE_API NOISE_INLINE float noise_value_2(float x, float y, float frequency)
   ux = wx * wx * wx * (wx * (wx * 6.0f - 15.0f) + 10.0f);
   uy = wy * wy * wy * (wy * (wy * 6.0f - 15.0f) + 10.0f);
 
+  NOISE_PROFILE_OCTAVE(4);
+
   a = noise_hash(px + 317.0f * py + 0.0f);
   b = noise_hash(px + 317.0f * py + 1.0f);
   c = noise_hash(px + 317.0f * (py + 1.0f) + 0.0f);
@@ -791,6 +1273,8 @@ NOISE_API NOISE_INLINE float noise_value_2_fbm(float x, float y, float frequency
   float f = frequency;
   float norm = 0.0f;
 
+  NOISE_PROFILE_SAMPLES(1);
+
   for (i = 0; i < octaves; ++i)
   {
     sum += amp * noise_value_2(x, y, f);
@@ -815,6 +1299,8 @@ NOISE_API NOISE_INLINE float noise_value_2_fbm_rotation(float x, float y, float
   p[0] = x * frequency;
   p[1] = y * frequency;
 
+  NOISE_PROFILE_SAMPLES(1);
+
   for (i = 0; i < octaves; ++i)
   {
     /* sample value noise at frequency 1.0 */
@@ -833,47 +1319,5623 @@ NOISE_API NOISE_INLINE float noise_value_2_fbm_rotation(float x, float y, float
 }
 
 /* #############################################################################
- * # Erosion simulation functions
+ * # fBm plan functions
  * #############################################################################
+ *
+ * A plan precomputes everything about an fBm that does not depend on the sample
+ * position: for every octave the composed transform frequency * (lacunarity * rotation)^i
+ * and the amplitude gain^i / sum(gain^k). The per-sample loop is then only a transform
+ * and a multiply-add per octave, with no final divide.
+ *
+ * Build a plan once with noise_fbm_plan_2/noise_fbm_plan_3 (rotation may be 0) and pass
+ * it to any of the *_fbm_plan sampling functions. A plan holds at most
+ * NOISE_FBM_PLAN_MAX_OCTAVES octaves; building one with more (or fewer than one) returns
+ * 0 and leaves an empty plan that samples to 0, so plan results never silently differ
+ * from the non-plan fBm functions. Functions that build plans from their arguments
+ * return that result.
  */
+#define NOISE_FBM_PLAN_MAX_OCTAVES 16
 
-NOISE_API void noise_erosion_thermal(float *heightmap, int width, int height, float talus, int iterations)
+typedef struct noise_fbm_plan
 {
-  int iter, x, y, i;
-  int dx[8] = {-1, 0, 1, -1, 1, -1, 0, 1};
-  int dy[8] = {-1, -1, -1, 0, 0, 1, 1, 1};
+  int octaves;
+  float amplitude[NOISE_FBM_PLAN_MAX_OCTAVES];
+  float transform[NOISE_FBM_PLAN_MAX_OCTAVES][3][3];
 
-  for (iter = 0; iter < iterations; ++iter)
-  {
-    for (y = 1; y < height - 1; ++y)
-    {
-      for (x = 1; x < width - 1; ++x)
-      {
-        float h = heightmap[y * width + x];
-        float dmax = 0.0f;
-        int imax = -1;
+} noise_fbm_plan;
 
-        /* find steepest neighbor */
-        for (i = 0; i < 8; ++i)
-        {
-          float n = heightmap[(y + dy[i]) * width + (x + dx[i])];
-          float diff = h - n;
-          if (diff > dmax)
-          {
-            dmax = diff;
-            imax = i;
-          }
-        }
+/* rotation is a 3x3 matrix or 0, dimensions selects how much of it is used;
+ * returns 0 if octaves is outside [1, NOISE_FBM_PLAN_MAX_OCTAVES] */
+NOISE_API NOISE_INLINE int noise_fbm_plan_build(noise_fbm_plan *plan, int dimensions, float frequency, int octaves, float lacunarity, float gain, float *rotation)
+{
+  float m[3][3];
+  float amp = 1.0f, norm = 0.0f;
+  int i, r, c, k;
 
-        /* move small portion of material if slope exceeds talus */
-        if (dmax > talus && imax >= 0)
+  if (octaves < 1 || octaves > NOISE_FBM_PLAN_MAX_OCTAVES)
+  {
+    plan->octaves = 0;
+    return 0;
+  }
+
+  plan->octaves = octaves;
+
+  for (r = 0; r < 3; ++r)
+  {
+    for (c = 0; c < 3; ++c)
+    {
+      m[r][c] = (r == c) ? frequency : 0.0f;
+    }
+  }
+
+  for (i = 0; i < octaves; ++i)
+  {
+    float t[3][3];
+
+    plan->amplitude[i] = amp;
+    norm += amp;
+    amp *= gain;
+
+    for (r = 0; r < 3; ++r)
+    {
+      for (c = 0; c < 3; ++c)
+      {
+        plan->transform[i][r][c] = m[r][c];
+      }
+    }
+
+    /* next octave: rotate then scale */
+    for (r = 0; r < 3; ++r)
+    {
+      for (c = 0; c < 3; ++c)
+      {
+        if (!rotation || r >= dimensions || c >= dimensions)
+        {
+          t[r][c] = m[r][c] * lacunarity;
+          continue;
+        }
+
+        t[r][c] = 0.0f;
+
+        for (k = 0; k < dimensions; ++k)
+        {
+          t[r][c] += rotation[r * dimensions + k] * m[k][c];
+        }
+
+        t[r][c] *= lacunarity;
+      }
+    }
+
+    for (r = 0; r < 3; ++r)
+    {
+      for (c = 0; c < 3; ++c)
+      {
+        m[r][c] = t[r][c];
+      }
+    }
+  }
+
+  for (i = 0; i < octaves; ++i)
+  {
+    plan->amplitude[i] /= norm;
+  }
+
+  return 1;
+}
+
+NOISE_API NOISE_INLINE int noise_fbm_plan_2(noise_fbm_plan *plan, float frequency, int octaves, float lacunarity, float gain, float rotation[2][2])
+{
+  return noise_fbm_plan_build(plan, 2, frequency, octaves, lacunarity, gain, rotation ? &rotation[0][0] : 0);
+}
+
+NOISE_API NOISE_INLINE int noise_fbm_plan_3(noise_fbm_plan *plan, float frequency, int octaves, float lacunarity, float gain, float rotation[3][3])
+{
+  return noise_fbm_plan_build(plan, 3, frequency, octaves, lacunarity, gain, rotation ? &rotation[0][0] : 0);
+}
+
+NOISE_API NOISE_INLINE float noise_perlin_2_fbm_plan(noise_fbm_plan *plan, float x, float y)
+{
+  float sum = 0.0f;
+  int i;
+
+  NOISE_PROFILE_SAMPLES(1);
+
+  for (i = 0; i < plan->octaves; ++i)
+  {
+    float (*m)[3] = plan->transform[i];
+    sum += plan->amplitude[i] * noise_perlin_2(m[0][0] * x + m[0][1] * y, m[1][0] * x + m[1][1] * y, 1.0f);
+  }
+
+  return sum;
+}
+
+NOISE_API NOISE_INLINE float noise_perlin_3_fbm_plan(noise_fbm_plan *plan, float x, float y, float z)
+{
+  float sum = 0.0f;
+  int i;
+
+  NOISE_PROFILE_SAMPLES(1);
+
+  for (i = 0; i < plan->octaves; ++i)
+  {
+    float (*m)[3] = plan->transform[i];
+    sum += plan->amplitude[i] * noise_perlin_3(m[0][0] * x + m[0][1] * y + m[0][2] * z,
+                                               m[1][0] * x + m[1][1] * y + m[1][2] * z,
+                                               m[2][0] * x + m[2][1] * y + m[2][2] * z, 1.0f);
+  }
+
+  return sum;
+}
+
+NOISE_API NOISE_INLINE float noise_simplex_2_fbm_plan(noise_fbm_plan *plan, float x, float y)
+{
+  float sum = 0.0f;
+  int i;
+
+  NOISE_PROFILE_SAMPLES(1);
+
+  for (i = 0; i < plan->octaves; ++i)
+  {
+    float (*m)[3] = plan->transform[i];
+    sum += plan->amplitude[i] * noise_simplex_2(m[0][0] * x + m[0][1] * y, m[1][0] * x + m[1][1] * y, 1.0f);
+  }
+
+  return sum;
+}
+
+NOISE_API NOISE_INLINE float noise_simplex_3_fbm_plan(noise_fbm_plan *plan, float x, float y, float z)
+{
+  float sum = 0.0f;
+  int i;
+
+  NOISE_PROFILE_SAMPLES(1);
+
+  for (i = 0; i < plan->octaves; ++i)
+  {
+    float (*m)[3] = plan->transform[i];
+    sum += plan->amplitude[i] * noise_simplex_3(m[0][0] * x + m[0][1] * y + m[0][2] * z,
+                                                m[1][0] * x + m[1][1] * y + m[1][2] * z,
+                                                m[2][0] * x + m[2][1] * y + m[2][2] * z, 1.0f);
+  }
+
+  return sum;
+}
+
+NOISE_API NOISE_INLINE float noise_value_2_fbm_plan(noise_fbm_plan *plan, float x, float y)
+{
+  float sum = 0.0f;
+  int i;
+
+  NOISE_PROFILE_SAMPLES(1);
+
+  for (i = 0; i < plan->octaves; ++i)
+  {
+    float (*m)[3] = plan->transform[i];
+    sum += plan->amplitude[i] * noise_value_2(m[0][0] * x + m[0][1] * y, m[1][0] * x + m[1][1] * y, 1.0f);
+  }
+
+  return sum;
+}
+
+NOISE_API NOISE_INLINE void noise_simplex_2_vec2_fbm_plan(noise_fbm_plan *plan, float x, float y, float out[2])
+{
+  float v[2];
+  int i;
+
+  out[0] = 0.0f;
+  out[1] = 0.0f;
+
+  NOISE_PROFILE_SAMPLES(1);
+
+  for (i = 0; i < plan->octaves; ++i)
+  {
+    float (*m)[3] = plan->transform[i];
+    noise_simplex_2_vec2(m[0][0] * x + m[0][1] * y, m[1][0] * x + m[1][1] * y, 1.0f, v);
+    out[0] += plan->amplitude[i] * v[0];
+    out[1] += plan->amplitude[i] * v[1];
+  }
+}
+
+NOISE_API NOISE_INLINE float noise_simplex_2_domain_warp_fbm_plan(noise_fbm_plan *plan, float x, float y, float amplitude)
+{
+  float warp[2];
+
+  noise_simplex_2_vec2_fbm_plan(plan, x + 5.2f, y + 1.3f, warp);
+
+  return noise_simplex_2_fbm_plan(plan, x + warp[0] * amplitude, y + warp[1] * amplitude);
+}
+
+/* #############################################################################
+ * # Batch sampling functions
+ * #############################################################################
+ *
+ * Structure-of-arrays sampling of arbitrary point sets (mesh vertices, particles, ...).
+ * Points are processed in blocks of NOISE_BATCH_BLOCK; fBm variants run octave-major
+ * inside a block so the per-octave state stays in registers/L1 and the inner loops
+ * are tight loops over contiguous memory. The last (partial) block handles the tail.
+ *
+ * Results are identical to calling the per-sample function for every point.
+ */
+#define NOISE_BATCH_BLOCK 64
+
+typedef float (*noise_2_function)(float x, float y, float frequency);
+typedef float (*noise_3_function)(float x, float y, float z, float frequency);
+
+/* rotation may be 0 to sample the plain (frequency scaled) fBm */
+NOISE_API NOISE_INLINE void noise_batch_2_fbm(
+    noise_2_function noise,
+    float *x, float *y, float *out, int count,
+    float frequency, int octaves, float lacunarity, float gain,
+    float rotation[2][2])
+{
+  float px[NOISE_BATCH_BLOCK], py[NOISE_BATCH_BLOCK], sum[NOISE_BATCH_BLOCK];
+  int start, n, i, o;
+
+  NOISE_PROFILE_BEGIN(NOISE_PROFILE_API_BATCH);
+
+  for (start = 0; start < count; start += NOISE_BATCH_BLOCK)
+  {
+    float amp = 1.0f, norm = 0.0f, f = frequency;
+
+    n = count - start < NOISE_BATCH_BLOCK ? count - start : NOISE_BATCH_BLOCK;
+
+    for (i = 0; i < n; ++i)
+    {
+      px[i] = rotation ? x[start + i] * frequency : x[start + i];
+      py[i] = rotation ? y[start + i] * frequency : y[start + i];
+      sum[i] = 0.0f;
+    }
+
+    NOISE_PROFILE_SAMPLES(n);
+
+    for (o = 0; o < octaves; ++o)
+    {
+      if (rotation)
+      {
+        float r00 = rotation[0][0], r01 = rotation[0][1];
+        float r10 = rotation[1][0], r11 = rotation[1][1];
+
+        for (i = 0; i < n; ++i)
+        {
+          float tx, ty;
+
+          sum[i] += amp * noise(px[i], py[i], 1.0f);
+
+          /* rotate then scale */
+          tx = r00 * px[i] + r01 * py[i];
+          ty = r10 * px[i] + r11 * py[i];
+          px[i] = tx * lacunarity;
+          py[i] = ty * lacunarity;
+        }
+      }
+      else
+      {
+        for (i = 0; i < n; ++i)
+        {
+          sum[i] += amp * noise(px[i], py[i], f);
+        }
+      }
+
+      norm += amp;
+      f *= lacunarity;
+      amp *= gain;
+    }
+
+    for (i = 0; i < n; ++i)
+    {
+      out[start + i] = sum[i] / norm;
+    }
+  }
+
+  NOISE_PROFILE_END(NOISE_PROFILE_API_BATCH);
+}
+
+/* rotation may be 0 to sample the plain (frequency scaled) fBm */
+NOISE_API NOISE_INLINE void noise_batch_3_fbm(
+    noise_3_function noise,
+    float *x, float *y, float *z, float *out, int count,
+    float frequency, int octaves, float lacunarity, float gain,
+    float rotation[3][3])
+{
+  float px[NOISE_BATCH_BLOCK], py[NOISE_BATCH_BLOCK], pz[NOISE_BATCH_BLOCK], sum[NOISE_BATCH_BLOCK];
+  int start, n, i, o;
+
+  NOISE_PROFILE_BEGIN(NOISE_PROFILE_API_BATCH);
+
+  for (start = 0; start < count; start += NOISE_BATCH_BLOCK)
+  {
+    float amp = 1.0f, norm = 0.0f, f = frequency;
+
+    n = count - start < NOISE_BATCH_BLOCK ? count - start : NOISE_BATCH_BLOCK;
+
+    for (i = 0; i < n; ++i)
+    {
+      px[i] = rotation ? x[start + i] * frequency : x[start + i];
+      py[i] = rotation ? y[start + i] * frequency : y[start + i];
+      pz[i] = rotation ? z[start + i] * frequency : z[start + i];
+      sum[i] = 0.0f;
+    }
+
+    NOISE_PROFILE_SAMPLES(n);
+
+    for (o = 0; o < octaves; ++o)
+    {
+      if (rotation)
+      {
+        for (i = 0; i < n; ++i)
+        {
+          float tx, ty, tz;
+
+          sum[i] += amp * noise(px[i], py[i], pz[i], 1.0f);
+
+          /* rotate then scale */
+          tx = rotation[0][0] * px[i] + rotation[0][1] * py[i] + rotation[0][2] * pz[i];
+          ty = rotation[1][0] * px[i] + rotation[1][1] * py[i] + rotation[1][2] * pz[i];
+          tz = rotation[2][0] * px[i] + rotation[2][1] * py[i] + rotation[2][2] * pz[i];
+          px[i] = tx * lacunarity;
+          py[i] = ty * lacunarity;
+          pz[i] = tz * lacunarity;
+        }
+      }
+      else
+      {
+        for (i = 0; i < n; ++i)
+        {
+          sum[i] += amp * noise(px[i], py[i], pz[i], f);
+        }
+      }
+
+      norm += amp;
+      f *= lacunarity;
+      amp *= gain;
+    }
+
+    for (i = 0; i < n; ++i)
+    {
+      out[start + i] = sum[i] / norm;
+    }
+  }
+
+  NOISE_PROFILE_END(NOISE_PROFILE_API_BATCH);
+}
+
+/* single-sample batches run the same block kernels with one octave; amplitude and norm
+ * are both 1, so the results equal the per-sample function exactly */
+NOISE_API NOISE_INLINE void noise_batch_2(noise_2_function noise, float *x, float *y, float *out, int count, float frequency)
+{
+  noise_batch_2_fbm(noise, x, y, out, count, frequency, 1, 1.0f, 1.0f, 0);
+}
+
+NOISE_API NOISE_INLINE void noise_batch_3(noise_3_function noise, float *x, float *y, float *z, float *out, int count, float frequency)
+{
+  noise_batch_3_fbm(noise, x, y, z, out, count, frequency, 1, 1.0f, 1.0f, 0);
+}
+
+/* Perlin */
+NOISE_API NOISE_INLINE void noise_perlin_2_batch(float *x, float *y, float *out, int count, float frequency)
+{
+  noise_batch_2(noise_perlin_2, x, y, out, count, frequency);
+}
+
+NOISE_API NOISE_INLINE void noise_perlin_3_batch(float *x, float *y, float *z, float *out, int count, float frequency)
+{
+  noise_batch_3(noise_perlin_3, x, y, z, out, count, frequency);
+}
+
+NOISE_API NOISE_INLINE void noise_perlin_2_fbm_batch(float *x, float *y, float *out, int count, float frequency, int octaves, float lacunarity, float gain)
+{
+  noise_batch_2_fbm(noise_perlin_2, x, y, out, count, frequency, octaves, lacunarity, gain, 0);
+}
+
+NOISE_API NOISE_INLINE void noise_perlin_2_fbm_rotation_batch(float *x, float *y, float *out, int count, float frequency, int octaves, float lacunarity, float gain, float rotation[2][2])
+{
+  noise_batch_2_fbm(noise_perlin_2, x, y, out, count, frequency, octaves, lacunarity, gain, rotation);
+}
+
+NOISE_API NOISE_INLINE void noise_perlin_3_fbm_batch(float *x, float *y, float *z, float *out, int count, float frequency, int octaves, float lacunarity, float gain)
+{
+  noise_batch_3_fbm(noise_perlin_3, x, y, z, out, count, frequency, octaves, lacunarity, gain, 0);
+}
+
+NOISE_API NOISE_INLINE void noise_perlin_3_fbm_rotation_batch(float *x, float *y, float *z, float *out, int count, float frequency, int octaves, float lacunarity, float gain, float rotation[3][3])
+{
+  noise_batch_3_fbm(noise_perlin_3, x, y, z, out, count, frequency, octaves, lacunarity, gain, rotation);
+}
+
+/* Simplex */
+NOISE_API NOISE_INLINE void noise_simplex_2_batch(float *x, float *y, float *out, int count, float frequency)
+{
+  noise_batch_2(noise_simplex_2, x, y, out, count, frequency);
+}
+
+NOISE_API NOISE_INLINE void noise_simplex_3_batch(float *x, float *y, float *z, float *out, int count, float frequency)
+{
+  noise_batch_3(noise_simplex_3, x, y, z, out, count, frequency);
+}
+
+NOISE_API NOISE_INLINE void noise_simplex_2_fbm_batch(float *x, float *y, float *out, int count, float frequency, int octaves, float lacunarity, float gain)
+{
+  noise_batch_2_fbm(noise_simplex_2, x, y, out, count, frequency, octaves, lacunarity, gain, 0);
+}
+
+NOISE_API NOISE_INLINE void noise_simplex_2_fbm_rotation_batch(float *x, float *y, float *out, int count, float frequency, int octaves, float lacunarity, float gain, float rotation[2][2])
+{
+  noise_batch_2_fbm(noise_simplex_2, x, y, out, count, frequency, octaves, lacunarity, gain, rotation);
+}
+
+NOISE_API NOISE_INLINE void noise_simplex_3_fbm_batch(float *x, float *y, float *z, float *out, int count, float frequency, int octaves, float lacunarity, float gain)
+{
+  noise_batch_3_fbm(noise_simplex_3, x, y, z, out, count, frequency, octaves, lacunarity, gain, 0);
+}
+
+NOISE_API NOISE_INLINE void noise_simplex_3_fbm_rotation_batch(float *x, float *y, float *z, float *out, int count, float frequency, int octaves, float lacunarity, float gain, float rotation[3][3])
+{
+  noise_batch_3_fbm(noise_simplex_3, x, y, z, out, count, frequency, octaves, lacunarity, gain, rotation);
+}
+
+/* normalized vector-valued fBm (noise_simplex_2_vec2_fbm) of a block of at most NOISE_BATCH_BLOCK points */
+NOISE_API NOISE_INLINE void noise_simplex_2_vec2_fbm_batch_block(
+    float *x, float *y, float *out_x, float *out_y, int n,
+    float frequency, int octaves, float lacunarity, float gain,
+    float rotation[2][2])
+{
+  float px[NOISE_BATCH_BLOCK], py[NOISE_BATCH_BLOCK];
+  float wx[NOISE_BATCH_BLOCK], wy[NOISE_BATCH_BLOCK];
+  float amp = 1.0f, norm = 0.0f, f = frequency;
+  int i, o;
+
+  for (i = 0; i < n; ++i)
+  {
+    px[i] = rotation ? x[i] * frequency : x[i];
+    py[i] = rotation ? y[i] * frequency : y[i];
+    wx[i] = 0.0f;
+    wy[i] = 0.0f;
+  }
+
+  NOISE_PROFILE_SAMPLES(n);
+
+  for (o = 0; o < octaves; ++o)
+  {
+    for (i = 0; i < n; ++i)
+    {
+      float v[2];
+
+      noise_simplex_2_vec2(px[i], py[i], rotation ? 1.0f : f, v);
+      wx[i] += amp * v[0];
+      wy[i] += amp * v[1];
+
+      if (rotation)
+      {
+        /* rotate then scale */
+        float tx = rotation[0][0] * px[i] + rotation[0][1] * py[i];
+        float ty = rotation[1][0] * px[i] + rotation[1][1] * py[i];
+        px[i] = tx * lacunarity;
+        py[i] = ty * lacunarity;
+      }
+    }
+
+    norm += amp;
+    f *= lacunarity;
+    amp *= gain;
+  }
+
+  for (i = 0; i < n; ++i)
+  {
+    out_x[i] = wx[i] / norm;
+    out_y[i] = wy[i] / norm;
+  }
+}
+
+NOISE_API NOISE_INLINE void noise_simplex_2_vec2_fbm_batch(float *x, float *y, float *out_x, float *out_y, int count, float frequency, int octaves, float lacunarity, float gain)
+{
+  int start;
+
+  for (start = 0; start < count; start += NOISE_BATCH_BLOCK)
+  {
+    int n = count - start < NOISE_BATCH_BLOCK ? count - start : NOISE_BATCH_BLOCK;
+    noise_simplex_2_vec2_fbm_batch_block(x + start, y + start, out_x + start, out_y + start, n, frequency, octaves, lacunarity, gain, 0);
+  }
+}
+
+NOISE_API NOISE_INLINE void noise_simplex_2_vec2_fbm_rotation_batch(float *x, float *y, float *out_x, float *out_y, int count, float frequency, int octaves, float lacunarity, float gain, float rotation[2][2])
+{
+  int start;
+
+  for (start = 0; start < count; start += NOISE_BATCH_BLOCK)
+  {
+    int n = count - start < NOISE_BATCH_BLOCK ? count - start : NOISE_BATCH_BLOCK;
+    noise_simplex_2_vec2_fbm_batch_block(x + start, y + start, out_x + start, out_y + start, n, frequency, octaves, lacunarity, gain, rotation);
+  }
+}
+
+/* warps a block of points by a vector-valued fBm offset field and samples the final fBm at the warped points */
+NOISE_API NOISE_INLINE void noise_simplex_2_domain_warp_batch_block(
+    float *x, float *y, float *out, int n,
+    float frequency, int octaves, float lacunarity, float gain,
+    float amplitude,
+    float rotation[2][2])
+{
+  float px[NOISE_BATCH_BLOCK], py[NOISE_BATCH_BLOCK];
+  float wx[NOISE_BATCH_BLOCK], wy[NOISE_BATCH_BLOCK];
+  int i;
+
+  for (i = 0; i < n; ++i)
+  {
+    px[i] = x[i] + 5.2f;
+    py[i] = y[i] + 1.3f;
+  }
+
+  noise_simplex_2_vec2_fbm_batch_block(px, py, wx, wy, n, frequency, octaves, lacunarity, gain, rotation);
+
+  for (i = 0; i < n; ++i)
+  {
+    px[i] = x[i] + wx[i] * amplitude;
+    py[i] = y[i] + wy[i] * amplitude;
+  }
+  noise_batch_2_fbm(noise_simplex_2, px, py, out, n, frequency, octaves, lacunarity, gain, rotation);
+}
+
+NOISE_API NOISE_INLINE void noise_simplex_2_domain_warp_batch(float *x, float *y, float *out, int count, float frequency, float amplitude)
+{
+  int start;
+
+  for (start = 0; start < count; start += NOISE_BATCH_BLOCK)
+  {
+    int n = count - start < NOISE_BATCH_BLOCK ? count - start : NOISE_BATCH_BLOCK;
+    noise_simplex_2_domain_warp_batch_block(x + start, y + start, out + start, n, frequency, 1, 1.0f, 1.0f, amplitude, 0);
+  }
+}
+
+NOISE_API NOISE_INLINE void noise_simplex_2_domain_warp_fbm_batch(float *x, float *y, float *out, int count, float frequency, int octaves, float lacunarity, float gain, float amplitude)
+{
+  int start;
+
+  for (start = 0; start < count; start += NOISE_BATCH_BLOCK)
+  {
+    int n = count - start < NOISE_BATCH_BLOCK ? count - start : NOISE_BATCH_BLOCK;
+    noise_simplex_2_domain_warp_batch_block(x + start, y + start, out + start, n, frequency, octaves, lacunarity, gain, amplitude, 0);
+  }
+}
+
+NOISE_API NOISE_INLINE void noise_simplex_2_domain_warp_fbm_rotation_batch(float *x, float *y, float *out, int count, float frequency, int octaves, float lacunarity, float gain, float amplitude, float rotation[2][2])
+{
+  int start;
+
+  for (start = 0; start < count; start += NOISE_BATCH_BLOCK)
+  {
+    int n = count - start < NOISE_BATCH_BLOCK ? count - start : NOISE_BATCH_BLOCK;
+    noise_simplex_2_domain_warp_batch_block(x + start, y + start, out + start, n, frequency, octaves, lacunarity, gain, amplitude, rotation);
+  }
+}
+
+/* Value */
+NOISE_API NOISE_INLINE void noise_value_2_batch(float *x, float *y, float *out, int count, float frequency)
+{
+  noise_batch_2(noise_value_2, x, y, out, count, frequency);
+}
+
+NOISE_API NOISE_INLINE void noise_value_2_fbm_batch(float *x, float *y, float *out, int count, float frequency, int octaves, float lacunarity, float gain)
+{
+  noise_batch_2_fbm(noise_value_2, x, y, out, count, frequency, octaves, lacunarity, gain, 0);
+}
+
+NOISE_API NOISE_INLINE void noise_value_2_fbm_rotation_batch(float *x, float *y, float *out, int count, float frequency, int octaves, float lacunarity, float gain, float rotation[2][2])
+{
+  noise_batch_2_fbm(noise_value_2, x, y, out, count, frequency, octaves, lacunarity, gain, rotation);
+}
+
+/* #############################################################################
+ * # Tile fBm functions
+ * #############################################################################
+ *
+ * Octave-major fBm over a whole width * height tile laid out as tile[y * width + x].
+ * Pixel (x, y) is sampled at (origin_x + x * spacing, origin_y + y * spacing).
+ *
+ * Octave 0 is written for the whole tile, then every further octave is accumulated on
+ * top of it. Each octave's plan transform is folded with the tile origin and spacing
+ * once per tile, so the per-pixel work is one multiply-add per axis plus the noise sample.
+ */
+NOISE_API NOISE_INLINE void noise_tile_2_fbm_plan(
+    noise_2_function noise,
+    float *tile, int width, int height,
+    float origin_x, float origin_y, float spacing,
+    noise_fbm_plan *plan)
+{
+  int x, y, o;
+
+  NOISE_PROFILE_BEGIN(NOISE_PROFILE_API_TILE);
+
+  NOISE_PROFILE_SAMPLES(width * height);
+
+  for (o = 0; o < plan->octaves; ++o)
+  {
+    /* affine map of this octave: p = base + x * dx + y * dy */
+    float (*m)[3] = plan->transform[o];
+    float amp = plan->amplitude[o];
+    float base_x = m[0][0] * origin_x + m[0][1] * origin_y;
+    float base_y = m[1][0] * origin_x + m[1][1] * origin_y;
+    float dx_x = m[0][0] * spacing, dx_y = m[1][0] * spacing;
+    float dy_x = m[0][1] * spacing, dy_y = m[1][1] * spacing;
+
+    for (y = 0; y < height; ++y)
+    {
+      float *row = tile + y * width;
+      float row_x = base_x + (float)y * dy_x;
+      float row_y = base_y + (float)y * dy_y;
+
+      if (o == 0)
+      {
+        for (x = 0; x < width; ++x)
+        {
+          row[x] = amp * noise(row_x + (float)x * dx_x, row_y + (float)x * dx_y, 1.0f);
+        }
+      }
+      else
+      {
+        for (x = 0; x < width; ++x)
+        {
+          row[x] += amp * noise(row_x + (float)x * dx_x, row_y + (float)x * dx_y, 1.0f);
+        }
+      }
+    }
+  }
+
+  NOISE_PROFILE_END(NOISE_PROFILE_API_TILE);
+}
+
+/* rotation may be 0 to sample the plain (frequency scaled) fBm, returns 0 (tile untouched)
+ * if the octave count does not fit a plan */
+NOISE_API NOISE_INLINE int noise_tile_2_fbm(
+    noise_2_function noise,
+    float *tile, int width, int height,
+    float origin_x, float origin_y, float spacing,
+    float frequency, int octaves, float lacunarity, float gain,
+    float rotation[2][2])
+{
+  noise_fbm_plan plan;
+
+  if (!noise_fbm_plan_2(&plan, frequency, octaves, lacunarity, gain, rotation))
+  {
+    return 0;
+  }
+
+  noise_tile_2_fbm_plan(noise, tile, width, height, origin_x, origin_y, spacing, &plan);
+
+  return 1;
+}
+
+NOISE_API NOISE_INLINE int noise_perlin_2_fbm_tile(float *tile, int width, int height, float origin_x, float origin_y, float spacing, float frequency, int octaves, float lacunarity, float gain, float rotation[2][2])
+{
+  return noise_tile_2_fbm(noise_perlin_2, tile, width, height, origin_x, origin_y, spacing, frequency, octaves, lacunarity, gain, rotation);
+}
+
+NOISE_API NOISE_INLINE int noise_simplex_2_fbm_tile(float *tile, int width, int height, float origin_x, float origin_y, float spacing, float frequency, int octaves, float lacunarity, float gain, float rotation[2][2])
+{
+  return noise_tile_2_fbm(noise_simplex_2, tile, width, height, origin_x, origin_y, spacing, frequency, octaves, lacunarity, gain, rotation);
+}
+
+NOISE_API NOISE_INLINE int noise_value_2_fbm_tile(float *tile, int width, int height, float origin_x, float origin_y, float spacing, float frequency, int octaves, float lacunarity, float gain, float rotation[2][2])
+{
+  return noise_tile_2_fbm(noise_value_2, tile, width, height, origin_x, origin_y, spacing, frequency, octaves, lacunarity, gain, rotation);
+}
+
+/* #############################################################################
+ * # Volume generation functions
+ * #############################################################################
+ */
+
+/* returns the next sampled lattice index after i (the last index is always sampled) */
+NOISE_API NOISE_INLINE int noise_volume_next(int i, int n, int step)
+{
+  if (i + step < n)
+  {
+    return i + step;
+  }
+
+  return (i == n - 1) ? n : n - 1;
+}
+
+/* lattice indices enclosing i and the interpolation weight between them */
+NOISE_API NOISE_INLINE void noise_volume_lattice(int i, int n, int step, int *i0, int *i1, float *t)
+{
+  *i0 = (i / step) * step;
+  *i1 = (*i0 + step < n) ? *i0 + step : n - 1;
+  *t = (*i1 > *i0) ? (float)(i - *i0) / (float)(*i1 - *i0) : 0.0f;
+}
+
+/* octave-major plan fBm of a block of n points sharing the row coordinates y and z */
+NOISE_API NOISE_INLINE void noise_volume_3_block(noise_fbm_plan *plan, noise_3_function noise, float *px, int n, float y, float z, float *acc)
+{
+  int i, o;
+
+  for (i = 0; i < n; ++i)
+  {
+    acc[i] = 0.0f;
+  }
+
+  NOISE_PROFILE_SAMPLES(n);
+
+  for (o = 0; o < plan->octaves; ++o)
+  {
+    float (*m)[3] = plan->transform[o];
+    float amp = plan->amplitude[o];
+    float bx = m[0][1] * y + m[0][2] * z;
+    float by = m[1][1] * y + m[1][2] * z;
+    float bz = m[2][1] * y + m[2][2] * z;
+
+    for (i = 0; i < n; ++i)
+    {
+      acc[i] += amp * noise(m[0][0] * px[i] + bx, m[1][0] * px[i] + by, m[2][0] * px[i] + bz, 1.0f);
+    }
+  }
+}
+
+/* Fills a width * height * depth volume laid out as volume[(z * height + y) * width + x].
+ *
+ * Voxel (x, y, z) is sampled at (origin_x + x * spacing, origin_y + y * spacing, origin_z + z * spacing).
+ *
+ * step_x, step_y, step_z select how densely each axis is sampled: 1 evaluates every voxel,
+ * 2/4/8 evaluate only every n-th voxel (and the last one) and trilinearly upsample the rest.
+ * The sampled voxels of each row are gathered into blocks of NOISE_BATCH_BLOCK and run
+ * octave-major through one fBm plan. The upsampling runs in place as three separable
+ * passes over contiguous rows and slices, so no scratch memory is needed.
+ *
+ * rotation may be 0, returns 0 (volume untouched) if the octave count does not fit a plan.
+ */
+NOISE_API NOISE_INLINE int noise_volume_3_fbm(
+    float *volume, int width, int height, int depth,
+    float origin_x, float origin_y, float origin_z,
+    float spacing,
+    int step_x, int step_y, int step_z,
+    noise_3_function noise,
+    float frequency,
+    int octaves,
+    float lacunarity,
+    float gain,
+    float rotation[3][3])
+{
+  noise_fbm_plan plan;
+  float px[NOISE_BATCH_BLOCK], acc[NOISE_BATCH_BLOCK];
+  int xi[NOISE_BATCH_BLOCK];
+  int x, y, z, x0, x1, y0, y1, z0, z1, i, n;
+  int slice = width * height;
+  float t;
+
+  if (!noise_fbm_plan_3(&plan, frequency, octaves, lacunarity, gain, rotation))
+  {
+    return 0;
+  }
+
+  NOISE_PROFILE_BEGIN(NOISE_PROFILE_API_VOLUME);
+
+  if (step_x < 1)
+  {
+    step_x = 1;
+  }
+  if (step_y < 1)
+  {
+    step_y = 1;
+  }
+  if (step_z < 1)
+  {
+    step_z = 1;
+  }
+
+  /* sample the coarse lattice */
+  for (z = 0; z < depth; z = noise_volume_next(z, depth, step_z))
+  {
+    float pz = origin_z + (float)z * spacing;
+
+    for (y = 0; y < height; y = noise_volume_next(y, height, step_y))
+    {
+      float py = origin_y + (float)y * spacing;
+      float *row = volume + z * slice + y * width;
+
+      for (x = 0; x < width;)
+      {
+        for (n = 0; x < width && n < NOISE_BATCH_BLOCK; x = noise_volume_next(x, width, step_x))
+        {
+          xi[n] = x;
+          px[n++] = origin_x + (float)x * spacing;
+        }
+
+        noise_volume_3_block(&plan, noise, px, n, py, pz, acc);
+
+        for (i = 0; i < n; ++i)
+        {
+          row[xi[i]] = acc[i];
+        }
+      }
+    }
+  }
+
+  /* upsample along x inside the sampled rows */
+  if (step_x > 1)
+  {
+    for (z = 0; z < depth; z = noise_volume_next(z, depth, step_z))
+    {
+      for (y = 0; y < height; y = noise_volume_next(y, height, step_y))
+      {
+        float *row = volume + z * slice + y * width;
+
+        for (x = 0; x < width; ++x)
+        {
+          noise_volume_lattice(x, width, step_x, &x0, &x1, &t);
+
+          if (x != x0 && x != x1)
+          {
+            row[x] = noise_lerp(row[x0], row[x1], t);
+          }
+        }
+      }
+    }
+  }
+
+  /* upsample along y: whole rows between two sampled rows */
+  if (step_y > 1)
+  {
+    for (z = 0; z < depth; z = noise_volume_next(z, depth, step_z))
+    {
+      for (y = 0; y < height; ++y)
+      {
+        float *row, *a, *b;
+
+        noise_volume_lattice(y, height, step_y, &y0, &y1, &t);
+
+        if (y == y0 || y == y1)
+        {
+          continue;
+        }
+
+        row = volume + z * slice + y * width;
+        a = volume + z * slice + y0 * width;
+        b = volume + z * slice + y1 * width;
+
+        for (x = 0; x < width; ++x)
+        {
+          row[x] = a[x] + t * (b[x] - a[x]);
+        }
+      }
+    }
+  }
+
+  /* upsample along z: whole slices between two sampled slices */
+  if (step_z > 1)
+  {
+    for (z = 0; z < depth; ++z)
+    {
+      float *dst, *a, *b;
+
+      noise_volume_lattice(z, depth, step_z, &z0, &z1, &t);
+
+      if (z == z0 || z == z1)
+      {
+        continue;
+      }
+
+      dst = volume + z * slice;
+      a = volume + z0 * slice;
+      b = volume + z1 * slice;
+
+      for (i = 0; i < slice; ++i)
+      {
+        dst[i] = a[i] + t * (b[i] - a[i]);
+      }
+    }
+  }
+
+  NOISE_PROFILE_END(NOISE_PROFILE_API_VOLUME);
+
+  return 1;
+}
+
+/* #############################################################################
+ * # Multi-channel sampling functions
+ * #############################################################################
+ *
+ * Evaluates several fBm layers (elevation, moisture, temperature, masks, ...) over the
+ * same tile in one pass. Each pixel's coordinates are computed once and shared by all
+ * channels, every channel runs octave-major over a block of NOISE_BATCH_BLOCK pixels
+ * with its plan built once per call, and each block is written out once.
+ *
+ * noise_channels_2 returns 0 and writes nothing if channel_count is outside
+ * [1, NOISE_CHANNELS_MAX] or a channel's octave count does not fit an fBm plan.
+ */
+#define NOISE_CHANNELS_MAX 16
+
+typedef enum noise_type
+{
+  NOISE_TYPE_PERLIN = 0,
+  NOISE_TYPE_SIMPLEX,
+  NOISE_TYPE_VALUE
+
+} noise_type;
+
+typedef struct noise_channel
+{
+  noise_type type;
+  float frequency;
+  int octaves;
+  float lacunarity;
+  float gain;
+  float offset_x; /* offsets decorrelate channels sharing the same seed */
+  float offset_y;
+  float (*rotation)[2]; /* optional 2x2 octave rotation, 0 for none */
+
+} noise_channel;
+
+NOISE_API NOISE_INLINE noise_2_function noise_function_2(noise_type type)
+{
+  switch (type)
+  {
+  case NOISE_TYPE_SIMPLEX:
+    return noise_simplex_2;
+  case NOISE_TYPE_VALUE:
+    return noise_value_2;
+  case NOISE_TYPE_PERLIN:
+  default:
+    return noise_perlin_2;
+  }
+}
+
+/* octave-major fBm of one channel over a block of n points sharing the row coordinate y */
+NOISE_API NOISE_INLINE void noise_channel_2_block(noise_fbm_plan *plan, noise_2_function noise, float *px, int n, float offset_x, float y, float *acc)
+{
+  int i, o;
+
+  for (i = 0; i < n; ++i)
+  {
+    acc[i] = 0.0f;
+  }
+
+  NOISE_PROFILE_SAMPLES(n);
+
+  for (o = 0; o < plan->octaves; ++o)
+  {
+    float (*m)[3] = plan->transform[o];
+    float amp = plan->amplitude[o];
+    float bx = m[0][1] * y, by = m[1][1] * y;
+
+    for (i = 0; i < n; ++i)
+    {
+      float cx = px[i] + offset_x;
+      acc[i] += amp * noise(m[0][0] * cx + bx, m[1][0] * cx + by, 1.0f);
+    }
+  }
+}
+
+/* Samples channel_count channels over a width * height tile where pixel (x, y) maps to
+ * (origin_x + x * spacing, origin_y + y * spacing).
+ *
+ * interleaved != 0: out[(y * width + x) * channel_count + c]
+ * interleaved == 0: out[c * width * height + y * width + x]
+ */
+NOISE_API NOISE_INLINE int noise_channels_2(
+    noise_channel *channels, int channel_count,
+    float *out, int width, int height,
+    float origin_x, float origin_y, float spacing,
+    int interleaved)
+{
+  noise_fbm_plan plans[NOISE_CHANNELS_MAX];
+  noise_2_function functions[NOISE_CHANNELS_MAX];
+  float px[NOISE_BATCH_BLOCK], acc[NOISE_BATCH_BLOCK];
+  int plane = width * height;
+  int c, x, y, i, n;
+
+  /* clamping would change the interleaved stride and leave channels unwritten */
+  if (channel_count < 1 || channel_count > NOISE_CHANNELS_MAX)
+  {
+    return 0;
+  }
+
+  for (c = 0; c < channel_count; ++c)
+  {
+    if (!noise_fbm_plan_2(&plans[c], channels[c].frequency, channels[c].octaves, channels[c].lacunarity, channels[c].gain, channels[c].rotation))
+    {
+      return 0;
+    }
+
+    functions[c] = noise_function_2(channels[c].type);
+  }
+
+  NOISE_PROFILE_BEGIN(NOISE_PROFILE_API_CHANNELS);
+
+  for (y = 0; y < height; ++y)
+  {
+    float py = origin_y + (float)y * spacing;
+
+    for (x = 0; x < width; x += NOISE_BATCH_BLOCK)
+    {
+      n = width - x < NOISE_BATCH_BLOCK ? width - x : NOISE_BATCH_BLOCK;
+
+      /* shared coordinates of this block */
+      for (i = 0; i < n; ++i)
+      {
+        px[i] = origin_x + (float)(x + i) * spacing;
+      }
+
+      for (c = 0; c < channel_count; ++c)
+      {
+        noise_channel_2_block(&plans[c], functions[c], px, n, channels[c].offset_x, py + channels[c].offset_y, acc);
+
+        if (interleaved)
+        {
+          float *dst = out + (y * width + x) * channel_count + c;
+
+          for (i = 0; i < n; ++i)
+          {
+            dst[i * channel_count] = acc[i];
+          }
+        }
+        else
+        {
+          float *dst = out + c * plane + y * width + x;
+
+          for (i = 0; i < n; ++i)
+          {
+            dst[i] = acc[i];
+          }
+        }
+      }
+    }
+  }
+
+  NOISE_PROFILE_END(NOISE_PROFILE_API_CHANNELS);
+
+  return 1;
+}
+
+/* #############################################################################
+ * # Curl noise functions
+ * #############################################################################
+ *
+ * Divergence-free velocity fields built from analytic simplex noise gradients.
+ * Every corner contributes n = t^4 * dot(g, d) with t = r - |d|^2, so its gradient is
+ * t^4 * g - 8 * t^3 * dot(g, d) * d and no finite differences are needed.
+ */
+NOISE_API NOISE_INLINE float noise_simplex_2_derivative(float x, float y, float frequency, float gradient[2])
+{
+  float s, t, xs, ys, value = 0.0f;
+  float cx[3], cy[3];
+  int cidx[3];
+  int i, j, ii, jj, i1, j1, k;
+
+  x *= frequency;
+  y *= frequency;
+
+  s = (x + y) * NOISE_SIMPLEX_F2;
+  xs = x + s;
+  ys = y + s;
+  i = (int)noise_floor(xs);
+  j = (int)noise_floor(ys);
+
+  t = (float)(i + j) * NOISE_SIMPLEX_G2;
+  cx[0] = x - (float)i + t;
+  cy[0] = y - (float)j + t;
+
+  i1 = cx[0] > cy[0] ? 1 : 0;
+  j1 = 1 - i1;
+
+  cx[1] = cx[0] - (float)i1 + NOISE_SIMPLEX_G2;
+  cy[1] = cy[0] - (float)j1 + NOISE_SIMPLEX_G2;
+  cx[2] = cx[0] - 1.0f + 2.0f * NOISE_SIMPLEX_G2;
+  cy[2] = cy[0] - 1.0f + 2.0f * NOISE_SIMPLEX_G2;
+
+  ii = i & 255;
+  jj = j & 255;
+
+  NOISE_PROFILE_OCTAVE(3);
+
+  cidx[0] = (int)noise_permutations[ii + noise_permutations[jj]];
+  cidx[1] = (int)noise_permutations[ii + i1 + noise_permutations[jj + j1]];
+  cidx[2] = (int)noise_permutations[ii + 1 + noise_permutations[jj + 1]];
+
+  gradient[0] = 0.0f;
+  gradient[1] = 0.0f;
+
+  for (k = 0; k < 3; ++k)
+  {
+    float *g = noise_gradient_2_lut[cidx[k] & 7];
+    float tk = 0.5f - cx[k] * cx[k] - cy[k] * cy[k];
+    float t2, t3, gd;
+
+    if (tk < 0.0f)
+    {
+      continue;
+    }
+
+    t2 = tk * tk;
+    t3 = t2 * tk;
+    gd = noise_dot2(g, cx[k], cy[k]);
+
+    value += t2 * t2 * gd;
+    gradient[0] += t2 * t2 * g[0] - 8.0f * t3 * gd * cx[k];
+    gradient[1] += t2 * t2 * g[1] - 8.0f * t3 * gd * cy[k];
+  }
+
+  /* chain rule for the frequency scaling of the input */
+  gradient[0] *= 70.0f * frequency;
+  gradient[1] *= 70.0f * frequency;
+
+  return 70.0f * value;
+}
+
+/* Up to three decorrelated 3D simplex potentials (gradient sets like noise_simplex_2_vec)
+ * with their analytic gradients from one lattice traversal.
+ */
+NOISE_API NOISE_INLINE void noise_simplex_3_vec_derivative(float x, float y, float z, float frequency, int channels, float *value, float gradient[][3])
+{
+  float s, t;
+  float cx[4], cy[4], cz[4];
+  int cidx[4];
+  int i, j, k, ii, jj, kk, i1, j1, k1, i2, j2, k2, c, n;
+
+  x *= frequency;
+  y *= frequency;
+  z *= frequency;
+
+  s = (x + y + z) * NOISE_SIMPLEX_F3;
+  i = (int)noise_floor(x + s);
+  j = (int)noise_floor(y + s);
+  k = (int)noise_floor(z + s);
+
+  t = (float)(i + j + k) * NOISE_SIMPLEX_G3;
+  cx[0] = x - (float)i + t;
+  cy[0] = y - (float)j + t;
+  cz[0] = z - (float)k + t;
+
+  /* Rank x0, y0, z0 to find simplex corner offsets (same ordering as noise_simplex_3) */
+  if (cx[0] >= cy[0])
+  {
+    i1 = (cy[0] >= cz[0] || cx[0] >= cz[0]) ? 1 : 0;
+    j1 = 0;
+    k1 = 1 - i1;
+    i2 = 1;
+    j2 = (cy[0] >= cz[0]) ? 1 : 0;
+    k2 = 1 - j2;
+  }
+  else
+  {
+    i1 = 0;
+    j1 = (cy[0] < cz[0]) ? 0 : 1;
+    k1 = 1 - j1;
+    i2 = (cy[0] < cz[0] || cx[0] < cz[0]) ? 0 : 1;
+    j2 = 1;
+    k2 = 1 - i2;
+  }
+
+  cx[1] = cx[0] - (float)i1 + NOISE_SIMPLEX_G3;
+  cy[1] = cy[0] - (float)j1 + NOISE_SIMPLEX_G3;
+  cz[1] = cz[0] - (float)k1 + NOISE_SIMPLEX_G3;
+  cx[2] = cx[0] - (float)i2 + 2.0f * NOISE_SIMPLEX_G3;
+  cy[2] = cy[0] - (float)j2 + 2.0f * NOISE_SIMPLEX_G3;
+  cz[2] = cz[0] - (float)k2 + 2.0f * NOISE_SIMPLEX_G3;
+  cx[3] = cx[0] - 1.0f + 3.0f * NOISE_SIMPLEX_G3;
+  cy[3] = cy[0] - 1.0f + 3.0f * NOISE_SIMPLEX_G3;
+  cz[3] = cz[0] - 1.0f + 3.0f * NOISE_SIMPLEX_G3;
+
+  ii = i & 255;
+  jj = j & 255;
+  kk = k & 255;
+
+  NOISE_PROFILE_OCTAVE(4);
+
+  cidx[0] = (int)noise_permutations[ii + noise_permutations[jj + noise_permutations[kk]]];
+  cidx[1] = (int)noise_permutations[ii + i1 + noise_permutations[jj + j1 + noise_permutations[kk + k1]]];
+  cidx[2] = (int)noise_permutations[ii + i2 + noise_permutations[jj + j2 + noise_permutations[kk + k2]]];
+  cidx[3] = (int)noise_permutations[ii + 1 + noise_permutations[jj + 1 + noise_permutations[kk + 1]]];
+
+  for (c = 0; c < channels; ++c)
+  {
+    value[c] = 0.0f;
+    gradient[c][0] = 0.0f;
+    gradient[c][1] = 0.0f;
+    gradient[c][2] = 0.0f;
+  }
+
+  for (n = 0; n < 4; ++n)
+  {
+    float tn = 0.6f - cx[n] * cx[n] - cy[n] * cy[n] - cz[n] * cz[n];
+    float t2, t3;
+
+    if (tn < 0.0f)
+    {
+      continue;
+    }
+
+    t2 = tn * tn;
+    t3 = t2 * tn;
+
+    for (c = 0; c < channels; ++c)
+    {
+      int gi = c == 0 ? (cidx[n] & 15) : c == 1 ? ((cidx[n] >> 4) & 15) : (noise_permutations[cidx[n]] & 15);
+      float *g = noise_gradient_3_lut[gi];
+      float gd = noise_dot3(g, cx[n], cy[n], cz[n]);
+
+      value[c] += t2 * t2 * gd;
+      gradient[c][0] += t2 * t2 * g[0] - 8.0f * t3 * gd * cx[n];
+      gradient[c][1] += t2 * t2 * g[1] - 8.0f * t3 * gd * cy[n];
+      gradient[c][2] += t2 * t2 * g[2] - 8.0f * t3 * gd * cz[n];
+    }
+  }
+
+  for (c = 0; c < channels; ++c)
+  {
+    value[c] *= 32.0f;
+    gradient[c][0] *= 32.0f * frequency;
+    gradient[c][1] *= 32.0f * frequency;
+    gradient[c][2] *= 32.0f * frequency;
+  }
+}
+
+NOISE_API NOISE_INLINE float noise_simplex_3_derivative(float x, float y, float z, float frequency, float gradient[3])
+{
+  float value, g[1][3];
+
+  noise_simplex_3_vec_derivative(x, y, z, frequency, 1, &value, g);
+
+  gradient[0] = g[0][0];
+  gradient[1] = g[0][1];
+  gradient[2] = g[0][2];
+
+  return value;
+}
+
+/* curl of a scalar potential: (d/dy, -d/dx) */
+NOISE_API NOISE_INLINE void noise_curl_2(float x, float y, float frequency, float out[2])
+{
+  float g[2];
+
+  noise_simplex_2_derivative(x, y, frequency, g);
+
+  out[0] = g[1];
+  out[1] = -g[0];
+}
+
+/* curl of a vector potential made of three decorrelated simplex fields */
+NOISE_API NOISE_INLINE void noise_curl_3(float x, float y, float z, float frequency, float out[3])
+{
+  float value[3], g[3][3];
+
+  noise_simplex_3_vec_derivative(x, y, z, frequency, 3, value, g);
+
+  out[0] = g[2][1] - g[1][2];
+  out[1] = g[0][2] - g[2][0];
+  out[2] = g[1][0] - g[0][1];
+}
+
+/* Advances count particles (structure-of-arrays, updated in place) by one explicit
+ * Euler step of dt through a curl noise velocity field scaled by strength.
+ *
+ * z == 0 advects 2D particles through the curl of a 3D potential sliced at z = time,
+ * so the flow evolves over time while staying divergence-free in the plane.
+ * Otherwise 3D particles are advected and time scrolls the potential along z.
+ */
+NOISE_API NOISE_INLINE void noise_advect_particles(float *x, float *y, float *z, int count, float frequency, float strength, float dt, float time)
+{
+  float scale = strength * dt;
+  int i;
+
+  if (!z)
+  {
+    for (i = 0; i < count; ++i)
+    {
+      float g[3];
+
+      noise_simplex_3_derivative(x[i], y[i], time, frequency, g);
+
+      x[i] += g[1] * scale;
+      y[i] -= g[0] * scale;
+    }
+
+    return;
+  }
+
+  for (i = 0; i < count; ++i)
+  {
+    float v[3];
+
+    noise_curl_3(x[i], y[i], z[i] + time, frequency, v);
+
+    x[i] += v[0] * scale;
+    y[i] += v[1] * scale;
+    z[i] += v[2] * scale;
+  }
+}
+
+/* #############################################################################
+ * # Heightmap attribute functions
+ * #############################################################################
+ *
+ * Derives normals, slope, curvature and D8 flow direction from a row-major heightmap in
+ * one fused sweep: every texel's 3x3 neighbourhood is loaded once and all requested
+ * attributes are written from it. Only the non-zero output pointers are computed.
+ *
+ * Rows [row_begin, row_end) are processed, so disjoint row bands can run on separate
+ * threads; neighbours outside the map are clamped to the border.
+ */
+#define NOISE_FLOW_NONE 255
+
+typedef struct noise_heightmap_attributes
+{
+  float *normal;            /* 3 floats per texel, unit length */
+  unsigned char *normal_u8; /* 3 bytes per texel, unit normal mapped from [-1,1] to [0,255] */
+  float *slope;             /* gradient magnitude */
+  float *curvature;         /* laplacian, positive in valleys */
+  unsigned char *flow;      /* steepest downhill neighbour (0-7, erosion neighbour order) or NOISE_FLOW_NONE */
+
+} noise_heightmap_attributes;
+
+/* n[9] is the 3x3 neighbourhood in row-major order, i is the texel index */
+NOISE_API NOISE_INLINE void noise_heightmap_derive_texel(float n[9], float scale, noise_heightmap_attributes *out, int i)
+{
+  float gx = ((n[2] + 2.0f * n[5] + n[8]) - (n[0] + 2.0f * n[3] + n[6])) * 0.125f * scale;
+  float gy = ((n[6] + 2.0f * n[7] + n[8]) - (n[0] + 2.0f * n[1] + n[2])) * 0.125f * scale;
+  float g2 = gx * gx + gy * gy;
+
+  if (out->normal || out->normal_u8)
+  {
+    float r = noise_rsqrt(g2 + 1.0f);
+    float nx = -gx * r, ny = -gy * r, nz = r;
+
+    if (out->normal)
+    {
+      out->normal[i * 3 + 0] = nx;
+      out->normal[i * 3 + 1] = ny;
+      out->normal[i * 3 + 2] = nz;
+    }
+
+    if (out->normal_u8)
+    {
+      out->normal_u8[i * 3 + 0] = (unsigned char)((nx * 0.5f + 0.5f) * 255.0f + 0.5f);
+      out->normal_u8[i * 3 + 1] = (unsigned char)((ny * 0.5f + 0.5f) * 255.0f + 0.5f);
+      out->normal_u8[i * 3 + 2] = (unsigned char)((nz * 0.5f + 0.5f) * 255.0f + 0.5f);
+    }
+  }
+
+  if (out->slope)
+  {
+    out->slope[i] = noise_sqrt(g2);
+  }
+
+  if (out->curvature)
+  {
+    out->curvature[i] = (n[1] + n[3] + n[5] + n[7] - 4.0f * n[4]) * scale;
+  }
+
+  if (out->flow)
+  {
+    /* neighbour order of noise_erosion_thermal, diagonals weighted by 1/sqrt(2) */
+    static int map[8] = {0, 1, 2, 3, 5, 6, 7, 8};
+    float dmax = 0.0f;
+    int k, imax = NOISE_FLOW_NONE;
+
+    for (k = 0; k < 8; ++k)
+    {
+      float drop = n[4] - n[map[k]];
+
+      if (k == 0 || k == 2 || k == 5 || k == 7)
+      {
+        drop *= 0.70710678f;
+      }
+
+      if (drop > dmax)
+      {
+        dmax = drop;
+        imax = k;
+      }
+    }
+
+    out->flow[i] = (unsigned char)imax;
+  }
+}
+
+/* scale converts height differences per texel into slope units (height scale / texel size) */
+NOISE_API NOISE_INLINE void noise_heightmap_derive(
+    float *heightmap, int width, int height,
+    float scale,
+    int row_begin, int row_end,
+    noise_heightmap_attributes *out)
+{
+  float n[9];
+  int x, y;
+
+  NOISE_PROFILE_BEGIN(NOISE_PROFILE_API_HEIGHTMAP_DERIVE);
+
+  if (row_begin < 0)
+  {
+    row_begin = 0;
+  }
+
+  if (row_end > height)
+  {
+    row_end = height;
+  }
+
+  for (y = row_begin; y < row_end; ++y)
+  {
+    float *up = heightmap + (y > 0 ? y - 1 : 0) * width;
+    float *mid = heightmap + y * width;
+    float *down = heightmap + (y < height - 1 ? y + 1 : y) * width;
+
+    for (x = 0; x < width; ++x)
+    {
+      int l = x > 0 ? x - 1 : 0;
+      int r = x < width - 1 ? x + 1 : x;
+
+      n[0] = up[l];
+      n[1] = up[x];
+      n[2] = up[r];
+      n[3] = mid[l];
+      n[4] = mid[x];
+      n[5] = mid[r];
+      n[6] = down[l];
+      n[7] = down[x];
+      n[8] = down[r];
+
+      noise_heightmap_derive_texel(n, scale, out, y * width + x);
+    }
+  }
+
+  NOISE_PROFILE_END(NOISE_PROFILE_API_HEIGHTMAP_DERIVE);
+}
+
+/* #############################################################################
+ * # Quantized output functions
+ * #############################################################################
+ *
+ * Writes noise layers and heightmaps straight into 8-bit, 16-bit or half-float buffers.
+ * Min/max/mean are gathered while the values are produced, so no separate normalization
+ * pass over a float buffer is needed.
+ *
+ * A fixed range [lo, hi] maps linearly onto [0, 255] or [0, 65535] with clamping.
+ * Passing lo >= hi selects auto-ranging onto the data's own [min, max], in any units
+ * (eroded heightmaps leave [-1, 1]): buffers are scanned for their range first and
+ * quantized once against it, channels are generated once to find the range and once
+ * more to write. Half floats keep the values as they are and ignore the range.
+ */
+typedef enum noise_quantize_kind
+{
+  NOISE_QUANTIZE_U8 = 0,
+  NOISE_QUANTIZE_U16,
+  NOISE_QUANTIZE_HALF
+
+} noise_quantize_kind;
+
+typedef struct noise_stats
+{
+  float min;
+  float max;
+  float mean;
+
+} noise_stats;
+
+NOISE_API NOISE_INLINE unsigned short noise_float_to_half(float f)
+{
+  union
+  {
+    float f;
+    unsigned int i;
+  } u;
+  unsigned int sign, mantissa;
+  int exponent;
+
+  u.f = f;
+  sign = (u.i >> 16) & 0x8000u;
+  exponent = (int)((u.i >> 23) & 0xffu) - 127 + 15;
+  mantissa = u.i & 0x7fffffu;
+
+  if (exponent >= 31)
+  {
+    /* overflow to infinity, keep NaN a NaN */
+    return (unsigned short)(sign | 0x7c00u | ((((u.i >> 23) & 0xffu) == 0xffu && mantissa) ? 0x200u : 0u));
+  }
+
+  if (exponent <= 0)
+  {
+    unsigned int shift;
+
+    if (exponent < -10)
+    {
+      return (unsigned short)sign; /* underflow to signed zero */
+    }
+
+    /* subnormal half */
+    mantissa |= 0x800000u;
+    shift = (unsigned int)(14 - exponent);
+
+    return (unsigned short)(sign | ((mantissa + (1u << (shift - 1))) >> shift));
+  }
+
+  /* round to nearest, a carry correctly bumps the exponent */
+  return (unsigned short)((sign | ((unsigned int)exponent << 10) | (mantissa >> 13)) + ((mantissa >> 12) & 1u));
+}
+
+NOISE_API NOISE_INLINE float noise_half_to_float(unsigned short h)
+{
+  union
+  {
+    float f;
+    unsigned int i;
+  } u;
+  unsigned int sign = ((unsigned int)h & 0x8000u) << 16;
+  unsigned int exponent = ((unsigned int)h >> 10) & 0x1fu;
+  unsigned int mantissa = (unsigned int)h & 0x3ffu;
+
+  if (exponent == 0)
+  {
+    /* zero or subnormal: mantissa * 2^-24 */
+    u.f = (float)mantissa * 5.9604645e-8f;
+    u.i |= sign;
+    return u.f;
+  }
+
+  if (exponent == 31)
+  {
+    u.i = sign | 0x7f800000u | (mantissa << 13);
+    return u.f;
+  }
+
+  u.i = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+  return u.f;
+}
+
+NOISE_API NOISE_INLINE void noise_stats_accumulate(float *src, int count, float *min, float *max, double *sum)
+{
+  float block_sum = 0.0f;
+  int i;
+
+  for (i = 0; i < count; ++i)
+  {
+    float v = src[i];
+    *min = v < *min ? v : *min;
+    *max = v > *max ? v : *max;
+    block_sum += v;
+  }
+
+  *sum += (double)block_sum;
+}
+
+NOISE_API NOISE_INLINE void noise_quantize_block_u8(float *src, int count, float lo, float scale, unsigned char *dst)
+{
+  int i;
+
+  for (i = 0; i < count; ++i)
+  {
+    float q = (src[i] - lo) * scale + 0.5f;
+    q = q < 0.0f ? 0.0f : (q > 255.0f ? 255.0f : q);
+    dst[i] = (unsigned char)q;
+  }
+}
+
+NOISE_API NOISE_INLINE void noise_quantize_block_u16(float *src, int count, float lo, float scale, unsigned short *dst)
+{
+  int i;
+
+  for (i = 0; i < count; ++i)
+  {
+    float q = (src[i] - lo) * scale + 0.5f;
+    q = q < 0.0f ? 0.0f : (q > 65535.0f ? 65535.0f : q);
+    dst[i] = (unsigned short)q;
+  }
+}
+
+NOISE_API NOISE_INLINE void noise_quantize_block_half(float *src, int count, unsigned short *dst)
+{
+  int i;
+
+  for (i = 0; i < count; ++i)
+  {
+    dst[i] = noise_float_to_half(src[i]);
+  }
+}
+
+/* 0 for an auto range: the caller resolves it to the data's [min, max] first */
+NOISE_API NOISE_INLINE int noise_quantize_auto(noise_quantize_kind kind, float lo, float hi)
+{
+  return kind != NOISE_QUANTIZE_HALF && hi <= lo;
+}
+
+/* quantizes count values against the fixed range [lo, hi] (unused for half) */
+NOISE_API NOISE_INLINE void noise_quantize(float *src, int count, noise_quantize_kind kind, float lo, float hi, void *dst, int dst_offset)
+{
+  float levels = kind == NOISE_QUANTIZE_U8 ? 255.0f : 65535.0f;
+  float scale = (hi > lo) ? levels / (hi - lo) : 0.0f;
+
+  switch (kind)
+  {
+  case NOISE_QUANTIZE_U8:
+    noise_quantize_block_u8(src, count, lo, scale, (unsigned char *)dst + dst_offset);
+    break;
+  case NOISE_QUANTIZE_U16:
+    noise_quantize_block_u16(src, count, lo, scale, (unsigned short *)dst + dst_offset);
+    break;
+  case NOISE_QUANTIZE_HALF:
+  default:
+    noise_quantize_block_half(src, count, (unsigned short *)dst + dst_offset);
+    break;
+  }
+}
+
+NOISE_API NOISE_INLINE void noise_quantize_stats(noise_stats *stats, int count, float min, float max, double sum)
+{
+  if (stats)
+  {
+    stats->min = min;
+    stats->max = max;
+    stats->mean = count > 0 ? (float)(sum / (double)count) : 0.0f;
+  }
+}
+
+/* Quantizes an existing float buffer (e.g. an eroded heightmap); stats may be 0 */
+NOISE_API NOISE_INLINE void noise_quantize_buffer(float *src, int count, noise_quantize_kind kind, float lo, float hi, void *dst, noise_stats *stats)
+{
+  float min = 3.4e38f, max = -3.4e38f;
+  double sum = 0.0;
+  int i, n;
+
+  if (noise_quantize_auto(kind, lo, hi))
+  {
+    noise_stats_accumulate(src, count, &min, &max, &sum);
+    lo = min;
+    hi = max;
+    noise_quantize(src, count, kind, lo, hi, dst, 0);
+    noise_quantize_stats(stats, count, min, max, sum);
+    return;
+  }
+
+  /* fixed range: gather stats block by block while the block is hot */
+  for (i = 0; i < count; i += NOISE_BATCH_BLOCK)
+  {
+    n = count - i < NOISE_BATCH_BLOCK ? count - i : NOISE_BATCH_BLOCK;
+
+    if (stats)
+    {
+      noise_stats_accumulate(src + i, n, &min, &max, &sum);
+    }
+
+    noise_quantize(src + i, n, kind, lo, hi, dst, i);
+  }
+
+  noise_quantize_stats(stats, count, min, max, sum);
+}
+
+NOISE_API NOISE_INLINE void noise_quantize_u8(float *src, int count, float lo, float hi, unsigned char *dst, noise_stats *stats)
+{
+  noise_quantize_buffer(src, count, NOISE_QUANTIZE_U8, lo, hi, dst, stats);
+}
+
+NOISE_API NOISE_INLINE void noise_quantize_u16(float *src, int count, float lo, float hi, unsigned short *dst, noise_stats *stats)
+{
+  noise_quantize_buffer(src, count, NOISE_QUANTIZE_U16, lo, hi, dst, stats);
+}
+
+NOISE_API NOISE_INLINE void noise_quantize_half(float *src, int count, unsigned short *dst, noise_stats *stats)
+{
+  noise_quantize_buffer(src, count, NOISE_QUANTIZE_HALF, 0.0f, 0.0f, dst, stats);
+}
+
+/* generates one channel block by block into the quantized buffer dst[y * width + x];
+ * writes when write is set, gathers min/max/sum otherwise */
+NOISE_API NOISE_INLINE void noise_channel_2_quantize_pass(
+    noise_channel *channel, noise_fbm_plan *plan, noise_quantize_kind kind, void *dst, int width, int height,
+    float origin_x, float origin_y, float spacing,
+    float lo, float hi, float *min, float *max, double *sum, int write)
+{
+  noise_2_function noise = noise_function_2(channel->type);
+  float px[NOISE_BATCH_BLOCK], acc[NOISE_BATCH_BLOCK];
+  int x, y, i, n;
+
+  for (y = 0; y < height; ++y)
+  {
+    float py = origin_y + (float)y * spacing + channel->offset_y;
+
+    for (x = 0; x < width; x += NOISE_BATCH_BLOCK)
+    {
+      n = width - x < NOISE_BATCH_BLOCK ? width - x : NOISE_BATCH_BLOCK;
+
+      for (i = 0; i < n; ++i)
+      {
+        px[i] = origin_x + (float)(x + i) * spacing;
+      }
+
+      noise_channel_2_block(plan, noise, px, n, channel->offset_x, py, acc);
+
+      if (min)
+      {
+        noise_stats_accumulate(acc, n, min, max, sum);
+      }
+
+      if (write)
+      {
+        noise_quantize(acc, n, kind, lo, hi, dst, y * width + x);
+      }
+    }
+  }
+}
+
+/* An auto range generates the channel twice, once to find its range and once to write
+ * it; pass a fixed range (normalized fBm stays within [-1, 1]) to generate once. */
+NOISE_API NOISE_INLINE int noise_channel_2_quantized(
+    noise_channel *channel, noise_quantize_kind kind, void *dst, int width, int height,
+    float origin_x, float origin_y, float spacing,
+    float lo, float hi, noise_stats *stats)
+{
+  noise_fbm_plan plan;
+  float min = 3.4e38f, max = -3.4e38f;
+  double sum = 0.0;
+
+  if (!noise_fbm_plan_2(&plan, channel->frequency, channel->octaves, channel->lacunarity, channel->gain, channel->rotation))
+  {
+    return 0;
+  }
+
+  if (noise_quantize_auto(kind, lo, hi))
+  {
+    noise_channel_2_quantize_pass(channel, &plan, kind, dst, width, height, origin_x, origin_y, spacing, lo, hi, &min, &max, &sum, 0);
+    noise_channel_2_quantize_pass(channel, &plan, kind, dst, width, height, origin_x, origin_y, spacing, min, max, 0, 0, 0, 1);
+  }
+  else
+  {
+    noise_channel_2_quantize_pass(channel, &plan, kind, dst, width, height, origin_x, origin_y, spacing, lo, hi, stats ? &min : 0, &max, &sum, 1);
+  }
+
+  noise_quantize_stats(stats, width * height, min, max, sum);
+
+  return 1;
+}
+
+NOISE_API NOISE_INLINE int noise_channel_2_u8(noise_channel *channel, unsigned char *dst, int width, int height, float origin_x, float origin_y, float spacing, float lo, float hi, noise_stats *stats)
+{
+  return noise_channel_2_quantized(channel, NOISE_QUANTIZE_U8, dst, width, height, origin_x, origin_y, spacing, lo, hi, stats);
+}
+
+NOISE_API NOISE_INLINE int noise_channel_2_u16(noise_channel *channel, unsigned short *dst, int width, int height, float origin_x, float origin_y, float spacing, float lo, float hi, noise_stats *stats)
+{
+  return noise_channel_2_quantized(channel, NOISE_QUANTIZE_U16, dst, width, height, origin_x, origin_y, spacing, lo, hi, stats);
+}
+
+NOISE_API NOISE_INLINE int noise_channel_2_half(noise_channel *channel, unsigned short *dst, int width, int height, float origin_x, float origin_y, float spacing, noise_stats *stats)
+{
+  return noise_channel_2_quantized(channel, NOISE_QUANTIZE_HALF, dst, width, height, origin_x, origin_y, spacing, 0.0f, 0.0f, stats);
+}
+
+/* #############################################################################
+ * # Streaming export functions
+ * #############################################################################
+ *
+ * Writes heightmaps of any size as raw 16-bit, 16-bit PGM or PFM while rows or tile bands
+ * are generated, so peak memory is one band regardless of the map size.
+ *
+ * Stream mode: noise_stream_begin writes the header through a caller supplied write
+ * callback and noise_stream_rows converts each band through a small staging buffer.
+ *
+ * Mapped mode: the caller creates a file of noise_stream_size bytes and maps it, then
+ * noise_stream_header and noise_stream_encode_rows write straight into the mapped pages.
+ *
+ * 16-bit formats map [lo, hi] onto [0, 65535]. RAW16 is little endian, PGM16 big endian.
+ * PFM stores little endian floats with rows from bottom to top: in stream mode feed rows
+ * from y = height - 1 down to 0, mapped mode places every row itself.
+ *
+ * Files may exceed 4 GiB (a 65536^2 PFM is 16 GiB): noise_stream_size is a double, exact
+ * up to 2^53 bytes, and mapped rows are located by pointer steps rather than a long
+ * offset, which is 32-bit on Windows. One row (width * sample size bytes) and one band
+ * (row_count * width floats) must fit an int.
+ */
+#define NOISE_STREAM_BUFFER 4096
+
+typedef enum noise_stream_format
+{
+  NOISE_STREAM_RAW16 = 0,
+  NOISE_STREAM_PGM16,
+  NOISE_STREAM_PFM
+
+} noise_stream_format;
+
+/* returns non-zero when all size bytes were written */
+typedef int (*noise_write_function)(void *user, void *data, int size);
+
+typedef struct noise_stream
+{
+  noise_stream_format format;
+  int width;
+  int height;
+  int rows_written;
+  float lo;
+  float hi;
+  noise_write_function write;
+  void *user;
+  unsigned char buffer[NOISE_STREAM_BUFFER];
+
+} noise_stream;
+
+NOISE_API NOISE_INLINE int noise_stream_write_int(unsigned char *dst, int value)
+{
+  char digits[12];
+  int n = 0, i;
+
+  do
+  {
+    digits[n++] = (char)('0' + value % 10);
+    value /= 10;
+  } while (value > 0);
+
+  for (i = 0; i < n; ++i)
+  {
+    if (dst)
+    {
+      dst[i] = (unsigned char)digits[n - 1 - i];
+    }
+  }
+
+  return n;
+}
+
+NOISE_API NOISE_INLINE int noise_stream_write_text(unsigned char *dst, const char *text)
+{
+  int n = 0;
+
+  while (text[n])
+  {
+    if (dst)
+    {
+      dst[n] = (unsigned char)text[n];
+    }
+    ++n;
+  }
+
+  return n;
+}
+
+/* writes the file header into dst (may be 0) and returns its size in bytes */
+NOISE_API NOISE_INLINE int noise_stream_header(noise_stream_format format, int width, int height, unsigned char *dst)
+{
+  int n = 0;
+
+  if (format == NOISE_STREAM_RAW16)
+  {
+    return 0;
+  }
+
+  n += noise_stream_write_text(dst ? dst + n : 0, format == NOISE_STREAM_PGM16 ? "P5\n" : "Pf\n");
+  n += noise_stream_write_int(dst ? dst + n : 0, width);
+  n += noise_stream_write_text(dst ? dst + n : 0, " ");
+  n += noise_stream_write_int(dst ? dst + n : 0, height);
+  n += noise_stream_write_text(dst ? dst + n : 0, format == NOISE_STREAM_PGM16 ? "\n65535\n" : "\n-1.0\n");
+
+  return n;
+}
+
+NOISE_API NOISE_INLINE int noise_stream_sample_size(noise_stream_format format)
+{
+  return format == NOISE_STREAM_PFM ? 4 : 2;
+}
+
+/* total file size in bytes for preallocating a mapped output, a double so it stays exact
+ * past 4 GiB where long is 32-bit (LLP64) */
+NOISE_API NOISE_INLINE double noise_stream_size(noise_stream_format format, int width, int height)
+{
+  return (double)noise_stream_header(format, width, height, 0) + (double)width * (double)height * (double)noise_stream_sample_size(format);
+}
+
+/* pointer to file row y of a mapped file, stepping in int sized strides so no offset
+ * wider than one row band is ever formed in an integer type */
+NOISE_API NOISE_INLINE unsigned char *noise_stream_row_pointer(unsigned char *mapped, int header, int row_bytes, int y)
+{
+  unsigned char *p = mapped + header;
+  int stride = 0x7fffffff / row_bytes; /* rows per int sized step */
+
+  while (y > stride)
+  {
+    p += stride * row_bytes;
+    y -= stride;
+  }
+
+  return p + y * row_bytes;
+}
+
+/* converts count samples into the byte layout of format */
+NOISE_API NOISE_INLINE void noise_stream_encode(noise_stream_format format, float lo, float hi, float *src, int count, unsigned char *dst)
+{
+  int i;
+
+  if (format == NOISE_STREAM_PFM)
+  {
+    for (i = 0; i < count; ++i)
+    {
+      union
+      {
+        float f;
+        unsigned int u;
+      } v;
+
+      v.f = src[i];
+      dst[i * 4 + 0] = (unsigned char)(v.u & 0xffu);
+      dst[i * 4 + 1] = (unsigned char)((v.u >> 8) & 0xffu);
+      dst[i * 4 + 2] = (unsigned char)((v.u >> 16) & 0xffu);
+      dst[i * 4 + 3] = (unsigned char)((v.u >> 24) & 0xffu);
+    }
+  }
+  else
+  {
+    float scale = (hi > lo) ? 65535.0f / (hi - lo) : 0.0f;
+    int big_endian = format == NOISE_STREAM_PGM16;
+
+    for (i = 0; i < count; ++i)
+    {
+      float q = (src[i] - lo) * scale + 0.5f;
+      unsigned int v;
+
+      q = q < 0.0f ? 0.0f : (q > 65535.0f ? 65535.0f : q);
+      v = (unsigned int)q;
+
+      dst[i * 2 + (big_endian ? 1 : 0)] = (unsigned char)(v & 0xffu);
+      dst[i * 2 + (big_endian ? 0 : 1)] = (unsigned char)(v >> 8);
+    }
+  }
+}
+
+/* Mapped mode: encodes row_count rows starting at first_row into the mapped file (header included) */
+NOISE_API NOISE_INLINE void noise_stream_encode_rows(
+    noise_stream_format format, int width, int height,
+    float lo, float hi,
+    float *rows, int first_row, int row_count,
+    unsigned char *mapped)
+{
+  int header = noise_stream_header(format, width, height, 0);
+  int row_bytes = width * noise_stream_sample_size(format);
+  int r;
+
+  for (r = 0; r < row_count; ++r)
+  {
+    int y = first_row + r;
+    int file_row = format == NOISE_STREAM_PFM ? height - 1 - y : y;
+
+    noise_stream_encode(format, lo, hi, rows + r * width, width, noise_stream_row_pointer(mapped, header, row_bytes, file_row));
+  }
+}
+
+NOISE_API NOISE_INLINE int noise_stream_begin(
+    noise_stream *stream,
+    noise_stream_format format, int width, int height,
+    float lo, float hi,
+    noise_write_function write, void *user)
+{
+  int header;
+
+  stream->format = format;
+  stream->width = width;
+  stream->height = height;
+  stream->rows_written = 0;
+  stream->lo = lo;
+  stream->hi = hi;
+  stream->write = write;
+  stream->user = user;
+
+  header = noise_stream_header(format, width, height, stream->buffer);
+
+  return header == 0 || write(user, stream->buffer, header);
+}
+
+/* Stream mode: appends row_count rows of width floats */
+NOISE_API NOISE_INLINE int noise_stream_rows(noise_stream *stream, float *rows, int row_count)
+{
+  int sample_size = noise_stream_sample_size(stream->format);
+  int chunk = NOISE_STREAM_BUFFER / sample_size;
+  int count, i;
+
+  if (stream->rows_written + row_count > stream->height)
+  {
+    return 0;
+  }
+
+  count = row_count * stream->width;
+
+  for (i = 0; i < count; i += chunk)
+  {
+    int n = count - i < chunk ? count - i : chunk;
+
+    noise_stream_encode(stream->format, stream->lo, stream->hi, rows + i, n, stream->buffer);
+
+    if (!stream->write(stream->user, stream->buffer, n * sample_size))
+    {
+      return 0;
+    }
+  }
+
+  stream->rows_written += row_count;
+
+  return 1;
+}
+
+/* #############################################################################
+ * # Tile cache functions
+ * #############################################################################
+ *
+ * Persistent cache for generated tiles. The same seed and generation parameters always
+ * produce the same tile, so a tile is keyed by hashing (seed, noise type, frequency,
+ * octaves, lacunarity, gain, rotation, offsets, tile coordinate, tile size, spacing,
+ * library version) and stored as a small header followed by the raw floats.
+ *
+ * The library does no file I/O itself: the caller supplies load/save callbacks, where
+ * load typically memory-maps the file named by the key so a hit costs no copy at all.
+ * Every successful load is paired with one call of the release callback (unmap/free):
+ * files that turn out stale or corrupt are released inside noise_tile_cache_get, hits
+ * when the caller hands the tile back with noise_tile_cache_release.
+ * The tile file is native endian and meant as a machine local cache.
+ */
+#define NOISE_TILE_MAGIC 0x4c544f4eu /* "NOTL" */
+#define NOISE_TILE_VERSION ((unsigned int)(NOISE_VERSION_MAJOR * 1000 + NOISE_VERSION_MINOR))
+
+typedef struct noise_tile_key
+{
+  unsigned int hash[2];
+
+} noise_tile_key;
+
+typedef struct noise_tile_header
+{
+  unsigned int magic;
+  unsigned int version;
+  noise_tile_key key;
+  int width;
+  int height;
+
+} noise_tile_header;
+
+typedef struct noise_tile_store
+{
+  /* returns the (mapped) file named name or 0 on a miss, size receives its byte count */
+  void *(*load)(void *user, char *name, long *size);
+  /* returns non-zero when the file was written */
+  int (*save)(void *user, char *name, void *data, long size);
+  /* gives back memory returned by load, may be 0 if load hands out nothing to free */
+  void (*release)(void *user, void *data, long size);
+  void *user;
+
+} noise_tile_store;
+
+NOISE_API NOISE_INLINE void noise_tile_key_mix(noise_tile_key *key, unsigned int value)
+{
+  int i;
+
+  /* two FNV-1a streams with different offset bases give a 64 bit key */
+  for (i = 0; i < 4; ++i)
+  {
+    unsigned int byte = (value >> (i * 8)) & 0xffu;
+    key->hash[0] = (key->hash[0] ^ byte) * 16777619u;
+    key->hash[1] = (key->hash[1] ^ byte) * 16777619u;
+  }
+}
+
+NOISE_API NOISE_INLINE void noise_tile_key_mix_float(noise_tile_key *key, float value)
+{
+  union
+  {
+    float f;
+    unsigned int u;
+  } v;
+
+  v.f = value;
+  noise_tile_key_mix(key, v.u);
+}
+
+NOISE_API NOISE_INLINE noise_tile_key noise_tile_key_compute(noise_channel *channel, int tile_x, int tile_y, int tile_size, float spacing)
+{
+  noise_tile_key key;
+
+  key.hash[0] = 2166136261u;
+  key.hash[1] = 3735928559u;
+
+  noise_tile_key_mix(&key, NOISE_TILE_VERSION);
+  noise_tile_key_mix(&key, noise_seed_value);
+  noise_tile_key_mix(&key, (unsigned int)channel->type);
+  noise_tile_key_mix_float(&key, channel->frequency);
+  noise_tile_key_mix(&key, (unsigned int)channel->octaves);
+  noise_tile_key_mix_float(&key, channel->lacunarity);
+  noise_tile_key_mix_float(&key, channel->gain);
+  noise_tile_key_mix_float(&key, channel->offset_x);
+  noise_tile_key_mix_float(&key, channel->offset_y);
+  noise_tile_key_mix(&key, channel->rotation ? 1u : 0u);
+
+  if (channel->rotation)
+  {
+    noise_tile_key_mix_float(&key, channel->rotation[0][0]);
+    noise_tile_key_mix_float(&key, channel->rotation[0][1]);
+    noise_tile_key_mix_float(&key, channel->rotation[1][0]);
+    noise_tile_key_mix_float(&key, channel->rotation[1][1]);
+  }
+
+  noise_tile_key_mix(&key, (unsigned int)tile_x);
+  noise_tile_key_mix(&key, (unsigned int)tile_y);
+  noise_tile_key_mix(&key, (unsigned int)tile_size);
+  noise_tile_key_mix_float(&key, spacing);
+
+  return key;
+}
+
+/* writes the 16 hex digit file name of key (plus terminator) into name[17] */
+NOISE_API NOISE_INLINE void noise_tile_key_name(noise_tile_key key, char name[17])
+{
+  static char hex[] = "0123456789abcdef";
+  int i;
+
+  for (i = 0; i < 16; ++i)
+  {
+    name[i] = hex[(key.hash[i / 8] >> ((7 - i % 8) * 4)) & 0xfu];
+  }
+
+  name[16] = '\0';
+}
+
+/* bytes of one tile file, the scratch buffer passed to noise_tile_cache_get must hold this */
+NOISE_API NOISE_INLINE long noise_tile_file_size(int tile_size)
+{
+  return (long)sizeof(noise_tile_header) + (long)tile_size * (long)tile_size * (long)sizeof(float);
+}
+
+/* returns the tile floats inside data if it is a valid tile file for key, otherwise 0 */
+NOISE_API NOISE_INLINE float *noise_tile_file_data(void *data, long size, noise_tile_key key, int tile_size)
+{
+  noise_tile_header *header = (noise_tile_header *)data;
+
+  if (!data || size != noise_tile_file_size(tile_size) ||
+      header->magic != NOISE_TILE_MAGIC ||
+      header->version != NOISE_TILE_VERSION ||
+      header->key.hash[0] != key.hash[0] || header->key.hash[1] != key.hash[1] ||
+      header->width != tile_size || header->height != tile_size)
+  {
+    return 0;
+  }
+
+  return (float *)(header + 1);
+}
+
+/* Returns tile (tile_x, tile_y) of channel, where tile pixel (x, y) is sampled at
+ * ((tile_x * tile_size + x) * spacing, (tile_y * tile_size + y) * spacing).
+ *
+ * On a hit the returned floats live in the memory handed out by store->load. On a miss
+ * the tile is generated into scratch (noise_tile_file_size bytes, float aligned),
+ * saved through store->save and returned from scratch. hit may be 0. Either way, hand
+ * the tile back with noise_tile_cache_release once it is no longer read. Returns 0 (and
+ * saves nothing) if the channel is invalid, see noise_channels_2.
+ */
+NOISE_API NOISE_INLINE float *noise_tile_cache_get(
+    noise_tile_store *store,
+    noise_channel *channel,
+    int tile_x, int tile_y, int tile_size, float spacing,
+    void *scratch, int *hit)
+{
+  noise_tile_key key = noise_tile_key_compute(channel, tile_x, tile_y, tile_size, spacing);
+  noise_tile_header *header = (noise_tile_header *)scratch;
+  char name[17];
+  long size = 0;
+  void *data;
+  float *tile;
+
+  noise_tile_key_name(key, name);
+
+  data = store->load ? store->load(store->user, name, &size) : 0;
+  tile = noise_tile_file_data(data, size, key, tile_size);
+
+  /* a stale or corrupt file is regenerated, its memory is not needed */
+  if (data && !tile && store->release)
+  {
+    store->release(store->user, data, size);
+  }
+
+  if (hit)
+  {
+    *hit = tile != 0;
+  }
+
+  if (tile)
+  {
+    return tile;
+  }
+
+  header->magic = NOISE_TILE_MAGIC;
+  header->version = NOISE_TILE_VERSION;
+  header->key = key;
+  header->width = tile_size;
+  header->height = tile_size;
+  tile = (float *)(header + 1);
+
+  if (!noise_channels_2(channel, 1, tile, tile_size, tile_size,
+                        (float)(tile_x * tile_size) * spacing, (float)(tile_y * tile_size) * spacing, spacing, 0))
+  {
+    return 0;
+  }
+
+  if (store->save)
+  {
+    store->save(store->user, name, scratch, noise_tile_file_size(tile_size));
+  }
+
+  return tile;
+}
+
+/* ends the use of a tile returned by noise_tile_cache_get with the same scratch,
+ * releasing the loaded file on a hit and doing nothing for a tile held in scratch */
+NOISE_API NOISE_INLINE void noise_tile_cache_release(noise_tile_store *store, float *tile, int tile_size, void *scratch)
+{
+  noise_tile_header *header = (noise_tile_header *)tile - 1;
+
+  if (tile && (void *)header != scratch && store->release)
+  {
+    store->release(store->user, header, noise_tile_file_size(tile_size));
+  }
+}
+
+/* #############################################################################
+ * # Tile LRU cache functions
+ * #############################################################################
+ *
+ * Fixed memory budget cache of generated tiles shared by independent systems sampling
+ * the same regions with the same parameters. Tiles are keyed like the on-disk cache
+ * (noise_tile_key_compute) and evicted with the CLOCK approximation of LRU.
+ *
+ * Acquired tiles are pinned, read-only and never evicted until released. Generation of a
+ * missing tile happens outside the lock; other threads asking for the same tile wait for
+ * it instead of generating it twice. lock/unlock may be 0 for single threaded use.
+ *
+ * Waiting goes through the optional wait/wake callbacks: wait is called with the lock
+ * held and must return with it held again (a condition variable wait on the lock's
+ * mutex, or unlock + yield + lock), wake is called with the lock held whenever a tile
+ * becomes ready (a condition variable broadcast). Without wait a waiting thread spins
+ * on the lock.
+ */
+typedef enum noise_tile_lru_state
+{
+  NOISE_TILE_LRU_EMPTY = 0,
+  NOISE_TILE_LRU_LOADING,
+  NOISE_TILE_LRU_READY
+
+} noise_tile_lru_state;
+
+typedef struct noise_tile_lru_entry
+{
+  noise_tile_key key;
+  int tile_x;
+  int tile_y;
+  noise_tile_lru_state state;
+  int pins;
+  int referenced;
+  float *data;
+
+} noise_tile_lru_entry;
+
+typedef struct noise_tile_lru
+{
+  noise_tile_lru_entry *entries;
+  int capacity;
+  int hand;
+  int tile_size;
+  float spacing;
+  unsigned long hits;
+  unsigned long misses;
+  unsigned long evictions;
+  void (*lock)(void *user);
+  void (*unlock)(void *user);
+  void (*wait)(void *user);
+  void (*wake)(void *user);
+  void *lock_user;
+
+} noise_tile_lru;
+
+NOISE_API NOISE_INLINE long noise_tile_lru_entry_size(int tile_size)
+{
+  return (long)sizeof(noise_tile_lru_entry) + (long)tile_size * (long)tile_size * (long)sizeof(float);
+}
+
+/* splits memory (memory_size bytes, pointer aligned) into as many tiles as fit; returns the capacity */
+NOISE_API NOISE_INLINE int noise_tile_lru_init(noise_tile_lru *cache, int tile_size, float spacing, void *memory, long memory_size)
+{
+  float *data;
+  int i;
+
+  cache->capacity = (int)(memory_size / noise_tile_lru_entry_size(tile_size));
+  cache->entries = (noise_tile_lru_entry *)memory;
+  cache->hand = 0;
+  cache->tile_size = tile_size;
+  cache->spacing = spacing;
+  cache->hits = 0;
+  cache->misses = 0;
+  cache->evictions = 0;
+  cache->lock = 0;
+  cache->unlock = 0;
+  cache->wait = 0;
+  cache->wake = 0;
+  cache->lock_user = 0;
+
+  data = (float *)(cache->entries + cache->capacity);
+
+  for (i = 0; i < cache->capacity; ++i)
+  {
+    cache->entries[i].state = NOISE_TILE_LRU_EMPTY;
+    cache->entries[i].pins = 0;
+    cache->entries[i].referenced = 0;
+    cache->entries[i].data = data + (long)i * (long)tile_size * (long)tile_size;
+  }
+
+  return cache->capacity;
+}
+
+NOISE_API NOISE_INLINE void noise_tile_lru_lock(noise_tile_lru *cache)
+{
+  if (cache->lock)
+  {
+    cache->lock(cache->lock_user);
+  }
+}
+
+NOISE_API NOISE_INLINE void noise_tile_lru_unlock(noise_tile_lru *cache)
+{
+  if (cache->unlock)
+  {
+    cache->unlock(cache->lock_user);
+  }
+}
+
+NOISE_API NOISE_INLINE noise_tile_lru_entry *noise_tile_lru_find(noise_tile_lru *cache, noise_tile_key key)
+{
+  int i;
+
+  for (i = 0; i < cache->capacity; ++i)
+  {
+    noise_tile_lru_entry *e = &cache->entries[i];
+
+    if (e->state != NOISE_TILE_LRU_EMPTY && e->key.hash[0] == key.hash[0] && e->key.hash[1] == key.hash[1])
+    {
+      return e;
+    }
+  }
+
+  return 0;
+}
+
+/* CLOCK sweep for an unpinned victim, 0 if every tile is pinned */
+NOISE_API NOISE_INLINE noise_tile_lru_entry *noise_tile_lru_victim(noise_tile_lru *cache)
+{
+  int step;
+
+  for (step = 0; step < 2 * cache->capacity; ++step)
+  {
+    noise_tile_lru_entry *e = &cache->entries[cache->hand];
+    cache->hand = (cache->hand + 1) % cache->capacity;
+
+    if (e->pins > 0)
+    {
+      continue;
+    }
+
+    if (e->referenced)
+    {
+      e->referenced = 0;
+      continue;
+    }
+
+    return e;
+  }
+
+  return 0;
+}
+
+/* Returns the pinned read-only tile, or 0 when every slot is pinned or the channel is invalid
+ * (see noise_channels_2); pair a returned tile with noise_tile_lru_release */
+NOISE_API NOISE_INLINE float *noise_tile_lru_acquire(noise_tile_lru *cache, noise_channel *channel, int tile_x, int tile_y)
+{
+  noise_tile_key key = noise_tile_key_compute(channel, tile_x, tile_y, cache->tile_size, cache->spacing);
+  noise_tile_lru_entry *e;
+  int ok;
+
+  noise_tile_lru_lock(cache);
+
+  e = noise_tile_lru_find(cache, key);
+
+  if (e)
+  {
+    e->pins++;
+    e->referenced = 1;
+    cache->hits++;
+
+    /* another thread is still generating this tile */
+    while (e->state == NOISE_TILE_LRU_LOADING)
+    {
+      if (cache->wait)
+      {
+        cache->wait(cache->lock_user);
+      }
+      else
+      {
+        noise_tile_lru_unlock(cache);
+        noise_tile_lru_lock(cache);
+      }
+    }
+
+    /* the generating thread failed and emptied the slot */
+    if (e->state != NOISE_TILE_LRU_READY)
+    {
+      e->pins--;
+      noise_tile_lru_unlock(cache);
+      return 0;
+    }
+
+    noise_tile_lru_unlock(cache);
+    return e->data;
+  }
+
+  e = noise_tile_lru_victim(cache);
+
+  if (!e)
+  {
+    noise_tile_lru_unlock(cache);
+    return 0;
+  }
+
+  if (e->state != NOISE_TILE_LRU_EMPTY)
+  {
+    cache->evictions++;
+  }
+
+  cache->misses++;
+  e->key = key;
+  e->tile_x = tile_x;
+  e->tile_y = tile_y;
+  e->state = NOISE_TILE_LRU_LOADING;
+  e->pins = 1;
+  e->referenced = 1;
+
+  noise_tile_lru_unlock(cache);
+
+  ok = noise_channels_2(channel, 1, e->data, cache->tile_size, cache->tile_size,
+                        (float)(tile_x * cache->tile_size) * cache->spacing,
+                        (float)(tile_y * cache->tile_size) * cache->spacing,
+                        cache->spacing, 0);
+
+  noise_tile_lru_lock(cache);
+
+  /* a failed tile must never be served, waiters see the empty slot and give up */
+  e->state = ok ? NOISE_TILE_LRU_READY : NOISE_TILE_LRU_EMPTY;
+  e->pins -= !ok;
+
+  if (cache->wake)
+  {
+    cache->wake(cache->lock_user);
+  }
+
+  noise_tile_lru_unlock(cache);
+
+  return ok ? e->data : 0;
+}
+
+NOISE_API NOISE_INLINE void noise_tile_lru_release(noise_tile_lru *cache, float *tile)
+{
+  long tile_floats = (long)cache->tile_size * (long)cache->tile_size;
+  long index = (long)(tile - cache->entries[0].data) / tile_floats;
+
+  noise_tile_lru_lock(cache);
+
+  if (index >= 0 && index < cache->capacity && cache->entries[index].pins > 0)
+  {
+    cache->entries[index].pins--;
+  }
+
+  noise_tile_lru_unlock(cache);
+}
+
+/* Samples channel at (x, y). With allow_interpolate set, a point inside an already cached
+ * tile is bilinearly interpolated from it without generating anything; otherwise (or on a
+ * miss) the fBm is evaluated exactly. Returns 1 when the value came from the cache, 0 when
+ * it was evaluated and -1 (out untouched) when the channel is invalid (see noise_channels_2).
+ */
+NOISE_API NOISE_INLINE int noise_tile_lru_sample(noise_tile_lru *cache, noise_channel *channel, float x, float y, int allow_interpolate, float *out)
+{
+  if (allow_interpolate)
+  {
+    float extent = (float)cache->tile_size * cache->spacing;
+    int tile_x = (int)noise_floor(x / extent);
+    int tile_y = (int)noise_floor(y / extent);
+    float fx = (x - (float)tile_x * extent) / cache->spacing;
+    float fy = (y - (float)tile_y * extent) / cache->spacing;
+    int px = (int)fx, py = (int)fy;
+    noise_tile_lru_entry *e;
+
+    noise_tile_lru_lock(cache);
+
+    e = noise_tile_lru_find(cache, noise_tile_key_compute(channel, tile_x, tile_y, cache->tile_size, cache->spacing));
+
+    /* the bilinear footprint must lie inside the tile */
+    if (e && e->state == NOISE_TILE_LRU_READY && px >= 0 && py >= 0 && px < cache->tile_size - 1 && py < cache->tile_size - 1)
+    {
+      float *t = e->data + py * cache->tile_size + px;
+      float u = fx - (float)px, v = fy - (float)py;
+      float a = noise_lerp(t[0], t[1], u);
+      float b = noise_lerp(t[cache->tile_size], t[cache->tile_size + 1], u);
+
+      *out = noise_lerp(a, b, v);
+      e->referenced = 1;
+      cache->hits++;
+
+      noise_tile_lru_unlock(cache);
+      return 1;
+    }
+
+    cache->misses++;
+    noise_tile_lru_unlock(cache);
+  }
+
+  return noise_channels_2(channel, 1, out, 1, 1, x, y, 1.0f, 0) ? 0 : -1;
+}
+
+/* #############################################################################
+ * # Compressed tile storage functions
+ * #############################################################################
+ *
+ * Compact tiled container for heightmaps and noise layers:
+ *
+ *   header      "NOTC", width, height, tile size, predictor (5 x u32)
+ *   offsets     (tiles + 1) x u32 byte offsets of every tile payload (random access)
+ *   payloads    per tile: float min, float max, bit stream
+ *
+ * Each tile is quantized to 16 bits against its own min/max (max error (max - min) / 131070),
+ * every value is predicted from its decoded neighbours (Paeth, or linear a + b - c which is
+ * usually tighter on smooth noise) and the zigzagged residual is written with adaptive Rice
+ * codes. Smooth noise leaves small residuals, so most values take only a few bits. Tiles
+ * decode independently and row by row, so a decoder needs no more memory than two tile
+ * rows. All values are little endian.
+ *
+ * The readers take the container size and reject headers with an unknown predictor, a tile
+ * size outside 1..NOISE_COMPRESS_MAX_TILE or tile offsets outside the container, so a
+ * truncated or corrupted file fails instead of reading out of bounds.
+ */
+#define NOISE_COMPRESS_MAGIC 0x43544f4eu /* "NOTC" */
+#define NOISE_COMPRESS_MAX_TILE 256
+#define NOISE_COMPRESS_HEADER 20
+#define NOISE_COMPRESS_ESCAPE 24
+
+#define NOISE_PREDICT_PAETH 0
+#define NOISE_PREDICT_LINEAR 1
+
+NOISE_API NOISE_INLINE void noise_compress_put_u32(unsigned char *dst, unsigned int v)
+{
+  dst[0] = (unsigned char)(v & 0xffu);
+  dst[1] = (unsigned char)((v >> 8) & 0xffu);
+  dst[2] = (unsigned char)((v >> 16) & 0xffu);
+  dst[3] = (unsigned char)((v >> 24) & 0xffu);
+}
+
+NOISE_API NOISE_INLINE unsigned int noise_compress_get_u32(unsigned char *src)
+{
+  return (unsigned int)src[0] | ((unsigned int)src[1] << 8) | ((unsigned int)src[2] << 16) | ((unsigned int)src[3] << 24);
+}
+
+NOISE_API NOISE_INLINE void noise_compress_put_float(unsigned char *dst, float f)
+{
+  union
+  {
+    float f;
+    unsigned int u;
+  } v;
+
+  v.f = f;
+  noise_compress_put_u32(dst, v.u);
+}
+
+NOISE_API NOISE_INLINE float noise_compress_get_float(unsigned char *src)
+{
+  union
+  {
+    float f;
+    unsigned int u;
+  } v;
+
+  v.u = noise_compress_get_u32(src);
+  return v.f;
+}
+
+/* predicts a value from its left (a), upper (b) and upper-left (c) neighbours */
+NOISE_API NOISE_INLINE int noise_compress_predict(int predictor, int x, int y, unsigned short *row, unsigned short *prev)
+{
+  int a, b, c, p;
+
+  if (y == 0)
+  {
+    return x == 0 ? 0 : row[x - 1];
+  }
+
+  if (x == 0)
+  {
+    return prev[0];
+  }
+
+  a = row[x - 1];
+  b = prev[x];
+  c = prev[x - 1];
+  p = a + b - c;
+
+  if (predictor == NOISE_PREDICT_LINEAR)
+  {
+    return p < 0 ? 0 : (p > 65535 ? 65535 : p);
+  }
+  else
+  {
+    int pa = p > a ? p - a : a - p;
+    int pb = p > b ? p - b : b - p;
+    int pc = p > c ? p - c : c - p;
+
+    return (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+  }
+}
+
+/* adaptive Rice parameter state (JPEG-LS style running magnitude average) */
+typedef struct noise_compress_rice
+{
+  unsigned int sum;
+  unsigned int count;
+
+} noise_compress_rice;
+
+NOISE_API NOISE_INLINE int noise_compress_rice_k(noise_compress_rice *r)
+{
+  int k = 0;
+
+  while ((r->count << k) < r->sum && k < 15)
+  {
+    ++k;
+  }
+
+  return k;
+}
+
+NOISE_API NOISE_INLINE void noise_compress_rice_update(noise_compress_rice *r, unsigned int v)
+{
+  r->sum += v;
+  r->count++;
+
+  if (r->count >= 64)
+  {
+    r->sum >>= 1;
+    r->count >>= 1;
+  }
+}
+
+typedef struct noise_compress_bits
+{
+  unsigned char *data;
+  long position; /* in bits */
+  long capacity; /* in bits */
+
+} noise_compress_bits;
+
+NOISE_API NOISE_INLINE int noise_compress_write_bits(noise_compress_bits *b, unsigned int value, int count)
+{
+  int i;
+
+  if (b->position + count > b->capacity)
+  {
+    return 0;
+  }
+
+  for (i = 0; i < count; ++i)
+  {
+    long byte = b->position >> 3;
+    int bit = (int)(b->position & 7);
+
+    if (bit == 0)
+    {
+      b->data[byte] = 0;
+    }
+
+    b->data[byte] = (unsigned char)(b->data[byte] | (((value >> i) & 1u) << bit));
+    b->position++;
+  }
+
+  return 1;
+}
+
+NOISE_API NOISE_INLINE unsigned int noise_compress_read_bits(noise_compress_bits *b, int count)
+{
+  unsigned int value = 0;
+  int i;
+
+  for (i = 0; i < count && b->position < b->capacity; ++i)
+  {
+    value |= (unsigned int)((b->data[b->position >> 3] >> (b->position & 7)) & 1) << i;
+    b->position++;
+  }
+
+  return value;
+}
+
+NOISE_API NOISE_INLINE int noise_compress_write_rice(noise_compress_bits *b, noise_compress_rice *r, unsigned int v)
+{
+  int k = noise_compress_rice_k(r);
+  unsigned int q = v >> k;
+  int ok;
+
+  noise_compress_rice_update(r, v);
+
+  if (q >= NOISE_COMPRESS_ESCAPE)
+  {
+    ok = noise_compress_write_bits(b, (1u << NOISE_COMPRESS_ESCAPE) - 1u, NOISE_COMPRESS_ESCAPE);
+    return ok && noise_compress_write_bits(b, v, 16);
+  }
+
+  ok = noise_compress_write_bits(b, (1u << q) - 1u, (int)q + 1); /* q ones and a terminating zero */
+  return ok && noise_compress_write_bits(b, v & ((1u << k) - 1u), k);
+}
+
+NOISE_API NOISE_INLINE unsigned int noise_compress_read_rice(noise_compress_bits *b, noise_compress_rice *r)
+{
+  int k = noise_compress_rice_k(r);
+  unsigned int q = 0, v;
+
+  while (q < NOISE_COMPRESS_ESCAPE && noise_compress_read_bits(b, 1))
+  {
+    ++q;
+  }
+
+  v = (q >= NOISE_COMPRESS_ESCAPE) ? noise_compress_read_bits(b, 16) : (q << k) | noise_compress_read_bits(b, k);
+
+  noise_compress_rice_update(r, v);
+
+  return v;
+}
+
+NOISE_API NOISE_INLINE int noise_compress_tiles(int width, int height, int tile_size)
+{
+  return ((width + tile_size - 1) / tile_size) * ((height + tile_size - 1) / tile_size);
+}
+
+/* worst case container size (every value escaped) */
+NOISE_API NOISE_INLINE long noise_compress_bound(int width, int height, int tile_size)
+{
+  long tiles = (long)noise_compress_tiles(width, height, tile_size);
+
+  return NOISE_COMPRESS_HEADER + (tiles + 1) * 4 + tiles * 9 + ((long)width * (long)height * (NOISE_COMPRESS_ESCAPE + 16) + 7) / 8;
+}
+
+/* Compresses a row-major heightmap into dst. Returns the container size or 0 if it does not fit. */
+NOISE_API NOISE_INLINE long noise_compress(
+    float *heightmap, int width, int height,
+    int tile_size, int predictor,
+    unsigned char *dst, long capacity)
+{
+  unsigned short rows[2][NOISE_COMPRESS_MAX_TILE];
+  int tiles_x, tiles_y, tx, ty, tile = 0;
+  long offset;
+
+  if (tile_size < 1 || tile_size > NOISE_COMPRESS_MAX_TILE || (predictor != NOISE_PREDICT_PAETH && predictor != NOISE_PREDICT_LINEAR))
+  {
+    return 0;
+  }
+
+  tiles_x = (width + tile_size - 1) / tile_size;
+  tiles_y = (height + tile_size - 1) / tile_size;
+  offset = NOISE_COMPRESS_HEADER + ((long)tiles_x * (long)tiles_y + 1) * 4;
+
+  if (capacity < offset)
+  {
+    return 0;
+  }
+
+  noise_compress_put_u32(dst + 0, NOISE_COMPRESS_MAGIC);
+  noise_compress_put_u32(dst + 4, (unsigned int)width);
+  noise_compress_put_u32(dst + 8, (unsigned int)height);
+  noise_compress_put_u32(dst + 12, (unsigned int)tile_size);
+  noise_compress_put_u32(dst + 16, (unsigned int)predictor);
+
+  for (ty = 0; ty < tiles_y; ++ty)
+  {
+    for (tx = 0; tx < tiles_x; ++tx)
+    {
+      int x0 = tx * tile_size, y0 = ty * tile_size;
+      int w = width - x0 < tile_size ? width - x0 : tile_size;
+      int h = height - y0 < tile_size ? height - y0 : tile_size;
+      float min = heightmap[y0 * width + x0], max = min, scale;
+      noise_compress_rice rice;
+      noise_compress_bits bits;
+      int x, y;
+
+      noise_compress_put_u32(dst + NOISE_COMPRESS_HEADER + tile * 4, (unsigned int)offset);
+
+      for (y = 0; y < h; ++y)
+      {
+        for (x = 0; x < w; ++x)
+        {
+          float v = heightmap[(y0 + y) * width + x0 + x];
+          min = v < min ? v : min;
+          max = v > max ? v : max;
+        }
+      }
+
+      if (offset + 8 > capacity)
+      {
+        return 0;
+      }
+
+      noise_compress_put_float(dst + offset, min);
+      noise_compress_put_float(dst + offset + 4, max);
+      scale = max > min ? 65535.0f / (max - min) : 0.0f;
+
+      bits.data = dst + offset + 8;
+      bits.position = 0;
+      bits.capacity = (capacity - offset - 8) * 8;
+      rice.sum = 16;
+      rice.count = 1;
+
+      for (y = 0; y < h; ++y)
+      {
+        unsigned short *row = rows[y & 1], *prev = rows[(y + 1) & 1];
+
+        for (x = 0; x < w; ++x)
+        {
+          int q = (int)((heightmap[(y0 + y) * width + x0 + x] - min) * scale + 0.5f);
+          int r = (q - noise_compress_predict(predictor, x, y, row, prev)) & 0xffff;
+
+          /* residual as signed 16 bit, zigzagged so small magnitudes give small codes */
+          r = r >= 32768 ? r - 65536 : r;
+          row[x] = (unsigned short)q;
+
+          if (!noise_compress_write_rice(&bits, &rice, r < 0 ? (unsigned int)(-2 * r - 1) : (unsigned int)(2 * r)))
+          {
+            return 0;
+          }
+        }
+      }
+
+      offset += 8 + (bits.position + 7) / 8;
+      ++tile;
+    }
+  }
+
+  noise_compress_put_u32(dst + NOISE_COMPRESS_HEADER + tile * 4, (unsigned int)offset);
+
+  return offset;
+}
+
+/* reads the container header, returns 0 if src (src_size bytes) is not a valid compressed container */
+NOISE_API NOISE_INLINE int noise_compress_info(unsigned char *src, long src_size, int *width, int *height, int *tile_size)
+{
+  unsigned int w, h, t, predictor;
+  double tiles;
+
+  if (src_size < NOISE_COMPRESS_HEADER || noise_compress_get_u32(src) != NOISE_COMPRESS_MAGIC)
+  {
+    return 0;
+  }
+
+  w = noise_compress_get_u32(src + 4);
+  h = noise_compress_get_u32(src + 8);
+  t = noise_compress_get_u32(src + 12);
+  predictor = noise_compress_get_u32(src + 16);
+
+  if (w < 1 || h < 1 || w > 0x7fffffffu - NOISE_COMPRESS_MAX_TILE || h > 0x7fffffffu - NOISE_COMPRESS_MAX_TILE ||
+      t < 1 || t > NOISE_COMPRESS_MAX_TILE || (predictor != NOISE_PREDICT_PAETH && predictor != NOISE_PREDICT_LINEAR))
+  {
+    return 0;
+  }
+
+  /* the offset table has to fit (in doubles, a corrupted size may overflow long) */
+  tiles = (double)((w + t - 1) / t) * (double)((h + t - 1) / t);
+
+  if ((double)NOISE_COMPRESS_HEADER + (tiles + 1.0) * 4.0 > (double)src_size)
+  {
+    return 0;
+  }
+
+  *width = (int)w;
+  *height = (int)h;
+  *tile_size = (int)t;
+
+  return 1;
+}
+
+/* streaming decoder of one tile, rows come out top to bottom */
+typedef struct noise_decoder
+{
+  noise_compress_bits bits;
+  noise_compress_rice rice;
+  unsigned short rows[2][NOISE_COMPRESS_MAX_TILE];
+  int predictor;
+  int width; /* of this tile */
+  int height;
+  int y;
+  float min;
+  float scale;
+
+} noise_decoder;
+
+NOISE_API NOISE_INLINE int noise_decoder_begin(noise_decoder *decoder, unsigned char *src, long src_size, int tile_x, int tile_y)
+{
+  int width, height, tile_size, tiles_x, tiles_y;
+  long tile, table, begin, end;
+  unsigned int b, e;
+  float max;
+
+  if (!noise_compress_info(src, src_size, &width, &height, &tile_size))
+  {
+    return 0;
+  }
+
+  tiles_x = (width + tile_size - 1) / tile_size;
+  tiles_y = (height + tile_size - 1) / tile_size;
+
+  if (tile_x < 0 || tile_y < 0 || tile_x >= tiles_x || tile_y >= tiles_y)
+  {
+    return 0;
+  }
+
+  /* the table fits in src_size (checked above), so these products fit in long */
+  tile = (long)tile_y * (long)tiles_x + (long)tile_x;
+  table = NOISE_COMPRESS_HEADER + ((long)tiles_x * (long)tiles_y + 1) * 4;
+  b = noise_compress_get_u32(src + NOISE_COMPRESS_HEADER + tile * 4);
+  e = noise_compress_get_u32(src + NOISE_COMPRESS_HEADER + tile * 4 + 4);
+
+  /* a payload holds at least min and max and lies between the table and the container end
+     (compared unsigned, the offsets may not fit a 32 bit long) */
+  if (e > (unsigned long)src_size || b < (unsigned long)table || b > e || e - b < 8)
+  {
+    return 0;
+  }
+
+  begin = (long)b;
+  end = (long)e;
+
+  decoder->predictor = (int)noise_compress_get_u32(src + 16);
+  decoder->width = width - tile_x * tile_size < tile_size ? width - tile_x * tile_size : tile_size;
+  decoder->height = height - tile_y * tile_size < tile_size ? height - tile_y * tile_size : tile_size;
+  decoder->y = 0;
+  decoder->min = noise_compress_get_float(src + begin);
+  max = noise_compress_get_float(src + begin + 4);
+  decoder->scale = (max - decoder->min) / 65535.0f;
+  decoder->bits.data = src + begin + 8;
+  decoder->bits.position = 0;
+  decoder->bits.capacity = (end - begin - 8) * 8;
+  decoder->rice.sum = 16;
+  decoder->rice.count = 1;
+
+  return 1;
+}
+
+/* decodes the next tile row into row[decoder->width], returns 0 when the tile is done */
+NOISE_API NOISE_INLINE int noise_decoder_row(noise_decoder *decoder, float *row)
+{
+  unsigned short *cur, *prev;
+  int x;
+
+  if (decoder->y >= decoder->height)
+  {
+    return 0;
+  }
+
+  cur = decoder->rows[decoder->y & 1];
+  prev = decoder->rows[(decoder->y + 1) & 1];
+
+  for (x = 0; x < decoder->width; ++x)
+  {
+    unsigned int z = noise_compress_read_rice(&decoder->bits, &decoder->rice);
+    int r = (z & 1u) ? -(int)((z + 1u) >> 1) : (int)(z >> 1);
+    int q = (noise_compress_predict(decoder->predictor, x, decoder->y, cur, prev) + r) & 0xffff;
+
+    cur[x] = (unsigned short)q;
+    row[x] = decoder->min + (float)q * decoder->scale;
+  }
+
+  decoder->y++;
+
+  return 1;
+}
+
+/* random access: decodes tile (tile_x, tile_y) into out[y * tile_width + x] */
+NOISE_API NOISE_INLINE int noise_decompress_tile(unsigned char *src, long src_size, int tile_x, int tile_y, float *out)
+{
+  noise_decoder decoder;
+
+  if (!noise_decoder_begin(&decoder, src, src_size, tile_x, tile_y))
+  {
+    return 0;
+  }
+
+  while (noise_decoder_row(&decoder, out))
+  {
+    out += decoder.width;
+  }
+
+  return 1;
+}
+
+/* #############################################################################
+ * # Tileable texture functions
+ * #############################################################################
+ *
+ * Bakes fBm into seamless periodic textures and samples them back.
+ *
+ * Perlin and value noise use a periodic lattice. Corner coordinates wrap at the period, so
+ * octave i tiles exactly with round(period * lacunarity^i) cells across the texture.
+ * Simplex noise has a skewed lattice that cannot wrap, so it is made seamless by blending
+ * the four wrapped copies with bilinear weights. That keeps it continuous but slightly
+ * lowers contrast towards the texture centre.
+ *
+ * A sample costs one (bilinear) or four (bicubic) cache-resident row fetches instead of
+ * octaves * 4 lattice evaluations. With s the texel spacing in cells of the finest octave:
+ * - bilinear error is bounded by s^2 / 8 * max|f''|
+ * - Catmull-Rom bicubic error is of order s^3
+ * At 8 texels per finest cell (s = 1/8) the measured error on Perlin fBm is below 5e-3
+ * (bilinear) and 1e-3 (bicubic) on the -1..1 range. Value noise has steeper cells, so
+ * expect roughly four times that.
+ */
+NOISE_API NOISE_INLINE int noise_wrap(int i, int n)
+{
+  i %= n;
+  return i < 0 ? i + n : i;
+}
+
+/* Lattice hash of a wrapped corner (x, y >= 0). The table repeats every 256 cells, so corners
+ * from 256 on also hash their high bits in; periods above 256 then do not repeat the
+ * gradients inside one period. Below 256 this is the plain Perlin hash. */
+NOISE_API NOISE_INLINE int noise_periodic_hash(int x, int y)
+{
+  unsigned char *perm = noise_permutations;
+  int h = perm[perm[x & 255] + (y & 255)];
+
+  if ((x | y) >> 8)
+  {
+    h = perm[h + perm[((x >> 8) + perm[(y >> 8) & 255]) & 255]];
+  }
+
+  return h;
+}
+
+/* Perlin noise in lattice units whose corners repeat every period_x, period_y cells */
+NOISE_API NOISE_INLINE float noise_perlin_2_periodic(float x, float y, int period_x, int period_y)
+{
+  float floor_x = noise_floor(x), floor_y = noise_floor(y);
+  float xf = x - floor_x, yf = y - floor_y;
+  float u = noise_fade(xf), v = noise_fade(yf), x1, x2;
+  int X0 = noise_wrap((int)floor_x, period_x), Y0 = noise_wrap((int)floor_y, period_y);
+  int X1 = (X0 + 1) % period_x, Y1 = (Y0 + 1) % period_y;
+  int aa, ab, ba, bb;
+
+  NOISE_PROFILE_OCTAVE(4);
+
+  aa = noise_periodic_hash(X0, Y0);
+  ab = noise_periodic_hash(X0, Y1);
+  ba = noise_periodic_hash(X1, Y0);
+  bb = noise_periodic_hash(X1, Y1);
+
+  x1 = noise_lerp(noise_dot2(noise_gradient_2_lut[aa & 7], xf, yf),
+                  noise_dot2(noise_gradient_2_lut[ba & 7], xf - 1, yf), u);
+  x2 = noise_lerp(noise_dot2(noise_gradient_2_lut[ab & 7], xf, yf - 1),
+                  noise_dot2(noise_gradient_2_lut[bb & 7], xf - 1, yf - 1), u);
+
+  return noise_lerp(x1, x2, v) * 0.70710678f;
+}
+
+/* Value noise in lattice units whose corners repeat every period_x, period_y cells. Corners
+ * are keyed x + stride * y with the stride of noise_value_2 (317) or period_x if wider, so
+ * wide periods do not alias rows onto each other. Keys stay exact in float while
+ * stride * period_y < 2^24. */
+NOISE_API NOISE_INLINE float noise_value_2_periodic(float x, float y, int period_x, int period_y)
+{
+  float floor_x = noise_floor(x), floor_y = noise_floor(y);
+  float wx = x - floor_x, wy = y - floor_y;
+  float ux = wx * wx * wx * (wx * (wx * 6.0f - 15.0f) + 10.0f);
+  float uy = wy * wy * wy * (wy * (wy * 6.0f - 15.0f) + 10.0f);
+  int X0 = noise_wrap((int)floor_x, period_x), Y0 = noise_wrap((int)floor_y, period_y);
+  float stride = period_x > 317 ? (float)period_x : 317.0f;
+  float x0 = (float)X0, x1 = (float)((X0 + 1) % period_x);
+  float y0 = stride * (float)Y0, y1 = stride * (float)((Y0 + 1) % period_y);
+  float a = noise_hash(x0 + y0);
+  float b = noise_hash(x1 + y0);
+  float c = noise_hash(x0 + y1);
+  float d = noise_hash(x1 + y1);
+
+  NOISE_PROFILE_OCTAVE(4);
+
+  return -1.0f + 2.0f * (a + (b - a) * ux + (c - a) * uy + (a - b - c + d) * ux * uy);
+}
+
+/* simplex fBm made seamless over width x height texels by blending the four wrapped copies */
+NOISE_API NOISE_INLINE float noise_simplex_2_fbm_seamless(float u, float v, int width, int height, float frequency, int octaves, float lacunarity, float gain)
+{
+  float w = (float)width, h = (float)height;
+  float s, t;
+
+  u -= noise_floor(u / w) * w;
+  v -= noise_floor(v / h) * h;
+  s = u / w;
+  t = v / h;
+
+  return (1.0f - s) * (1.0f - t) * noise_simplex_2_fbm(u, v, frequency, octaves, lacunarity, gain) +
+         s * (1.0f - t) * noise_simplex_2_fbm(u - w, v, frequency, octaves, lacunarity, gain) +
+         (1.0f - s) * t * noise_simplex_2_fbm(u, v - h, frequency, octaves, lacunarity, gain) +
+         s * t * noise_simplex_2_fbm(u - w, v - h, frequency, octaves, lacunarity, gain);
+}
+
+/*
+ * Exact tileable fBm at texel coordinate (u, v) of a width x height texture with period
+ * cells across the width for the first octave. This is the reference the baked texture samples.
+ */
+NOISE_API NOISE_INLINE float noise_tileable_2_fbm(
+    noise_type type, float u, float v, int width, int height,
+    int period, int octaves, float lacunarity, float gain)
+{
+  float sum = 0.0f, amp = 1.0f, norm = 0.0f, cells = (float)period;
+  int i;
+
+  if (type == NOISE_TYPE_SIMPLEX)
+  {
+    return noise_simplex_2_fbm_seamless(u, v, width, height, cells / (float)width, octaves, lacunarity, gain);
+  }
+
+  NOISE_PROFILE_SAMPLES(1);
+
+  for (i = 0; i < octaves; ++i)
+  {
+    int px = (int)(cells + 0.5f);
+    int py = (int)(cells * (float)height / (float)width + 0.5f);
+    float x, y;
+
+    px = px < 1 ? 1 : px;
+    py = py < 1 ? 1 : py;
+    x = u * (float)px / (float)width;
+    y = v * (float)py / (float)height;
+
+    sum += amp * (type == NOISE_TYPE_VALUE ? noise_value_2_periodic(x, y, px, py) : noise_perlin_2_periodic(x, y, px, py));
+    norm += amp;
+    cells *= lacunarity;
+    amp *= gain;
+  }
+
+  return sum / norm;
+}
+
+/* bakes a seamless width x height fBm texture (row-major) */
+NOISE_API NOISE_INLINE void noise_tileable_2_bake(
+    float *texture, int width, int height,
+    noise_type type, int period, int octaves, float lacunarity, float gain)
+{
+  int x, y;
+
+  NOISE_PROFILE_BEGIN(NOISE_PROFILE_API_TILEABLE_BAKE);
+
+  for (y = 0; y < height; ++y)
+  {
+    for (x = 0; x < width; ++x)
+    {
+      texture[y * width + x] = noise_tileable_2_fbm(type, (float)x, (float)y, width, height, period, octaves, lacunarity, gain);
+    }
+  }
+
+  NOISE_PROFILE_END(NOISE_PROFILE_API_TILEABLE_BAKE);
+}
+
+/* bilinear lookup at texel coordinate (u, v), wrapping at the texture borders */
+NOISE_API NOISE_INLINE float noise_texture_bilinear(float *texture, int width, int height, float u, float v)
+{
+  float fu = noise_floor(u), fv = noise_floor(v);
+  float tx = u - fu, ty = v - fv;
+  int x0 = noise_wrap((int)fu, width), y0 = noise_wrap((int)fv, height);
+  int x1 = (x0 + 1) % width;
+  float *r0 = texture + y0 * width, *r1 = texture + ((y0 + 1) % height) * width;
+
+  return noise_lerp(noise_lerp(r0[x0], r0[x1], tx), noise_lerp(r1[x0], r1[x1], tx), ty);
+}
+
+/* Catmull-Rom bicubic lookup at texel coordinate (u, v), wrapping at the texture borders */
+NOISE_API NOISE_INLINE float noise_texture_bicubic(float *texture, int width, int height, float u, float v)
+{
+  float fu = noise_floor(u), fv = noise_floor(v);
+  float tx = u - fu, ty = v - fv;
+  float wx[4], wy[4], sum = 0.0f;
+  int xs[4], x0 = (int)fu, y0 = (int)fv, i, j;
+
+  wx[0] = tx * (-0.5f + tx * (1.0f - 0.5f * tx));
+  wx[1] = 1.0f + tx * tx * (-2.5f + 1.5f * tx);
+  wx[2] = tx * (0.5f + tx * (2.0f - 1.5f * tx));
+  wx[3] = tx * tx * (-0.5f + 0.5f * tx);
+  wy[0] = ty * (-0.5f + ty * (1.0f - 0.5f * ty));
+  wy[1] = 1.0f + ty * ty * (-2.5f + 1.5f * ty);
+  wy[2] = ty * (0.5f + ty * (2.0f - 1.5f * ty));
+  wy[3] = ty * ty * (-0.5f + 0.5f * ty);
+
+  for (i = 0; i < 4; ++i)
+  {
+    xs[i] = noise_wrap(x0 - 1 + i, width);
+  }
+
+  for (j = 0; j < 4; ++j)
+  {
+    float *row = texture + noise_wrap(y0 - 1 + j, height) * width;
+
+    sum += wy[j] * (wx[0] * row[xs[0]] + wx[1] * row[xs[1]] + wx[2] * row[xs[2]] + wx[3] * row[xs[3]]);
+  }
+
+  return sum;
+}
+
+/* #############################################################################
+ * # Spectral synthesis functions
+ * #############################################################################
+ *
+ * Fractional Brownian surfaces straight from the frequency domain: complex Gaussian white
+ * noise is shaped so its power falls off as 1 / f^beta and an inverse FFT brings it back.
+ * The cost is O(n log n) no matter how many scales the spectrum covers, and because the
+ * DFT is periodic the result tiles seamlessly. beta = 2H + 2 for Hurst exponent H; 2 gives
+ * rough terrain and 3 smooth rolling hills.
+ */
+NOISE_API NOISE_INLINE int noise_is_pow2(int n)
+{
+  return n > 0 && (n & (n - 1)) == 0;
+}
+
+/* linearly maps data to [lo, hi] from its own min/max */
+NOISE_API NOISE_INLINE void noise_normalize(float *data, int count, float lo, float hi)
+{
+  float min = data[0], max = data[0], scale;
+  int i;
+
+  for (i = 1; i < count; ++i)
+  {
+    min = data[i] < min ? data[i] : min;
+    max = data[i] > max ? data[i] : max;
+  }
+
+  scale = max > min ? (hi - lo) / (max - min) : 0.0f;
+
+  for (i = 0; i < count; ++i)
+  {
+    data[i] = lo + (data[i] - min) * scale;
+  }
+}
+
+/* in-place iterative radix-2 FFT of n (power of two) complex values, inverse scales by 1 / n */
+NOISE_API NOISE_INLINE void noise_fft(float *re, float *im, int n, int inverse)
+{
+  float sign = inverse ? 2.0f * NOISE_PI : -2.0f * NOISE_PI;
+  int i, j, k, len;
+
+  /* bit reversal permutation */
+  for (i = 1, j = 0; i < n; ++i)
+  {
+    int bit = n >> 1;
+
+    for (; j & bit; bit >>= 1)
+    {
+      j ^= bit;
+    }
+
+    j ^= bit;
+
+    if (i < j)
+    {
+      float t = re[i];
+      re[i] = re[j];
+      re[j] = t;
+      t = im[i];
+      im[i] = im[j];
+      im[j] = t;
+    }
+  }
+
+  for (len = 2; len <= n; len <<= 1)
+  {
+    int half = len >> 1;
+
+    /* one twiddle per butterfly column, evaluated directly to avoid recurrence drift */
+    for (k = 0; k < half; ++k)
+    {
+      float angle = sign * (float)k / (float)len;
+      float wr = noise_cos(angle), wi = noise_sin(angle);
+
+      for (i = k; i < n; i += len)
+      {
+        float xr = re[i + half] * wr - im[i + half] * wi;
+        float xi = re[i + half] * wi + im[i + half] * wr;
+
+        re[i + half] = re[i] - xr;
+        im[i + half] = im[i] - xi;
+        re[i] += xr;
+        im[i] += xi;
+      }
+    }
+  }
+
+  if (inverse)
+  {
+    float scale = 1.0f / (float)n;
+
+    for (i = 0; i < n; ++i)
+    {
+      re[i] *= scale;
+      im[i] *= scale;
+    }
+  }
+}
+
+/* 2D FFT of a row-major width x height complex field, scratch holds 2 * height floats */
+NOISE_API NOISE_INLINE void noise_fft_2(float *re, float *im, int width, int height, int inverse, float *scratch)
+{
+  float *col_re = scratch, *col_im = scratch + height;
+  int x, y;
+
+  for (y = 0; y < height; ++y)
+  {
+    noise_fft(re + y * width, im + y * width, width, inverse);
+  }
+
+  for (x = 0; x < width; ++x)
+  {
+    for (y = 0; y < height; ++y)
+    {
+      col_re[y] = re[y * width + x];
+      col_im[y] = im[y * width + x];
+    }
+
+    noise_fft(col_re, col_im, height, inverse);
+
+    for (y = 0; y < height; ++y)
+    {
+      re[y * width + x] = col_re[y];
+      im[y * width + x] = col_im[y];
+    }
+  }
+}
+
+/* floats of scratch noise_spectral_2 needs */
+NOISE_API NOISE_INLINE int noise_spectral_2_scratch_size(int width, int height)
+{
+  return width * height + 2 * height;
+}
+
+/*
+ * Synthesizes a seamless width x height (powers of two) fBm heightmap normalized to [-1, 1],
+ * the same range and layout the fBm functions produce, so it feeds the erosion passes as is.
+ * Returns 0 if a dimension is not a power of two.
+ */
+NOISE_API NOISE_INLINE int noise_spectral_2(float *heightmap, float *scratch, int width, int height, float beta, unsigned int seed)
+{
+  float *im = scratch;
+  int x, y;
+
+  if (!noise_is_pow2(width) || !noise_is_pow2(height))
+  {
+    return 0;
+  }
+
+  NOISE_PROFILE_BEGIN(NOISE_PROFILE_API_SPECTRAL);
+
+  for (y = 0; y < height; ++y)
+  {
+    float fy = (float)(y <= height / 2 ? y : y - height) / (float)height;
+
+    for (x = 0; x < width; ++x)
+    {
+      float fx = (float)(x <= width / 2 ? x : x - width) / (float)width;
+      float f2 = fx * fx + fy * fy;
+      unsigned int index = (unsigned int)(y * width + x);
+      float u1 = 1.0f - noise_random_float(seed, 0, index); /* (0, 1] */
+      float u2 = noise_random_float(seed, 1, index);
+      float amplitude, radius;
+
+      /* |A| ~ f^(-beta / 2) so power ~ f^-beta, the DC term is dropped */
+      amplitude = f2 > 0.0f ? noise_pow(f2, -0.25f * beta) : 0.0f;
+      radius = amplitude * noise_sqrt(-1.38629436f * noise_log2(u1)); /* Box-Muller, -2 ln u1 */
+
+      heightmap[y * width + x] = radius * noise_cos(2.0f * NOISE_PI * u2);
+      im[y * width + x] = radius * noise_sin(2.0f * NOISE_PI * u2);
+    }
+  }
+
+  /* the real part of a complex Gaussian field is itself Gaussian with the same spectrum */
+  noise_fft_2(heightmap, im, width, height, 1, scratch + width * height);
+  noise_normalize(heightmap, width * height, -1.0f, 1.0f);
+
+  NOISE_PROFILE_END(NOISE_PROFILE_API_SPECTRAL);
+
+  return 1;
+}
+
+/* #############################################################################
+ * # Noise graph functions
+ * #############################################################################
+ *
+ * Layered generators (warp of fBm, cliffs, masks, ...) authored as a node graph and
+ * compiled into a flat register program:
+ *
+ *   noise_graph graph;
+ *   noise_graph_init(&graph);
+ *   e = noise_graph_fbm_2(&graph, NOISE_TYPE_VALUE, noise_graph_x(&graph), noise_graph_y(&graph), ...);
+ *   e = noise_graph_remap(&graph, e, -1.0f, 1.0f, 0.0f, 1200.0f);
+ *   noise_graph_compile(&graph, e, &program);
+ *   noise_program_run(&program, xs, ys, 0, out, count, scratch);
+ *
+ * Nodes are hash-consed on insertion, so building the same sub-expression twice yields the
+ * same node and it is evaluated once per block for all of its consumers. Compilation drops
+ * unreachable nodes and recycles registers once their last consumer has run. The program
+ * runs node by node over blocks of NOISE_BATCH_BLOCK samples: arithmetic is a contiguous
+ * loop the compiler can vectorize, and noise/fBm nodes go through the octave-major batch
+ * kernels. Builders return -1 once the node array is full, for octave counts outside
+ * 1..NOISE_FBM_PLAN_MAX_OCTAVES, and any -1 input propagates, so only the final compile
+ * needs checking.
+ *
+ * noise_graph_vec2_fbm_2 is the one two-output node: both components of the vector fBm
+ * come from a single lattice traversal, the second is read through a NOISE_OP_VEC2_Y node
+ * and written by the same instruction (dst2).
+ */
+#define NOISE_GRAPH_MAX_NODES 64
+#define NOISE_GRAPH_TABLE 128 /* power of two, at least twice the node count */
+#define NOISE_GRAPH_INPUTS 3  /* registers 0, 1, 2 hold x, y, z */
+
+typedef enum noise_op
+{
+  NOISE_OP_X = 0,
+  NOISE_OP_Y,
+  NOISE_OP_Z,
+  NOISE_OP_CONST,      /* param[0] */
+  NOISE_OP_NOISE_2,    /* type at (a, b), param[0] frequency */
+  NOISE_OP_NOISE_3,    /* type at (a, b, c), param[0] frequency */
+  NOISE_OP_FBM_2,      /* type at (a, b), param[] frequency, lacunarity, gain, octaves, optional 2x2 rotation */
+  NOISE_OP_FBM_3,      /* type at (a, b, c), as above with an optional 3x3 rotation */
+  NOISE_OP_ADD,        /* a + b */
+  NOISE_OP_SUB,        /* a - b */
+  NOISE_OP_MUL,        /* a * b */
+  NOISE_OP_MIN,        /* min(a, b) */
+  NOISE_OP_MAX,        /* max(a, b) */
+  NOISE_OP_ABS,        /* |a| */
+  NOISE_OP_REMAP,      /* a from [param 0, param 1] to [param 2, param 3], unclamped */
+  NOISE_OP_SMOOTHSTEP, /* smoothstep(param 0, param 1, a) */
+  NOISE_OP_SELECT,     /* a where c < param 0 - param 1, b where c > param 0 + param 1, blended between */
+  NOISE_OP_VEC2_FBM_2, /* x of simplex vec2 fBm at (a, b), params as NOISE_OP_FBM_2, y goes to dst2 */
+  NOISE_OP_VEC2_Y      /* y of the NOISE_OP_VEC2_FBM_2 node a, no instruction of its own */
+
+} noise_op;
+
+typedef struct noise_graph_node
+{
+  noise_op op;
+  noise_type type;
+  int in[3];
+  int octaves;
+  float param[4];
+  float *rotation; /* row-major 2x2 or 3x3, may be 0 */
+
+} noise_graph_node;
+
+typedef struct noise_graph
+{
+  noise_graph_node nodes[NOISE_GRAPH_MAX_NODES];
+  short table[NOISE_GRAPH_TABLE]; /* node index + 1, 0 = empty */
+  int node_count;
+
+} noise_graph;
+
+typedef struct noise_instruction
+{
+  noise_op op;
+  noise_type type;
+  int octaves;
+  unsigned char dst;
+  unsigned char dst2; /* second output of NOISE_OP_VEC2_FBM_2 */
+  unsigned char in[3];
+  float param[4];
+  float *rotation;
+
+} noise_instruction;
+
+typedef struct noise_program
+{
+  noise_instruction code[NOISE_GRAPH_MAX_NODES];
+  int count;
+  int registers; /* including the three input registers */
+  int output;
+
+} noise_program;
+
+NOISE_API NOISE_INLINE noise_3_function noise_function_3(noise_type type)
+{
+  /* there is no 3D value noise, it falls back to Perlin */
+  return type == NOISE_TYPE_SIMPLEX ? noise_simplex_3 : noise_perlin_3;
+}
+
+NOISE_API NOISE_INLINE unsigned int noise_graph_hash(noise_graph_node *node)
+{
+  unsigned int h = 2166136261u;
+  int i;
+
+  h = (h ^ (unsigned int)node->op) * 16777619u;
+  h = (h ^ (unsigned int)node->type) * 16777619u;
+  h = (h ^ (unsigned int)node->octaves) * 16777619u;
+
+  for (i = 0; i < 3; ++i)
+  {
+    h = (h ^ (unsigned int)(node->in[i] + 1)) * 16777619u;
+  }
+
+  for (i = 0; i < 4; ++i)
+  {
+    union
+    {
+      float f;
+      unsigned int u;
+    } v;
+
+    v.f = node->param[i];
+    h = (h ^ v.u) * 16777619u;
+  }
+
+  return h;
+}
+
+NOISE_API NOISE_INLINE int noise_graph_equal(noise_graph_node *a, noise_graph_node *b)
+{
+  return a->op == b->op && a->type == b->type && a->octaves == b->octaves &&
+         a->in[0] == b->in[0] && a->in[1] == b->in[1] && a->in[2] == b->in[2] &&
+         a->param[0] == b->param[0] && a->param[1] == b->param[1] &&
+         a->param[2] == b->param[2] && a->param[3] == b->param[3] &&
+         a->rotation == b->rotation;
+}
+
+NOISE_API NOISE_INLINE void noise_graph_init(noise_graph *graph)
+{
+  int i;
+
+  for (i = 0; i < NOISE_GRAPH_TABLE; ++i)
+  {
+    graph->table[i] = 0;
+  }
+
+  graph->node_count = 0;
+}
+
+NOISE_API NOISE_INLINE int noise_graph_arity(noise_op op)
+{
+  switch (op)
+  {
+  case NOISE_OP_X:
+  case NOISE_OP_Y:
+  case NOISE_OP_Z:
+  case NOISE_OP_CONST:
+    return 0;
+  case NOISE_OP_ABS:
+  case NOISE_OP_REMAP:
+  case NOISE_OP_SMOOTHSTEP:
+  case NOISE_OP_VEC2_Y:
+    return 1;
+  case NOISE_OP_NOISE_3:
+  case NOISE_OP_FBM_3:
+  case NOISE_OP_SELECT:
+    return 3;
+  default:
+    return 2;
+  }
+}
+
+/* returns the existing node if an identical one was added before (common subexpression) */
+NOISE_API NOISE_INLINE int noise_graph_node_add(noise_graph *graph, noise_graph_node *node)
+{
+  unsigned int slot;
+  int i;
+
+  /* a failed (-1) or unknown input fails this node too */
+  for (i = 0; i < noise_graph_arity(node->op); ++i)
+  {
+    if (node->in[i] < 0 || node->in[i] >= graph->node_count)
+    {
+      return -1;
+    }
+  }
+
+  if (node->op == NOISE_OP_VEC2_Y && graph->nodes[node->in[0]].op != NOISE_OP_VEC2_FBM_2)
+  {
+    return -1;
+  }
+
+  slot = noise_graph_hash(node) & (NOISE_GRAPH_TABLE - 1);
+
+  while (graph->table[slot])
+  {
+    int existing = graph->table[slot] - 1;
+
+    if (noise_graph_equal(&graph->nodes[existing], node))
+    {
+      return existing;
+    }
+
+    slot = (slot + 1) & (NOISE_GRAPH_TABLE - 1);
+  }
+
+  if (graph->node_count >= NOISE_GRAPH_MAX_NODES)
+  {
+    return -1;
+  }
+
+  graph->nodes[graph->node_count] = *node;
+  graph->table[slot] = (short)(graph->node_count + 1);
+
+  return graph->node_count++;
+}
+
+NOISE_API NOISE_INLINE int noise_graph_op(
+    noise_graph *graph, noise_op op,
+    int a, int b, int c,
+    float p0, float p1, float p2, float p3)
+{
+  noise_graph_node node;
+
+  node.op = op;
+  node.type = NOISE_TYPE_PERLIN;
+  node.in[0] = a;
+  node.in[1] = b;
+  node.in[2] = c;
+  node.octaves = 0;
+  node.param[0] = p0;
+  node.param[1] = p1;
+  node.param[2] = p2;
+  node.param[3] = p3;
+  node.rotation = 0;
+
+  return noise_graph_node_add(graph, &node);
+}
+
+NOISE_API NOISE_INLINE int noise_graph_x(noise_graph *graph)
+{
+  return noise_graph_op(graph, NOISE_OP_X, -1, -1, -1, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+NOISE_API NOISE_INLINE int noise_graph_y(noise_graph *graph)
+{
+  return noise_graph_op(graph, NOISE_OP_Y, -1, -1, -1, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+NOISE_API NOISE_INLINE int noise_graph_z(noise_graph *graph)
+{
+  return noise_graph_op(graph, NOISE_OP_Z, -1, -1, -1, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+NOISE_API NOISE_INLINE int noise_graph_const(noise_graph *graph, float value)
+{
+  return noise_graph_op(graph, NOISE_OP_CONST, -1, -1, -1, value, 0.0f, 0.0f, 0.0f);
+}
+
+NOISE_API NOISE_INLINE int noise_graph_noise_2(noise_graph *graph, noise_type type, int x, int y, float frequency)
+{
+  noise_graph_node node;
+
+  node.op = NOISE_OP_NOISE_2;
+  node.type = type;
+  node.in[0] = x;
+  node.in[1] = y;
+  node.in[2] = -1;
+  node.octaves = 1;
+  node.param[0] = frequency;
+  node.param[1] = node.param[2] = node.param[3] = 0.0f;
+  node.rotation = 0;
+
+  return noise_graph_node_add(graph, &node);
+}
+
+NOISE_API NOISE_INLINE int noise_graph_noise_3(noise_graph *graph, noise_type type, int x, int y, int z, float frequency)
+{
+  noise_graph_node node;
+
+  node.op = NOISE_OP_NOISE_3;
+  node.type = type;
+  node.in[0] = x;
+  node.in[1] = y;
+  node.in[2] = z;
+  node.octaves = 1;
+  node.param[0] = frequency;
+  node.param[1] = node.param[2] = node.param[3] = 0.0f;
+  node.rotation = 0;
+
+  return noise_graph_node_add(graph, &node);
+}
+
+/* rotation is a 2x2 matrix (float[2][2]) or 0, it is referenced and must outlive the program */
+NOISE_API NOISE_INLINE int noise_graph_fbm_2(
+    noise_graph *graph, noise_type type, int x, int y,
+    float frequency, int octaves, float lacunarity, float gain,
+    float rotation[2][2])
+{
+  noise_graph_node node;
+
+  if (octaves < 1 || octaves > NOISE_FBM_PLAN_MAX_OCTAVES)
+  {
+    return -1;
+  }
+
+  node.op = NOISE_OP_FBM_2;
+  node.type = type;
+  node.in[0] = x;
+  node.in[1] = y;
+  node.in[2] = -1;
+  node.octaves = octaves;
+  node.param[0] = frequency;
+  node.param[1] = lacunarity;
+  node.param[2] = gain;
+  node.param[3] = 0.0f;
+  node.rotation = rotation ? rotation[0] : 0;
+
+  return noise_graph_node_add(graph, &node);
+}
+
+/* rotation is a 3x3 matrix (float[3][3]) or 0, it is referenced and must outlive the program */
+NOISE_API NOISE_INLINE int noise_graph_fbm_3(
+    noise_graph *graph, noise_type type, int x, int y, int z,
+    float frequency, int octaves, float lacunarity, float gain,
+    float rotation[3][3])
+{
+  noise_graph_node node;
+
+  if (octaves < 1 || octaves > NOISE_FBM_PLAN_MAX_OCTAVES)
+  {
+    return -1;
+  }
+
+  node.op = NOISE_OP_FBM_3;
+  node.type = type;
+  node.in[0] = x;
+  node.in[1] = y;
+  node.in[2] = z;
+  node.octaves = octaves;
+  node.param[0] = frequency;
+  node.param[1] = lacunarity;
+  node.param[2] = gain;
+  node.param[3] = 0.0f;
+  node.rotation = rotation ? rotation[0] : 0;
+
+  return noise_graph_node_add(graph, &node);
+}
+
+NOISE_API NOISE_INLINE int noise_graph_add(noise_graph *graph, int a, int b)
+{
+  return noise_graph_op(graph, NOISE_OP_ADD, a, b, -1, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+NOISE_API NOISE_INLINE int noise_graph_sub(noise_graph *graph, int a, int b)
+{
+  return noise_graph_op(graph, NOISE_OP_SUB, a, b, -1, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+NOISE_API NOISE_INLINE int noise_graph_mul(noise_graph *graph, int a, int b)
+{
+  return noise_graph_op(graph, NOISE_OP_MUL, a, b, -1, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+NOISE_API NOISE_INLINE int noise_graph_min(noise_graph *graph, int a, int b)
+{
+  return noise_graph_op(graph, NOISE_OP_MIN, a, b, -1, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+NOISE_API NOISE_INLINE int noise_graph_max(noise_graph *graph, int a, int b)
+{
+  return noise_graph_op(graph, NOISE_OP_MAX, a, b, -1, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+NOISE_API NOISE_INLINE int noise_graph_abs(noise_graph *graph, int a)
+{
+  return noise_graph_op(graph, NOISE_OP_ABS, a, -1, -1, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+NOISE_API NOISE_INLINE int noise_graph_remap(noise_graph *graph, int a, float in_lo, float in_hi, float out_lo, float out_hi)
+{
+  return noise_graph_op(graph, NOISE_OP_REMAP, a, -1, -1, in_lo, in_hi, out_lo, out_hi);
+}
+
+NOISE_API NOISE_INLINE int noise_graph_smoothstep(noise_graph *graph, int a, float edge0, float edge1)
+{
+  return noise_graph_op(graph, NOISE_OP_SMOOTHSTEP, a, -1, -1, edge0, edge1, 0.0f, 0.0f);
+}
+
+/* a below threshold - falloff, b above threshold + falloff, smoothly blended in between */
+NOISE_API NOISE_INLINE int noise_graph_select(noise_graph *graph, int a, int b, int control, float threshold, float falloff)
+{
+  return noise_graph_op(graph, NOISE_OP_SELECT, a, b, control, threshold, falloff, 0.0f, 0.0f);
+}
+
+/* Simplex vector fBm (noise_simplex_2_vec2_fbm) at (x, y): out[0] and out[1] are its x and y
+ * components. Rotation is a 2x2 matrix (float[2][2]) or 0, referenced like noise_graph_fbm_2.
+ */
+NOISE_API NOISE_INLINE void noise_graph_vec2_fbm_2(
+    noise_graph *graph, int x, int y,
+    float frequency, int octaves, float lacunarity, float gain,
+    float rotation[2][2],
+    int out[2])
+{
+  noise_graph_node node;
+
+  out[0] = out[1] = -1;
+
+  if (octaves < 1 || octaves > NOISE_FBM_PLAN_MAX_OCTAVES)
+  {
+    return;
+  }
+
+  node.op = NOISE_OP_VEC2_FBM_2;
+  node.type = NOISE_TYPE_SIMPLEX;
+  node.in[0] = x;
+  node.in[1] = y;
+  node.in[2] = -1;
+  node.octaves = octaves;
+  node.param[0] = frequency;
+  node.param[1] = lacunarity;
+  node.param[2] = gain;
+  node.param[3] = 0.0f;
+  node.rotation = rotation ? rotation[0] : 0;
+
+  out[0] = noise_graph_node_add(graph, &node);
+  out[1] = noise_graph_op(graph, NOISE_OP_VEC2_Y, out[0], -1, -1, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+/* Domain warp matching noise_simplex_2_domain_warp_fbm:
+ *   out = (x, y) + amplitude * vec2_fbm(x + 5.2, y + 1.3)
+ * Feeding out into a simplex noise_graph_fbm_2 with the same parameters reproduces it.
+ */
+NOISE_API NOISE_INLINE void noise_graph_warp_2(
+    noise_graph *graph, int x, int y,
+    float frequency, int octaves, float lacunarity, float gain, float amplitude,
+    int out[2])
+{
+  int amp = noise_graph_const(graph, amplitude);
+  int w[2];
+
+  noise_graph_vec2_fbm_2(graph, noise_graph_add(graph, x, noise_graph_const(graph, 5.2f)), noise_graph_add(graph, y, noise_graph_const(graph, 1.3f)), frequency, octaves, lacunarity, gain, 0, w);
+
+  out[0] = noise_graph_add(graph, x, noise_graph_mul(graph, w[0], amp));
+  out[1] = noise_graph_add(graph, y, noise_graph_mul(graph, w[1], amp));
+}
+
+/* Compiles the nodes reachable from output into program. Returns 0 if output is invalid. */
+NOISE_API NOISE_INLINE int noise_graph_compile(noise_graph *graph, int output, noise_program *program)
+{
+  unsigned char reg[NOISE_GRAPH_MAX_NODES];
+  unsigned char free_regs[NOISE_GRAPH_MAX_NODES];
+  int last_use[NOISE_GRAPH_MAX_NODES];
+  int live[NOISE_GRAPH_MAX_NODES];
+  int free_count = 0, i, k;
+
+  program->count = 0;
+  program->registers = NOISE_GRAPH_INPUTS;
+  program->output = 0;
+
+  if (output < 0 || output >= graph->node_count)
+  {
+    return 0;
+  }
+
+  /* nodes only reference earlier nodes, so index order is a topological order */
+  for (i = 0; i < graph->node_count; ++i)
+  {
+    live[i] = (i == output);
+    last_use[i] = i == output ? graph->node_count : -1;
+  }
+
+  for (i = output; i >= 0; --i)
+  {
+    if (live[i])
+    {
+      for (k = 0; k < noise_graph_arity(graph->nodes[i].op); ++k)
+      {
+        int in = graph->nodes[i].in[k];
+
+        live[in] = 1;
+        last_use[in] = last_use[in] > i ? last_use[in] : i;
+      }
+    }
+  }
+
+  for (i = 0; i <= output; ++i)
+  {
+    noise_graph_node *node = &graph->nodes[i];
+    int spill = -1;
+
+    if (!live[i])
+    {
+      continue;
+    }
+
+    if (node->op <= NOISE_OP_Z)
+    {
+      reg[i] = (unsigned char)node->op; /* input registers */
+      continue;
+    }
+
+    /* a VEC2_Y register was taken when its vector node was compiled */
+    if (node->op != NOISE_OP_VEC2_Y)
+    {
+      noise_instruction *ins = &program->code[program->count++];
+
+      reg[i] = free_count ? free_regs[--free_count] : (unsigned char)program->registers++;
+
+      ins->op = node->op;
+      ins->type = node->type;
+      ins->octaves = node->octaves;
+      ins->dst = reg[i];
+      ins->dst2 = 0;
+      ins->rotation = node->rotation;
+
+      if (node->op == NOISE_OP_VEC2_FBM_2)
+      {
+        int j = i + 1;
+
+        while (j <= output && !(live[j] && graph->nodes[j].op == NOISE_OP_VEC2_Y && graph->nodes[j].in[0] == i))
+        {
+          ++j;
+        }
+
+        /* an unused y still needs somewhere to go, released right after this instruction */
+        ins->dst2 = free_count ? free_regs[--free_count] : (unsigned char)program->registers++;
+
+        if (j <= output)
+        {
+          reg[j] = ins->dst2;
+        }
+        else
+        {
+          spill = ins->dst2;
+        }
+      }
+
+      for (k = 0; k < 4; ++k)
+      {
+        ins->param[k] = node->param[k];
+      }
+
+      for (k = 0; k < 3; ++k)
+      {
+        ins->in[k] = k < noise_graph_arity(node->op) ? reg[node->in[k]] : 0;
+      }
+    }
+
+    /* recycle input registers whose last consumer this was (after dst was taken, so no aliasing) */
+    for (k = 0; k < noise_graph_arity(node->op); ++k)
+    {
+      int in = node->in[k];
+
+      if (last_use[in] == i && graph->nodes[in].op > NOISE_OP_Z && (k == 0 || node->in[k] != node->in[0]) && (k < 2 || node->in[k] != node->in[1]))
+      {
+        free_regs[free_count++] = reg[in];
+      }
+    }
+
+    if (spill >= 0)
+    {
+      free_regs[free_count++] = (unsigned char)spill;
+    }
+  }
+
+  program->output = reg[output];
+
+  return 1;
+}
+
+/* floats of scratch noise_program_run needs */
+NOISE_API NOISE_INLINE int noise_program_scratch_size(noise_program *program)
+{
+  return (program->registers - NOISE_GRAPH_INPUTS + 1) * NOISE_BATCH_BLOCK;
+}
+
+/* evaluates program at count points, z may be 0 for 2D graphs */
+NOISE_API NOISE_INLINE void noise_program_run(noise_program *program, float *x, float *y, float *z, float *out, int count, float *scratch)
+{
+  float *r[NOISE_GRAPH_MAX_NODES + NOISE_GRAPH_INPUTS];
+  float *zeros = scratch + (program->registers - NOISE_GRAPH_INPUTS) * NOISE_BATCH_BLOCK;
+  int start, n, i, k;
+
+  for (k = NOISE_GRAPH_INPUTS; k < program->registers; ++k)
+  {
+    r[k] = scratch + (k - NOISE_GRAPH_INPUTS) * NOISE_BATCH_BLOCK;
+  }
+
+  for (i = 0; i < NOISE_BATCH_BLOCK; ++i)
+  {
+    zeros[i] = 0.0f;
+  }
+
+  for (start = 0; start < count; start += NOISE_BATCH_BLOCK)
+  {
+    n = count - start < NOISE_BATCH_BLOCK ? count - start : NOISE_BATCH_BLOCK;
+
+    /* the input registers alias the caller arrays */
+    r[0] = x + start;
+    r[1] = y + start;
+    r[2] = z ? z + start : zeros;
+
+    for (k = 0; k < program->count; ++k)
+    {
+      noise_instruction *ins = &program->code[k];
+      float *d = r[ins->dst], *a = r[ins->in[0]], *b = r[ins->in[1]], *c = r[ins->in[2]];
+      float p0 = ins->param[0], p1 = ins->param[1], p2 = ins->param[2], p3 = ins->param[3];
+
+      switch (ins->op)
+      {
+      case NOISE_OP_CONST:
+        for (i = 0; i < n; ++i)
+        {
+          d[i] = p0;
+        }
+        break;
+      case NOISE_OP_NOISE_2:
+        noise_batch_2(noise_function_2(ins->type), a, b, d, n, p0);
+        break;
+      case NOISE_OP_NOISE_3:
+        noise_batch_3(noise_function_3(ins->type), a, b, c, d, n, p0);
+        break;
+      case NOISE_OP_FBM_2:
+        noise_batch_2_fbm(noise_function_2(ins->type), a, b, d, n, p0, ins->octaves, p1, p2, (float (*)[2])ins->rotation);
+        break;
+      case NOISE_OP_FBM_3:
+        noise_batch_3_fbm(noise_function_3(ins->type), a, b, c, d, n, p0, ins->octaves, p1, p2, (float (*)[3])ins->rotation);
+        break;
+      case NOISE_OP_VEC2_FBM_2:
+        noise_simplex_2_vec2_fbm_batch_block(a, b, d, r[ins->dst2], n, p0, ins->octaves, p1, p2, (float (*)[2])ins->rotation);
+        break;
+      case NOISE_OP_ADD:
+        for (i = 0; i < n; ++i)
+        {
+          d[i] = a[i] + b[i];
+        }
+        break;
+      case NOISE_OP_SUB:
+        for (i = 0; i < n; ++i)
+        {
+          d[i] = a[i] - b[i];
+        }
+        break;
+      case NOISE_OP_MUL:
+        for (i = 0; i < n; ++i)
+        {
+          d[i] = a[i] * b[i];
+        }
+        break;
+      case NOISE_OP_MIN:
+        for (i = 0; i < n; ++i)
+        {
+          d[i] = a[i] < b[i] ? a[i] : b[i];
+        }
+        break;
+      case NOISE_OP_MAX:
+        for (i = 0; i < n; ++i)
+        {
+          d[i] = a[i] > b[i] ? a[i] : b[i];
+        }
+        break;
+      case NOISE_OP_ABS:
+        for (i = 0; i < n; ++i)
+        {
+          d[i] = a[i] < 0.0f ? -a[i] : a[i];
+        }
+        break;
+      case NOISE_OP_REMAP:
+      {
+        float scale = p1 != p0 ? (p3 - p2) / (p1 - p0) : 0.0f;
+
+        for (i = 0; i < n; ++i)
+        {
+          d[i] = p2 + (a[i] - p0) * scale;
+        }
+        break;
+      }
+      case NOISE_OP_SMOOTHSTEP:
+        for (i = 0; i < n; ++i)
+        {
+          d[i] = noise_smoothstep(p0, p1, a[i]);
+        }
+        break;
+      case NOISE_OP_SELECT:
+        for (i = 0; i < n; ++i)
+        {
+          float t = p1 > 0.0f ? noise_smoothstep(p0 - p1, p0 + p1, c[i]) : (c[i] > p0 ? 1.0f : 0.0f);
+          d[i] = a[i] + t * (b[i] - a[i]);
+        }
+        break;
+      default:
+        break;
+      }
+    }
+
+    for (i = 0; i < n; ++i)
+    {
+      out[start + i] = r[program->output][i];
+    }
+  }
+}
+
+/* #############################################################################
+ * # Fixed-point row functions
+ * #############################################################################
+ *
+ * Integer versions of noise_perlin_2, noise_simplex_2 and noise_value_2 for 8-bit and
+ * 16-bit mask and detail layers. A row of samples (origin, spacing) is walked with an int
+ * lattice cell plus a 0.32 fixed-point fraction, so there is no per-sample floor and the
+ * stepping does not drift. Only that row walk is 32-bit; it runs once per sample and is
+ * shared by all lanes of a vectorized loop.
+ *
+ * The per-sample math (fade, gradient dots, interpolation) is int16 throughout, so it maps
+ * onto 16 lanes of AVX2 (8 of SSE2/NEON). Every product is noise_q15_mul, the rounded
+ * (a * b) >> 15 of pmulhrsw, every add either provably fits or saturates like paddsw
+ * (noise_q15_sat). Gradients are -1, 0 or 1, so dots are sign selects. Formats are chosen
+ * per quantity to stay inside int16:
+ *
+ *   fractions, fade weights, results          Q15
+ *   fade on [0, 1/2]: s, s^2, s^3             Q16, Q17, Q18
+ *   Perlin dots and lerps (|difference| < 3)  Q13
+ *   value-noise x term (|difference| < 2)     Q14
+ *   simplex corner 16 t^4 (g . d)             Q15, scaled by 70 / 16 at the end
+ *
+ * Hashed gradients and value-noise corners are fetched once per lattice cell and reused
+ * until the row crosses into the next one.
+ *
+ * Results are in [-32767, 32767] for [-1, 1]. Maximum absolute error against the float
+ * functions, measured over 512x512 grids at frequencies 0.013 to 1.7: perlin < 4e-4,
+ * simplex < 1.5e-3, value < 6e-4, all below a fifth of one 8-bit step of [-1, 1]
+ * (7.8e-3). Right shifts of negative values are assumed to be arithmetic.
+ */
+#define NOISE_Q15_HALF 16384
+#define NOISE_Q15_ONE 32768
+#define NOISE_Q15_SQRT_HALF 23170 /* sqrt(1/2) */
+#define NOISE_Q15_SIMPLEX_G2 6925 /* NOISE_SIMPLEX_G2 */
+
+/* splits v into a lattice cell and a 0.32 fixed-point fraction */
+NOISE_API NOISE_INLINE void noise_q15_split(float v, int *cell, unsigned int *frac)
+{
+  float f = noise_floor(v);
+  float t = v - f;
+
+  *cell = (int)f;
+
+  if (t >= 1.0f)
+  {
+    /* tiny negative v rounds up to exactly one */
+    *cell += 1;
+    t = 0.0f;
+  }
+
+  *frac = (unsigned int)(t * 4294967296.0f);
+}
+
+/* one step along a row, the fraction overflow carries into the cell */
+NOISE_API NOISE_INLINE void noise_q15_step(int *cell, unsigned int *frac, int step_cell, unsigned int step_frac)
+{
+  unsigned int f = *frac + step_frac;
+
+  *cell += step_cell + (f < *frac);
+  *frac = f;
+}
+
+/* (a * b) >> 15 rounded, the pmulhrsw lane operation */
+NOISE_API NOISE_INLINE short noise_q15_mul(short a, short b)
+{
+  return (short)(((int)a * (int)b + (1 << 14)) >> 15);
+}
+
+/* saturating int16 add/sub result, the paddsw/psubsw lane operation */
+NOISE_API NOISE_INLINE short noise_q15_sat(int v)
+{
+  return (short)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+}
+
+NOISE_API NOISE_INLINE short noise_q15_clamp(int v)
+{
+  return (short)(v > 32767 ? 32767 : (v < -32767 ? -32767 : v));
+}
+
+/* quintic fade in Q15, within 3 units of noise_fade and never above 32767 */
+NOISE_API NOISE_INLINE short noise_q15_fade(short t)
+{
+  /* fade(1 - t) = 1 - fade(t): on s in [0, 1/2] the powers fit int16 at Q16, Q17 and Q18 */
+  short s = (short)(t > NOISE_Q15_HALF ? NOISE_Q15_ONE - t : t);
+  short s1 = (short)(s < NOISE_Q15_HALF ? 2 * s : 32767);                           /* Q16 */
+  short s2 = noise_q15_mul(s1, s1);                                                 /* Q17 */
+  short s3 = noise_q15_mul(s2, s1);                                                 /* Q18 */
+  short p = (short)(noise_q15_mul(s2, 3072) - noise_q15_mul(s1, 15360) + 20480); /* (6s^2 - 15s + 10) / 16 */
+  short f = (short)(2 * noise_q15_mul(s3, p));
+
+  return (short)(t > NOISE_Q15_HALF ? (f > 0 ? NOISE_Q15_ONE - f : 32767) : f);
+}
+
+NOISE_API NOISE_INLINE void noise_perlin_2_row_q15(short *out, int count, float x, float y, float spacing, float frequency)
+{
+  int cx, cy, step_cell, i;
+  int cell = 0, cached = 0;
+  short g[4] = {0, 0, 0, 0}; /* x gradient of the corners (0,0), (1,0), (0,1), (1,1) */
+  short c[4] = {0, 0, 0, 0}; /* y part of their dot products in Q13, constant along the row */
+  short yf, v;
+  unsigned int fx, fy, step_frac;
+
+  NOISE_PROFILE_SAMPLES(count);
+
+  noise_q15_split(x * frequency, &cx, &fx);
+  noise_q15_split(y * frequency, &cy, &fy);
+  noise_q15_split(spacing * frequency, &step_cell, &step_frac);
+
+  yf = (short)(fy >> 17);
+  v = noise_q15_fade(yf);
+
+  for (i = 0; i < count; ++i)
+  {
+    short xf = (short)(fx >> 17);
+    short hx = (short)(xf >> 2), hx1 = (short)(hx - 8192); /* x and x - 1 in Q13 */
+    short u, d0, d1, d2, d3, x1, x2, r;
+
+    if (!cached || cx != cell)
+    {
+      int X = cx & 255, Y = cy & 255;
+      int aa = noise_permutations[noise_permutations[X] + Y] & 7;
+      int ba = noise_permutations[noise_permutations[X + 1] + Y] & 7;
+      int ab = noise_permutations[noise_permutations[X] + Y + 1] & 7;
+      int bb = noise_permutations[noise_permutations[X + 1] + Y + 1] & 7;
+      short hy = (short)(yf >> 2), hy1 = (short)(hy - 8192);
+
+      g[0] = (short)noise_gradient_2_lut[aa][0];
+      g[1] = (short)noise_gradient_2_lut[ba][0];
+      g[2] = (short)noise_gradient_2_lut[ab][0];
+      g[3] = (short)noise_gradient_2_lut[bb][0];
+      c[0] = (short)((int)noise_gradient_2_lut[aa][1] * hy);
+      c[1] = (short)((int)noise_gradient_2_lut[ba][1] * hy);
+      c[2] = (short)((int)noise_gradient_2_lut[ab][1] * hy1);
+      c[3] = (short)((int)noise_gradient_2_lut[bb][1] * hy1);
+
+      cell = cx;
+      cached = 1;
+    }
+
+    u = noise_q15_fade(xf);
+
+    /* gradients are -1, 0 or 1, so the dots are sign selects (psignw) and adds */
+    d0 = (short)(g[0] * hx + c[0]);
+    d1 = (short)(g[1] * hx1 + c[1]);
+    d2 = (short)(g[2] * hx + c[2]);
+    d3 = (short)(g[3] * hx1 + c[3]);
+
+    /* neighbouring dots differ by at most 3, which fits Q13 */
+    x1 = (short)(d0 + noise_q15_mul((short)(d1 - d0), u));
+    x2 = (short)(d2 + noise_q15_mul((short)(d3 - d2), u));
+    r = (short)(x1 + noise_q15_mul((short)(x2 - x1), v));
+
+    out[i] = noise_q15_clamp(2 * noise_q15_mul(noise_q15_sat(2 * r), NOISE_Q15_SQRT_HALF)); /* Q13 -> Q15 and normalize */
+
+    noise_q15_step(&cx, &fx, step_cell, step_frac);
+  }
+}
+
+/* contribution of one simplex corner as 16 t^4 (g . d) in Q15, with t = 1/2 - |d|^2 */
+NOISE_API NOISE_INLINE short noise_q15_simplex_corner(short g[2], short x, short y)
+{
+  short xx = noise_q15_mul(x, x), yy = noise_q15_mul(y, y);
+  short a = noise_q15_sat(noise_q15_sat(32767 - noise_q15_sat(xx + xx)) - noise_q15_sat(yy + yy)); /* 2t */
+
+  if (a <= 0)
+  {
+    return 0;
+  }
+
+  a = noise_q15_mul(a, a);
+  a = noise_q15_mul(a, a); /* (2t)^4 */
+
+  return noise_q15_mul(a, noise_q15_sat(g[0] * x + g[1] * y));
+}
+
+NOISE_API NOISE_INLINE void noise_simplex_2_row_q15(short *out, int count, float x, float y, float spacing, float frequency)
+{
+  int ci, cj, step_ci, step_cj, i, k;
+  int cell_i = 0, cell_j = 0, cached = 0;
+  short g[4][2] = {{0, 0}, {0, 0}, {0, 0}, {0, 0}}; /* gradients of the skewed cell corners (0,0), (1,0), (0,1), (1,1) */
+  unsigned int fi, fj, step_fi, step_fj;
+  float s;
+
+  NOISE_PROFILE_SAMPLES(count);
+
+  x *= frequency;
+  y *= frequency;
+  spacing *= frequency;
+
+  /* walk the row in skewed space, where the simplex lattice is integer */
+  s = (x + y) * NOISE_SIMPLEX_F2;
+  noise_q15_split(x + s, &ci, &fi);
+  noise_q15_split(y + s, &cj, &fj);
+  noise_q15_split(spacing * (1.0f + NOISE_SIMPLEX_F2), &step_ci, &step_fi);
+  noise_q15_split(spacing * NOISE_SIMPLEX_F2, &step_cj, &step_fj);
+
+  for (i = 0; i < count; ++i)
+  {
+    short fx = (short)(fi >> 17), fy = (short)(fj >> 17);
+    short t = (short)(noise_q15_mul(fx, NOISE_Q15_SIMPLEX_G2) + noise_q15_mul(fy, NOISE_Q15_SIMPLEX_G2));
+    short x0 = (short)(fx - t), y0 = (short)(fy - t); /* unskewed offset from the cell origin */
+    int i1 = fx > fy;
+    short n;
+
+    if (!cached || ci != cell_i || cj != cell_j)
+    {
+      int ii = ci & 255, jj = cj & 255;
+      int corner[4];
+
+      corner[0] = noise_permutations[ii + noise_permutations[jj]] & 7;
+      corner[1] = noise_permutations[ii + 1 + noise_permutations[jj]] & 7;
+      corner[2] = noise_permutations[ii + noise_permutations[jj + 1]] & 7;
+      corner[3] = noise_permutations[ii + 1 + noise_permutations[jj + 1]] & 7;
+
+      for (k = 0; k < 4; ++k)
+      {
+        g[k][0] = (short)noise_gradient_2_lut[corner[k]][0];
+        g[k][1] = (short)noise_gradient_2_lut[corner[k]][1];
+      }
+
+      cell_i = ci;
+      cell_j = cj;
+      cached = 1;
+    }
+
+    /* the middle corner is (1,0) or (0,1); every offset stays inside (-1, 1) */
+    n = noise_q15_simplex_corner(g[0], x0, y0);
+    n = (short)(n + noise_q15_simplex_corner(g[i1 ? 1 : 2],
+                                             (short)(i1 ? x0 - (NOISE_Q15_ONE - NOISE_Q15_SIMPLEX_G2) : x0 + NOISE_Q15_SIMPLEX_G2),
+                                             (short)(i1 ? y0 + NOISE_Q15_SIMPLEX_G2 : y0 - (NOISE_Q15_ONE - NOISE_Q15_SIMPLEX_G2))));
+    n = (short)(n + noise_q15_simplex_corner(g[3], (short)(x0 - (NOISE_Q15_ONE - 2 * NOISE_Q15_SIMPLEX_G2)), (short)(y0 - (NOISE_Q15_ONE - 2 * NOISE_Q15_SIMPLEX_G2))));
+
+    out[i] = noise_q15_clamp(4 * n + noise_q15_mul(n, 12288)); /* 70 / 16 = 4.375 */
+
+    noise_q15_step(&ci, &fi, step_ci, step_fi);
+    noise_q15_step(&cj, &fj, step_cj, step_fj);
+  }
+}
+
+NOISE_API NOISE_INLINE void noise_value_2_row_q15(short *out, int count, float x, float y, float spacing, float frequency)
+{
+  int cx, cy, step_cell, i;
+  int cell = 0, cached = 0;
+  short uy;
+  short k02 = 0, k14 = 0; /* bilinear terms with the row's y weight folded in, Q15 and Q14 */
+  unsigned int fx, fy, step_frac;
+
+  NOISE_PROFILE_SAMPLES(count);
+
+  noise_q15_split(x * frequency, &cx, &fx);
+  noise_q15_split(y * frequency, &cy, &fy);
+  noise_q15_split(spacing * frequency, &step_cell, &step_frac);
+
+  uy = noise_q15_fade((short)(fy >> 17));
+
+  for (i = 0; i < count; ++i)
+  {
+    short r;
+
+    if (!cached || cx != cell)
+    {
+      float px = (float)cx, py = (float)cy;
+      short a = (short)(noise_hash(px + 317.0f * py + 0.0f) * 32767.0f + 0.5f);
+      short b = (short)(noise_hash(px + 317.0f * py + 1.0f) * 32767.0f + 0.5f);
+      short c = (short)(noise_hash(px + 317.0f * (py + 1.0f) + 0.0f) * 32767.0f + 0.5f);
+      short d = (short)(noise_hash(px + 317.0f * (py + 1.0f) + 1.0f) * 32767.0f + 0.5f);
+      short ba = (short)((b - a) >> 1), dc = (short)((d - c) >> 1);
+
+      k02 = (short)(a + noise_q15_mul((short)(c - a), uy));
+      k14 = (short)(ba + noise_q15_mul((short)(dc - ba), uy));
+
+      cell = cx;
+      cached = 1;
+    }
+
+    r = noise_q15_sat(k02 + 2 * noise_q15_mul(k14, noise_q15_fade((short)(fx >> 17))));
+
+    out[i] = noise_q15_clamp(2 * (r - NOISE_Q15_HALF));
+
+    noise_q15_step(&cx, &fx, step_cell, step_frac);
+  }
+}
+
+/* fills a width x height tile of Q15 samples, row by row */
+NOISE_API NOISE_INLINE void noise_tile_2_q15(short *tile, int width, int height, noise_type type, float origin_x, float origin_y, float spacing, float frequency)
+{
+  int y;
+
+  for (y = 0; y < height; ++y)
+  {
+    short *row = tile + y * width;
+    float py = origin_y + (float)y * spacing;
+
+    switch (type)
+    {
+    case NOISE_TYPE_SIMPLEX:
+      noise_simplex_2_row_q15(row, width, origin_x, py, spacing, frequency);
+      break;
+    case NOISE_TYPE_VALUE:
+      noise_value_2_row_q15(row, width, origin_x, py, spacing, frequency);
+      break;
+    case NOISE_TYPE_PERLIN:
+    default:
+      noise_perlin_2_row_q15(row, width, origin_x, py, spacing, frequency);
+      break;
+    }
+  }
+}
+
+/* maps Q15 samples onto [0, 255] for 8-bit layers */
+NOISE_API NOISE_INLINE void noise_q15_to_u8(short *src, int count, unsigned char *dst)
+{
+  int i;
+
+  for (i = 0; i < count; ++i)
+  {
+    dst[i] = (unsigned char)(((int)src[i] + NOISE_Q15_ONE) >> 8);
+  }
+}
+
+/* #############################################################################
+ * # Heightfield pyramid functions
+ * #############################################################################
+ *
+ * Min/max pyramid over a heightmap for ray and line-of-sight queries. The surface is the
+ * bilinear interpolation of the samples, heightmap[y * width + x] sits at (x, y), and
+ * rays are given in the same units (x, y in samples, z in height).
+ *
+ * Level 0 holds the min/max of every cell (the 2x2 samples spanning it), and each level
+ * above the min/max of 2x2 nodes below, up to a single node. A ray starts at the top and
+ * skips every node whose max lies below the ray segment crossing it. A skip moves to
+ * the next node along the ray on the same level and then up a level; a node the ray may
+ * touch is split into the child the ray is in. Children are chosen by comparing ray
+ * parameters at the split lines, the same expressions that produced the node exits, so
+ * float rounding cannot make the traversal step over a node. Cells that are reached
+ * are intersected exactly with their bilinear patch.
+ *
+ * The caller provides the node storage (noise_pyramid_size floats). After editing a
+ * region of the heightmap (brushes, erosion of a tile), noise_pyramid_update rebuilds only
+ * the nodes above that region.
+ */
+#define NOISE_PYRAMID_MAX_LEVELS 32
+
+typedef struct noise_pyramid
+{
+  float *heightmap;
+  int width;
+  int height;
+  float *nodes; /* min/max pairs, level by level */
+  int levels;
+  int level_width[NOISE_PYRAMID_MAX_LEVELS];
+  int level_height[NOISE_PYRAMID_MAX_LEVELS];
+  int level_offset[NOISE_PYRAMID_MAX_LEVELS];
+
+} noise_pyramid;
+
+/* floats of node storage for a width x height heightmap, 0 if it has no cells */
+NOISE_API NOISE_INLINE int noise_pyramid_size(int width, int height)
+{
+  int w = width - 1, h = height - 1, size = 0;
+
+  if (w < 1 || h < 1)
+  {
+    return 0;
+  }
+
+  for (;;)
+  {
+    size += 2 * w * h;
+
+    if (w == 1 && h == 1)
+    {
+      return size;
+    }
+
+    w = (w + 1) / 2;
+    h = (h + 1) / 2;
+  }
+}
+
+/* recomputes the nodes [x0, x1) x [y0, y1) of a level from the level below (or the samples) */
+NOISE_API NOISE_INLINE void noise_pyramid_reduce(noise_pyramid *pyramid, int level, int x0, int y0, int x1, int y1)
+{
+  float *dst = pyramid->nodes + 2 * pyramid->level_offset[level];
+  int lw = pyramid->level_width[level];
+  int x, y;
+
+  for (y = y0; y < y1; ++y)
+  {
+    for (x = x0; x < x1; ++x)
+    {
+      float lo, hi;
+
+      if (level == 0)
+      {
+        float *s = pyramid->heightmap + y * pyramid->width + x;
+        float a = s[0], b = s[1], c = s[pyramid->width], d = s[pyramid->width + 1];
+        float ab_lo = a < b ? a : b, ab_hi = a < b ? b : a;
+        float cd_lo = c < d ? c : d, cd_hi = c < d ? d : c;
+
+        lo = ab_lo < cd_lo ? ab_lo : cd_lo;
+        hi = ab_hi > cd_hi ? ab_hi : cd_hi;
+      }
+      else
+      {
+        float *src = pyramid->nodes + 2 * pyramid->level_offset[level - 1];
+        int cw = pyramid->level_width[level - 1], ch = pyramid->level_height[level - 1];
+        int cx, cy;
+
+        lo = src[2 * (2 * y * cw + 2 * x)];
+        hi = src[2 * (2 * y * cw + 2 * x) + 1];
+
+        /* odd sizes: the last node of a row/column has fewer children */
+        for (cy = 2 * y; cy < 2 * y + 2 && cy < ch; ++cy)
+        {
+          for (cx = 2 * x; cx < 2 * x + 2 && cx < cw; ++cx)
+          {
+            float *n = src + 2 * (cy * cw + cx);
+            lo = n[0] < lo ? n[0] : lo;
+            hi = n[1] > hi ? n[1] : hi;
+          }
+        }
+      }
+
+      dst[2 * (y * lw + x)] = lo;
+      dst[2 * (y * lw + x) + 1] = hi;
+    }
+  }
+}
+
+/* returns 0 if the heightmap has no cells (width or height < 2) */
+NOISE_API NOISE_INLINE int noise_pyramid_build(noise_pyramid *pyramid, float *heightmap, int width, int height, float *nodes)
+{
+  int w = width - 1, h = height - 1, offset = 0, level;
+
+  if (w < 1 || h < 1)
+  {
+    return 0;
+  }
+
+  pyramid->heightmap = heightmap;
+  pyramid->width = width;
+  pyramid->height = height;
+  pyramid->nodes = nodes;
+
+  for (level = 0;; ++level)
+  {
+    pyramid->level_width[level] = w;
+    pyramid->level_height[level] = h;
+    pyramid->level_offset[level] = offset;
+    offset += w * h;
+
+    if (w == 1 && h == 1)
+    {
+      break;
+    }
+
+    w = (w + 1) / 2;
+    h = (h + 1) / 2;
+  }
+
+  pyramid->levels = level + 1;
+
+  for (level = 0; level < pyramid->levels; ++level)
+  {
+    noise_pyramid_reduce(pyramid, level, 0, 0, pyramid->level_width[level], pyramid->level_height[level]);
+  }
+
+  return 1;
+}
+
+/* the samples [x0, x1) x [y0, y1) of the heightmap changed */
+NOISE_API NOISE_INLINE void noise_pyramid_update(noise_pyramid *pyramid, int x0, int y0, int x1, int y1)
+{
+  int level;
+
+  /* cell c spans samples c and c + 1 */
+  x0 = x0 - 1 > 0 ? x0 - 1 : 0;
+  y0 = y0 - 1 > 0 ? y0 - 1 : 0;
+  x1 = x1 < pyramid->level_width[0] ? x1 : pyramid->level_width[0];
+  y1 = y1 < pyramid->level_height[0] ? y1 : pyramid->level_height[0];
+
+  for (level = 0; level < pyramid->levels && x0 < x1 && y0 < y1; ++level)
+  {
+    noise_pyramid_reduce(pyramid, level, x0, y0, x1, y1);
+
+    x0 >>= 1;
+    y0 >>= 1;
+    x1 = ((x1 - 1) >> 1) + 1;
+    y1 = ((y1 - 1) >> 1) + 1;
+  }
+}
+
+/* first t in [t0, t1] where the ray is on or below the bilinear patch of cell (cx, cy) */
+NOISE_API NOISE_INLINE int noise_pyramid_cell_hit(noise_pyramid *pyramid, int cx, int cy, float origin[3], float direction[3], float t0, float t1, float *t_hit)
+{
+  float *s = pyramid->heightmap + cy * pyramid->width + cx;
+  float k1 = s[1] - s[0], k2 = s[pyramid->width] - s[0];
+  float k4 = s[0] - s[1] - s[pyramid->width] + s[pyramid->width + 1];
+  float au = origin[0] - (float)cx, av = origin[1] - (float)cy;
+  float dx = direction[0], dy = direction[1];
+
+  /* z(t) - h(u(t), v(t)) = a t^2 + b t + c */
+  float a = -k4 * dx * dy;
+  float b = direction[2] - k1 * dx - k2 * dy - k4 * (au * dy + av * dx);
+  float c = origin[2] - s[0] - k1 * au - k2 * av - k4 * au * av;
+  float lo = t0, hi = t1;
+  int i;
+
+  if ((a * t0 + b) * t0 + c <= 0.0f)
+  {
+    *t_hit = t0;
+    return 1;
+  }
+
+  if ((a * t1 + b) * t1 + c > 0.0f)
+  {
+    /* both ends above: only a dip in between can reach the patch */
+    float tv = a > 0.0f ? -b / (2.0f * a) : t0;
+
+    if (tv <= t0 || tv >= t1 || (a * tv + b) * tv + c > 0.0f)
+    {
+      return 0;
+    }
+
+    hi = tv;
+  }
+
+  /* bracketed: above at lo, on or below at hi */
+  for (i = 0; i < 24; ++i)
+  {
+    float mid = 0.5f * (lo + hi);
+
+    if ((a * mid + b) * mid + c > 0.0f)
+    {
+      lo = mid;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+
+  *t_hit = hi;
+  return 1;
+}
+
+/* ray parameter where it leaves node on the given axis, every node edge and split line goes through here */
+NOISE_API NOISE_INLINE float noise_pyramid_edge(noise_pyramid *pyramid, int level, int node[2], float direction[3], float origin[3], float inv[2], int axis)
+{
+  int edge = direction[axis] > 0.0f ? node[axis] + 1 : node[axis];
+  int limit = axis == 0 ? pyramid->level_width[0] : pyramid->level_height[0];
+  float bound = (float)((edge << level) < limit ? edge << level : limit);
+
+  return (bound - origin[axis]) * inv[axis];
+}
+
+/*
+ * First intersection of origin + t * direction, t in [0, t_max], with the heightfield.
+ * Returns 1 and writes t_hit on a hit (a ray starting below the surface hits at its first
+ * point over the map), 0 if the ray misses or only passes outside the map.
+ */
+NOISE_API NOISE_INLINE int noise_pyramid_raycast(noise_pyramid *pyramid, float origin[3], float direction[3], float t_max, float *t_hit)
+{
+  float inv[2], t = 0.0f, t_end = t_max;
+  float size[2];
+  int node[2], level, axis;
+
+  size[0] = (float)(pyramid->width - 1);
+  size[1] = (float)(pyramid->height - 1);
+
+  /* clip to the map */
+  for (axis = 0; axis < 2; ++axis)
+  {
+    float d = direction[axis];
+
+    if (d == 0.0f)
+    {
+      if (origin[axis] < 0.0f || origin[axis] > size[axis])
+      {
+        return 0;
+      }
+
+      inv[axis] = 0.0f;
+    }
+    else
+    {
+      float ta, tb;
+
+      inv[axis] = 1.0f / d;
+      ta = (0.0f - origin[axis]) * inv[axis];
+      tb = (size[axis] - origin[axis]) * inv[axis];
+
+      if (ta > tb)
+      {
+        float swap = ta;
+        ta = tb;
+        tb = swap;
+      }
+
+      t = ta > t ? ta : t;
+      t_end = tb < t_end ? tb : t_end;
+    }
+  }
+
+  if (t > t_end)
+  {
+    return 0;
+  }
+
+  level = pyramid->levels - 1;
+  node[0] = node[1] = 0;
+
+  for (;;)
+  {
+    float *n = pyramid->nodes + 2 * (pyramid->level_offset[level] + node[1] * pyramid->level_width[level] + node[0]);
+    float t_exit = t_end, z0, z1;
+    int exit_axis = -1;
+
+    /* where the ray leaves this node */
+    for (axis = 0; axis < 2; ++axis)
+    {
+      if (inv[axis] != 0.0f)
+      {
+        float te = noise_pyramid_edge(pyramid, level, node, direction, origin, inv, axis);
+
+        if (te < t_exit)
+        {
+          t_exit = te;
+          exit_axis = axis;
+        }
+      }
+    }
+
+    t_exit = t_exit > t ? t_exit : t;
+    z0 = origin[2] + direction[2] * t;
+    z1 = origin[2] + direction[2] * t_exit;
+
+    if (z0 <= n[0])
+    {
+      /* already under the lowest point of the node */
+      *t_hit = t;
+      return 1;
+    }
+
+    if (z0 <= n[1] || z1 <= n[1])
+    {
+      if (level > 0)
+      {
+        /* descend into the child holding t, decided on ray parameters at the split lines */
+        level--;
+
+        for (axis = 0; axis < 2; ++axis)
+        {
+          int child = node[axis] * 2;
+          int limit = axis == 0 ? pyramid->level_width[level] : pyramid->level_height[level];
+
+          if (child + 1 < limit)
+          {
+            float split = (float)((child + 1) << level);
+            float ts = (split - origin[axis]) * inv[axis];
+
+            if (inv[axis] == 0.0f)
+            {
+              child += origin[axis] >= split;
+            }
+            else
+            {
+              child += direction[axis] > 0.0f ? t >= ts : t < ts;
+            }
+          }
+
+          node[axis] = child;
+        }
+
+        continue;
+      }
+
+      if (noise_pyramid_cell_hit(pyramid, node[0], node[1], origin, direction, t, t_exit, t_hit))
+      {
+        return 1;
+      }
+    }
+
+    /* the segment passes above: step to the next node along the ray and go up a level */
+    if (exit_axis < 0)
+    {
+      return 0;
+    }
+
+    for (axis = 0; axis < 2; ++axis)
+    {
+      if (inv[axis] != 0.0f && (axis == exit_axis || noise_pyramid_edge(pyramid, level, node, direction, origin, inv, axis) == t_exit))
+      {
+        node[axis] += direction[axis] > 0.0f ? 1 : -1;
+      }
+    }
+
+    if (node[0] < 0 || node[1] < 0 || node[0] >= pyramid->level_width[level] || node[1] >= pyramid->level_height[level])
+    {
+      return 0;
+    }
+
+    t = t_exit;
+
+    if (level < pyramid->levels - 1)
+    {
+      level++;
+      node[0] >>= 1;
+      node[1] >>= 1;
+    }
+  }
+}
+
+/* 1 if the segment between two points above the surface does not pass below it */
+NOISE_API NOISE_INLINE int noise_pyramid_visible(noise_pyramid *pyramid, float from[3], float to[3])
+{
+  float direction[3], t;
+
+  direction[0] = to[0] - from[0];
+  direction[1] = to[1] - from[1];
+  direction[2] = to[2] - from[2];
+
+  return !noise_pyramid_raycast(pyramid, from, direction, 1.0f, &t);
+}
+
+/* origins and directions are xyz triples, t_hit[i] is -1 on a miss; returns the number of hits */
+NOISE_API NOISE_INLINE int noise_pyramid_raycast_batch(noise_pyramid *pyramid, float *origins, float *directions, float t_max, float *t_hit, int count)
+{
+  int i, hits = 0;
+
+  for (i = 0; i < count; ++i)
+  {
+    if (noise_pyramid_raycast(pyramid, origins + 3 * i, directions + 3 * i, t_max, &t_hit[i]))
+    {
+      hits++;
+    }
+    else
+    {
+      t_hit[i] = -1.0f;
+    }
+  }
+
+  return hits;
+}
+
+/* from and to are xyz triples; returns the number of visible pairs */
+NOISE_API NOISE_INLINE int noise_pyramid_visible_batch(noise_pyramid *pyramid, float *from, float *to, unsigned char *visible, int count)
+{
+  int i, seen = 0;
+
+  for (i = 0; i < count; ++i)
+  {
+    visible[i] = (unsigned char)noise_pyramid_visible(pyramid, from + 3 * i, to + 3 * i);
+    seen += visible[i];
+  }
+
+  return seen;
+}
+
+/* #############################################################################
+ * # Memory layout functions
+ * #############################################################################
+ *
+ * Heightmaps default to row-major storage, heightmap[y * width + x]. On wide maps the
+ * vertical neighbours of a cell are a whole row apart, so neighbourhood passes touch a
+ * new cache line and often a new page for every row above and below. A noise_layout
+ * describes an alternative storage order built from square tiles of 2^tile_shift
+ * samples, stored one after another in row-major tile order:
+ *
+ *   NOISE_LAYOUT_TILED   samples inside a tile are row-major
+ *   NOISE_LAYOUT_MORTON  samples inside a tile follow the Z-order curve
+ *
+ * The map is padded to whole tiles, so noise_layout_size can exceed width * height;
+ * padding samples are never read. NOISE_LAYOUT_ROW_MAJOR is the plain layout every other
+ * function uses, so the layout functions below accept any map.
+ *
+ * Rows are accessed in runs: a run stays contiguous across a tile row and steps to the
+ * next tile at tile borders, Morton runs advance the interleaved index incrementally.
+ * noise_layout_read_row/write_row feed row based producers and exporters,
+ * noise_layout_convert moves whole maps between layouts in cache sized blocks.
+ */
+#define NOISE_LAYOUT_MAX_SHIFT 15
+#define NOISE_LAYOUT_BLOCK_SHIFT 6
+
+typedef enum noise_layout_type
+{
+  NOISE_LAYOUT_ROW_MAJOR = 0,
+  NOISE_LAYOUT_TILED,
+  NOISE_LAYOUT_MORTON
+
+} noise_layout_type;
+
+typedef struct noise_layout
+{
+  noise_layout_type type;
+  int width;
+  int height;
+  int tile_shift; /* tile edge is 1 << tile_shift samples, unused for row-major */
+  int tiles_x;
+  int tiles_y;
+
+} noise_layout;
+
+/* returns 0 for an invalid size or tile shift */
+NOISE_API NOISE_INLINE int noise_layout_init(noise_layout *layout, noise_layout_type type, int width, int height, int tile_shift)
+{
+  static noise_layout zero;
+
+  *layout = zero;
+
+  if (width < 1 || height < 1)
+  {
+    return 0;
+  }
+
+  layout->type = type;
+  layout->width = width;
+  layout->height = height;
+
+  if (type == NOISE_LAYOUT_ROW_MAJOR)
+  {
+    layout->tiles_x = 1;
+    layout->tiles_y = 1;
+    return 1;
+  }
+
+  if (tile_shift < 1 || tile_shift > NOISE_LAYOUT_MAX_SHIFT)
+  {
+    return 0;
+  }
+
+  layout->tile_shift = tile_shift;
+  layout->tiles_x = (width + (1 << tile_shift) - 1) >> tile_shift;
+  layout->tiles_y = (height + (1 << tile_shift) - 1) >> tile_shift;
+
+  return 1;
+}
+
+/* number of floats a map in this layout occupies, including tile padding */
+NOISE_API NOISE_INLINE int noise_layout_size(noise_layout *layout)
+{
+  if (layout->type == NOISE_LAYOUT_ROW_MAJOR)
+  {
+    return layout->width * layout->height;
+  }
+
+  return (layout->tiles_x * layout->tiles_y) << (2 * layout->tile_shift);
+}
+
+/* spreads the low 16 bits of v onto the even bits */
+NOISE_API NOISE_INLINE unsigned int noise_morton_spread(unsigned int v)
+{
+  v &= 0xffffu;
+  v = (v | (v << 8)) & 0x00ff00ffu;
+  v = (v | (v << 4)) & 0x0f0f0f0fu;
+  v = (v | (v << 2)) & 0x33333333u;
+  v = (v | (v << 1)) & 0x55555555u;
+  return v;
+}
+
+NOISE_API NOISE_INLINE int noise_layout_index(noise_layout *layout, int x, int y)
+{
+  int s = layout->tile_shift;
+  int m = (1 << s) - 1;
+
+  switch (layout->type)
+  {
+  case NOISE_LAYOUT_TILED:
+    return (((y >> s) * layout->tiles_x + (x >> s)) << (2 * s)) + ((y & m) << s) + (x & m);
+  case NOISE_LAYOUT_MORTON:
+    return (((y >> s) * layout->tiles_x + (x >> s)) << (2 * s)) +
+           (int)(noise_morton_spread((unsigned int)(x & m)) | (noise_morton_spread((unsigned int)(y & m)) << 1));
+  case NOISE_LAYOUT_ROW_MAJOR:
+  default:
+    return y * layout->width + x;
+  }
+}
+
+NOISE_API NOISE_INLINE void noise_layout_copy(float *data, float *row, int count, int write)
+{
+  int i;
+
+  if (write)
+  {
+    for (i = 0; i < count; ++i)
+    {
+      data[i] = row[i];
+    }
+  }
+  else
+  {
+    for (i = 0; i < count; ++i)
+    {
+      row[i] = data[i];
+    }
+  }
+}
+
+/* copies samples [x, x + count) of row y between a layout map and a plain row,
+ * write != 0 stores row into data, otherwise data is read into row */
+NOISE_API NOISE_INLINE void noise_layout_run(float *data, noise_layout *layout, int x, int y, int count, float *row, int write)
+{
+  int s = layout->tile_shift;
+  int m = (1 << s) - 1;
+  int i;
+
+  if (layout->type == NOISE_LAYOUT_ROW_MAJOR)
+  {
+    noise_layout_copy(data + y * layout->width + x, row, count, write);
+    return;
+  }
+
+  while (count > 0)
+  {
+    /* part of the run inside the current tile */
+    int n = (m + 1) - (x & m);
+    float *tile = data + ((((y >> s) * layout->tiles_x + (x >> s)) << (2 * s)));
+
+    if (n > count)
+    {
+      n = count;
+    }
+
+    if (layout->type == NOISE_LAYOUT_TILED)
+    {
+      noise_layout_copy(tile + ((y & m) << s) + (x & m), row, n, write);
+    }
+    else
+    {
+      unsigned int my = noise_morton_spread((unsigned int)(y & m)) << 1;
+      unsigned int mx = noise_morton_spread((unsigned int)(x & m));
+
+      /* x advances in its interleaved form: filling the odd bits lets the carry skip them */
+      if (write)
+      {
+        for (i = 0; i < n; ++i)
+        {
+          tile[mx | my] = row[i];
+          mx = ((mx | 0xaaaaaaaau) + 1u) & 0x55555555u;
+        }
+      }
+      else
+      {
+        for (i = 0; i < n; ++i)
+        {
+          row[i] = tile[mx | my];
+          mx = ((mx | 0xaaaaaaaau) + 1u) & 0x55555555u;
+        }
+      }
+    }
+
+    x += n;
+    row += n;
+    count -= n;
+  }
+}
+
+NOISE_API NOISE_INLINE void noise_layout_read_row(float *data, noise_layout *layout, int y, float *row)
+{
+  noise_layout_run(data, layout, 0, y, layout->width, row, 0);
+}
+
+NOISE_API NOISE_INLINE void noise_layout_write_row(float *data, noise_layout *layout, int y, float *row)
+{
+  noise_layout_run(data, layout, 0, y, layout->width, row, 1);
+}
+
+/* edge of the blocks that stay inside one tile of every given layout */
+NOISE_API NOISE_INLINE int noise_layout_block_shift(noise_layout *a, noise_layout *b)
+{
+  int shift = NOISE_LAYOUT_BLOCK_SHIFT;
+
+  if (a->type != NOISE_LAYOUT_ROW_MAJOR && a->tile_shift < shift)
+  {
+    shift = a->tile_shift;
+  }
+
+  if (b && b->type != NOISE_LAYOUT_ROW_MAJOR && b->tile_shift < shift)
+  {
+    shift = b->tile_shift;
+  }
+
+  return shift;
+}
+
+/* copies a map between layouts of the same size, returns 0 if the sizes differ */
+NOISE_API NOISE_INLINE int noise_layout_convert(float *src, noise_layout *src_layout, float *dst, noise_layout *dst_layout)
+{
+  float row[1 << NOISE_LAYOUT_BLOCK_SHIFT];
+  int block, bx, by, y, n;
+
+  if (src_layout->width != dst_layout->width || src_layout->height != dst_layout->height)
+  {
+    return 0;
+  }
+
+  /* block by block, so both sides stay within one tile while the block is copied */
+  block = 1 << noise_layout_block_shift(src_layout, dst_layout);
+
+  for (by = 0; by < src_layout->height; by += block)
+  {
+    int y_end = by + block < src_layout->height ? by + block : src_layout->height;
+
+    for (bx = 0; bx < src_layout->width; bx += block)
+    {
+      n = src_layout->width - bx < block ? src_layout->width - bx : block;
+
+      for (y = by; y < y_end; ++y)
+      {
+        noise_layout_run(src, src_layout, bx, y, n, row, 0);
+        noise_layout_run(dst, dst_layout, bx, y, n, row, 1);
+      }
+    }
+  }
+
+  return 1;
+}
+
+/* fills one channel into a map of the given layout, sample for sample equal to
+ * noise_channels_2 over the same grid */
+NOISE_API NOISE_INLINE int noise_channel_2_layout(noise_channel *channel, float *out, noise_layout *layout, float origin_x, float origin_y, float spacing)
+{
+  noise_fbm_plan plan;
+  noise_2_function noise;
+  float px[NOISE_BATCH_BLOCK], acc[NOISE_BATCH_BLOCK];
+  int block, bx, by, y, i, n;
+
+  if (layout->type == NOISE_LAYOUT_ROW_MAJOR)
+  {
+    return noise_channels_2(channel, 1, out, layout->width, layout->height, origin_x, origin_y, spacing, 0);
+  }
+
+  if (!noise_fbm_plan_2(&plan, channel->frequency, channel->octaves, channel->lacunarity, channel->gain, channel->rotation))
+  {
+    return 0;
+  }
+  noise = noise_function_2(channel->type);
+
+  /* tile by tile, so every finished block is written into memory that stays close */
+  block = 1 << noise_layout_block_shift(layout, 0);
+
+  for (by = 0; by < layout->height; by += block)
+  {
+    int y_end = by + block < layout->height ? by + block : layout->height;
+
+    for (bx = 0; bx < layout->width; bx += block)
+    {
+      n = layout->width - bx < block ? layout->width - bx : block;
+
+      for (i = 0; i < n; ++i)
+      {
+        px[i] = origin_x + (float)(bx + i) * spacing;
+      }
+
+      for (y = by; y < y_end; ++y)
+      {
+        noise_channel_2_block(&plan, noise, px, n, channel->offset_x, origin_y + (float)y * spacing + channel->offset_y, acc);
+        noise_layout_run(out, layout, bx, y, n, acc, 1);
+      }
+    }
+  }
+
+  return 1;
+}
+
+/* streams a layout map through an open noise_stream, one row at a time through row
+ * (layout->width floats); returns 0 if a write failed */
+NOISE_API NOISE_INLINE int noise_stream_layout(noise_stream *stream, float *data, noise_layout *layout, float *row)
+{
+  int y;
+
+  for (y = stream->rows_written; y < layout->height; ++y)
+  {
+    noise_layout_read_row(data, layout, y, row);
+
+    if (!noise_stream_rows(stream, row, 1))
+    {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+/* #############################################################################
+ * # Seed ensemble functions
+ * #############################################################################
+ *
+ * Evaluates the same coordinates under several seeds at once (rock variants, cloud
+ * layers, ...), instead of reseeding and refilling once per seed. A noise_ensemble packs
+ * one 512 byte permutation table per seed next to each other, 8 KiB for the full
+ * NOISE_ENSEMBLE_MAX seeds, so every table stays in L1 while a block is evaluated.
+ *
+ * Everything that does not depend on the seed is computed once per point and octave:
+ * the fBm transform, the lattice cell, the fractional offsets and the fade or falloff
+ * weights. Only the table lookups, gradient dots and the final blend run per seed, on
+ * adjacent tables. Output goes to one plane per seed, and plane k is bit-identical to
+ * the same call after noise_seed(seeds[k]).
+ *
+ * Value noise hashes coordinates without a table and ignores the seed; for
+ * NOISE_TYPE_VALUE every plane receives the same values.
+ */
+#define NOISE_ENSEMBLE_MAX 16
+
+typedef struct noise_ensemble
+{
+  int count;
+  unsigned int seeds[NOISE_ENSEMBLE_MAX];
+  unsigned char perm[NOISE_ENSEMBLE_MAX][512];
+
+} noise_ensemble;
+
+/* returns 0 if count is not within [1, NOISE_ENSEMBLE_MAX] */
+NOISE_API NOISE_INLINE int noise_ensemble_init(noise_ensemble *ensemble, unsigned int *seeds, int count)
+{
+  int k;
+
+  if (count < 1 || count > NOISE_ENSEMBLE_MAX)
+  {
+    return 0;
+  }
+
+  ensemble->count = count;
+
+  for (k = 0; k < count; ++k)
+  {
+    ensemble->seeds[k] = seeds[k];
+    noise_permutation_build(ensemble->perm[k], seeds[k]);
+  }
+
+  return 1;
+}
+
+/* out[k * stride] += amplitude * noise_perlin_2_table(perm[k], x, y, frequency) */
+NOISE_API NOISE_INLINE void noise_perlin_2_ensemble_add(noise_ensemble *ensemble, float x, float y, float frequency, float amplitude, float *out, int stride)
+{
+  int X, Y, k;
+  float xf, yf, u, v, floor_x, floor_y;
+
+  x *= frequency;
+  y *= frequency;
+
+  floor_x = noise_floor(x);
+  floor_y = noise_floor(y);
+
+  X = (int)floor_x & 255;
+  Y = (int)floor_y & 255;
+  xf = x - floor_x;
+  yf = y - floor_y;
+  u = noise_fade(xf);
+  v = noise_fade(yf);
+
+  NOISE_PROFILE_OCTAVE(4 * ensemble->count);
+
+  for (k = 0; k < ensemble->count; ++k)
+  {
+    unsigned char *perm = ensemble->perm[k];
+    int a = perm[X] + Y, b = perm[X + 1] + Y;
+    float x1 = noise_lerp(noise_dot2(noise_gradient_2_lut[perm[a] & 7], xf, yf),
+                          noise_dot2(noise_gradient_2_lut[perm[b] & 7], xf - 1, yf), u);
+    float x2 = noise_lerp(noise_dot2(noise_gradient_2_lut[perm[a + 1] & 7], xf, yf - 1),
+                          noise_dot2(noise_gradient_2_lut[perm[b + 1] & 7], xf - 1, yf - 1), u);
+
+    out[k * stride] += amplitude * (noise_lerp(x1, x2, v) * 0.70710678f);
+  }
+}
+
+/* out[k * stride] += amplitude * noise_simplex_2_table(perm[k], x, y, frequency) */
+NOISE_API NOISE_INLINE void noise_simplex_2_ensemble_add(noise_ensemble *ensemble, float x, float y, float frequency, float amplitude, float *out, int stride)
+{
+  float cx[3], cy[3], w[3];
+  int i, j, i1, j1, ii, jj, c, k;
+  float s, t;
+
+  x *= frequency;
+  y *= frequency;
+
+  /* cell and corner offsets, as in noise_simplex_2_table */
+  s = (x + y) * NOISE_SIMPLEX_F2;
+  i = (int)noise_floor(x + s);
+  j = (int)noise_floor(y + s);
+
+  t = (float)(i + j) * NOISE_SIMPLEX_G2;
+  cx[0] = x - (float)i + t;
+  cy[0] = y - (float)j + t;
+
+  i1 = cx[0] > cy[0] ? 1 : 0;
+  j1 = 1 - i1;
+
+  cx[1] = cx[0] - (float)i1 + NOISE_SIMPLEX_G2;
+  cy[1] = cy[0] - (float)j1 + NOISE_SIMPLEX_G2;
+  cx[2] = cx[0] - 1.0f + 2.0f * NOISE_SIMPLEX_G2;
+  cy[2] = cy[0] - 1.0f + 2.0f * NOISE_SIMPLEX_G2;
+
+  /* falloff weights, negative marks a corner out of reach */
+  for (c = 0; c < 3; ++c)
+  {
+    w[c] = 0.5f - cx[c] * cx[c] - cy[c] * cy[c];
+
+    if (w[c] >= 0.0f)
+    {
+      w[c] = w[c] * w[c];
+      w[c] = w[c] * w[c];
+    }
+  }
+
+  ii = i & 255;
+  jj = j & 255;
+
+  NOISE_PROFILE_OCTAVE(3 * ensemble->count);
+
+  for (k = 0; k < ensemble->count; ++k)
+  {
+    unsigned char *perm = ensemble->perm[k];
+    int g[3];
+    float n[3];
+
+    g[0] = perm[ii + perm[jj]] & 7;
+    g[1] = perm[ii + i1 + perm[jj + j1]] & 7;
+    g[2] = perm[ii + 1 + perm[jj + 1]] & 7;
+
+    for (c = 0; c < 3; ++c)
+    {
+      n[c] = w[c] < 0.0f ? 0.0f : w[c] * noise_dot2(noise_gradient_2_lut[g[c]], cx[c], cy[c]);
+    }
+
+    out[k * stride] += amplitude * (70.0f * (n[0] + n[1] + n[2]));
+  }
+}
+
+/* seed-independent value noise, added to every plane */
+NOISE_API NOISE_INLINE void noise_value_2_ensemble_add(noise_ensemble *ensemble, float x, float y, float frequency, float amplitude, float *out, int stride)
+{
+  float value = amplitude * noise_value_2(x, y, frequency);
+  int k;
+
+  for (k = 0; k < ensemble->count; ++k)
+  {
+    out[k * stride] += value;
+  }
+}
+
+typedef void (*noise_ensemble_2_function)(noise_ensemble *ensemble, float x, float y, float frequency, float amplitude, float *out, int stride);
+
+NOISE_API NOISE_INLINE noise_ensemble_2_function noise_ensemble_function_2(noise_type type)
+{
+  switch (type)
+  {
+  case NOISE_TYPE_SIMPLEX:
+    return noise_simplex_2_ensemble_add;
+  case NOISE_TYPE_VALUE:
+    return noise_value_2_ensemble_add;
+  case NOISE_TYPE_PERLIN:
+  default:
+    return noise_perlin_2_ensemble_add;
+  }
+}
+
+/* out[k] = noise of seed k at (x, y) */
+NOISE_API NOISE_INLINE void noise_ensemble_2(noise_ensemble *ensemble, noise_type type, float x, float y, float frequency, float *out)
+{
+  int k;
+
+  for (k = 0; k < ensemble->count; ++k)
+  {
+    out[k] = 0.0f;
+  }
+
+  noise_ensemble_function_2(type)(ensemble, x, y, frequency, 1.0f, out, 1);
+}
+
+/* fBm of every seed at count points, plane k (out + k * count) matches
+ * noise_*_2_fbm_plan after noise_seed(seeds[k]) */
+NOISE_API NOISE_INLINE void noise_ensemble_2_fbm_plan(noise_ensemble *ensemble, noise_type type, noise_fbm_plan *plan, float *xs, float *ys, int count, float *out)
+{
+  noise_ensemble_2_function noise = noise_ensemble_function_2(type);
+  int i, o, start, n;
+
+  for (i = 0; i < ensemble->count * count; ++i)
+  {
+    out[i] = 0.0f;
+  }
+
+  NOISE_PROFILE_SAMPLES(ensemble->count * count);
+
+  /* octave-major per block, so the plan row is reused across the block */
+  for (start = 0; start < count; start += NOISE_BATCH_BLOCK)
+  {
+    n = count - start < NOISE_BATCH_BLOCK ? count - start : NOISE_BATCH_BLOCK;
+
+    for (o = 0; o < plan->octaves; ++o)
+    {
+      float (*m)[3] = plan->transform[o];
+
+      for (i = start; i < start + n; ++i)
+      {
+        noise(ensemble, m[0][0] * xs[i] + m[0][1] * ys[i], m[1][0] * xs[i] + m[1][1] * ys[i], 1.0f, plan->amplitude[o], out + i, count);
+      }
+    }
+  }
+}
+
+/* fills one plane of width * height per seed, plane k (out + k * width * height) matches
+ * noise_channels_2 for this channel after noise_seed(seeds[k]) */
+NOISE_API NOISE_INLINE int noise_ensemble_channel_2(
+    noise_ensemble *ensemble, noise_channel *channel,
+    float *out, int width, int height,
+    float origin_x, float origin_y, float spacing)
+{
+  noise_fbm_plan plan;
+  noise_ensemble_2_function noise = noise_ensemble_function_2(channel->type);
+  int plane = width * height;
+  int i, o, x, y, n;
+
+  if (!noise_fbm_plan_2(&plan, channel->frequency, channel->octaves, channel->lacunarity, channel->gain, channel->rotation))
+  {
+    return 0;
+  }
+
+  for (i = 0; i < ensemble->count * plane; ++i)
+  {
+    out[i] = 0.0f;
+  }
+
+  NOISE_PROFILE_SAMPLES(ensemble->count * plane);
+
+  for (y = 0; y < height; ++y)
+  {
+    float py = origin_y + (float)y * spacing + channel->offset_y;
+
+    for (x = 0; x < width; x += NOISE_BATCH_BLOCK)
+    {
+      n = width - x < NOISE_BATCH_BLOCK ? width - x : NOISE_BATCH_BLOCK;
+
+      /* same coordinate expressions as noise_channel_2_block */
+      for (o = 0; o < plan.octaves; ++o)
+      {
+        float (*m)[3] = plan.transform[o];
+        float bx = m[0][1] * py, by = m[1][1] * py;
+
+        for (i = 0; i < n; ++i)
+        {
+          float cx = (origin_x + (float)(x + i) * spacing) + channel->offset_x;
+
+          noise(ensemble, m[0][0] * cx + bx, m[1][0] * cx + by, 1.0f, plan.amplitude[o], out + y * width + x + i, plane);
+        }
+      }
+    }
+  }
+
+  return 1;
+}
+
+/* #############################################################################
+ * # Erosion simulation functions
+ * #############################################################################
+ */
+
+/* Each pass is written as a span kernel over cells [x_begin, x_end) of row y, so resumable
+ * jobs (see noise_job) can run a pass in slices with the same update order. */
+NOISE_API NOISE_INLINE void noise_erosion_thermal_span(float *heightmap, int width, float talus, int y, int x_begin, int x_end)
+{
+  int x, i;
+  int dx[8] = {-1, 0, 1, -1, 1, -1, 0, 1};
+  int dy[8] = {-1, -1, -1, 0, 0, 1, 1, 1};
+
+  NOISE_PROFILE_EROSION_CELLS(x_end - x_begin);
+
+  for (x = x_begin; x < x_end; ++x)
+  {
+    float h = heightmap[y * width + x];
+    float dmax = 0.0f;
+    int imax = -1;
+
+    /* find steepest neighbor */
+    for (i = 0; i < 8; ++i)
+    {
+      float n = heightmap[(y + dy[i]) * width + (x + dx[i])];
+      float diff = h - n;
+      if (diff > dmax)
+      {
+        dmax = diff;
+        imax = i;
+      }
+    }
+
+    /* move small portion of material if slope exceeds talus */
+    if (dmax > talus && imax >= 0)
+    {
+      float dh = 0.5f * (dmax - talus);
+
+      NOISE_PROFILE_EROSION_ACTIVE(1);
+
+      heightmap[y * width + x] -= dh;
+      heightmap[(y + dy[imax]) * width + (x + dx[imax])] += dh;
+    }
+  }
+}
+
+NOISE_API void noise_erosion_thermal(float *heightmap, int width, int height, float talus, int iterations)
+{
+  int iter, y;
+
+  NOISE_PROFILE_BEGIN(NOISE_PROFILE_API_EROSION_THERMAL);
+
+  for (iter = 0; iter < iterations; ++iter)
+  {
+    for (y = 1; y < height - 1; ++y)
+    {
+      noise_erosion_thermal_span(heightmap, width, talus, y, 1, width - 1);
+    }
+  }
+
+  NOISE_PROFILE_END(NOISE_PROFILE_API_EROSION_THERMAL);
+}
+
+/* rainfall over cells [x_begin, x_end) of row y */
+NOISE_API NOISE_INLINE void noise_erosion_hydraulic_rain_span(float *heightmap, int width, float rain_amount, int y, int x_begin, int x_end)
+{
+  float *water = (float *)heightmap; /* reuse or overlay memory manually if no malloc */
+  int x;
+
+  for (x = x_begin; x < x_end; ++x)
+  {
+    water[y * width + x] += rain_amount;
+  }
+}
+
+/* flow, erosion, deposition and evaporation over cells [x_begin, x_end) of row y */
+NOISE_API NOISE_INLINE void noise_erosion_hydraulic_span(
+    float *heightmap, int width,
+    float evaporation,
+    float sediment_capacity,
+    float deposition_rate,
+    float erosion_rate,
+    int y, int x_begin, int x_end)
+{
+  int x, i;
+  float *water;
+  float *sediment;
+  int dx[4] = {-1, 1, 0, 0};
+  int dy[4] = {0, 0, -1, 1};
+
+  /* temporary arrays */
+  water = (float *)heightmap;    /* reuse or overlay memory manually if no malloc */
+  sediment = (float *)heightmap; /* same buffer reuse if needed */
+
+  NOISE_PROFILE_EROSION_CELLS(x_end - x_begin);
+
+  for (x = x_begin; x < x_end; ++x)
+  {
+    float total_diff = 0.0f;
+    float h = heightmap[y * width + x] + water[y * width + x];
+
+    /* compute flow */
+    for (i = 0; i < 4; ++i)
+    {
+      float n = heightmap[(y + dy[i]) * width + (x + dx[i])] +
+                water[(y + dy[i]) * width + (x + dx[i])];
+      if (h > n)
+        total_diff += h - n;
+    }
+
+    if (total_diff > 0.0f)
+    {
+      NOISE_PROFILE_EROSION_ACTIVE(1);
+
+      for (i = 0; i < 4; ++i)
+      {
+        float n = heightmap[(y + dy[i]) * width + (x + dx[i])] +
+                  water[(y + dy[i]) * width + (x + dx[i])];
+        if (h > n)
         {
-          float dh = 0.5f * (dmax - talus);
-          heightmap[y * width + x] -= dh;
-          heightmap[(y + dy[imax]) * width + (x + dx[imax])] += dh;
+          float flow = (h - n) / total_diff;
+          float carry = flow * erosion_rate;
+          heightmap[y * width + x] -= carry;
+          sediment[y * width + x] += carry;
+          heightmap[(y + dy[i]) * width + (x + dx[i])] += carry * 0.5f;
         }
       }
     }
+
+    /* evaporation and deposition */
+    if (sediment[y * width + x] > sediment_capacity)
+    {
+      float deposit = (sediment[y * width + x] - sediment_capacity) * deposition_rate;
+      sediment[y * width + x] -= deposit;
+      heightmap[y * width + x] += deposit;
+    }
+
+    water[y * width + x] *= (1.0f - evaporation);
   }
 }
 
@@ -886,70 +6948,52 @@ NOISE_API void noise_erosion_hydraulic(
     float deposition_rate,
     float erosion_rate)
 {
-  int iter, x, y, i;
-  float *water;
-  float *sediment;
-  int dx[4] = {-1, 1, 0, 0};
-  int dy[4] = {0, 0, -1, 1};
+  int iter, y;
 
-  /* temporary arrays */
-  water = (float *)heightmap;    /* reuse or overlay memory manually if no malloc */
-  sediment = (float *)heightmap; /* same buffer reuse if needed */
+  NOISE_PROFILE_BEGIN(NOISE_PROFILE_API_EROSION_HYDRAULIC);
 
   for (iter = 0; iter < iterations; ++iter)
   {
     /* rainfall */
     for (y = 0; y < height; ++y)
     {
-      for (x = 0; x < width; ++x)
-      {
-        water[y * width + x] += rain_amount;
-      }
+      noise_erosion_hydraulic_rain_span(heightmap, width, rain_amount, y, 0, width);
     }
 
     /* simulate flow and erosion */
     for (y = 1; y < height - 1; ++y)
     {
-      for (x = 1; x < width - 1; ++x)
-      {
-        float total_diff = 0.0f;
-        float h = heightmap[y * width + x] + water[y * width + x];
+      noise_erosion_hydraulic_span(heightmap, width, evaporation, sediment_capacity, deposition_rate, erosion_rate, y, 1, width - 1);
+    }
+  }
 
-        /* compute flow */
-        for (i = 0; i < 4; ++i)
-        {
-          float n = heightmap[(y + dy[i]) * width + (x + dx[i])] +
-                    water[(y + dy[i]) * width + (x + dx[i])];
-          if (h > n)
-            total_diff += h - n;
-        }
+  NOISE_PROFILE_END(NOISE_PROFILE_API_EROSION_HYDRAULIC);
+}
 
-        if (total_diff > 0.0f)
-        {
-          for (i = 0; i < 4; ++i)
-          {
-            float n = heightmap[(y + dy[i]) * width + (x + dx[i])] +
-                      water[(y + dy[i]) * width + (x + dx[i])];
-            if (h > n)
-            {
-              float flow = (h - n) / total_diff;
-              float carry = flow * erosion_rate;
-              heightmap[y * width + x] -= carry;
-              sediment[y * width + x] += carry;
-              heightmap[(y + dy[i]) * width + (x + dx[i])] += carry * 0.5f;
-            }
-          }
-        }
+/* wind transport over cells [x_begin, x_end) of row y, (sx, sy) is the upwind neighbour step */
+NOISE_API NOISE_INLINE void noise_erosion_wind_span(float *heightmap, int width, int height, int sx, int sy, float strength, int y, int x_begin, int x_end)
+{
+  int x;
 
-        /* evaporation and deposition */
-        if (sediment[y * width + x] > sediment_capacity)
-        {
-          float deposit = (sediment[y * width + x] - sediment_capacity) * deposition_rate;
-          sediment[y * width + x] -= deposit;
-          heightmap[y * width + x] += deposit;
-        }
+  NOISE_PROFILE_EROSION_CELLS(x_end - x_begin);
+
+  for (x = x_begin; x < x_end; ++x)
+  {
+    float h = heightmap[y * width + x];
+    int nx = x + sx;
+    int ny = y + sy;
+    if (nx >= 0 && nx < width && ny >= 0 && ny < height)
+    {
+      float nh = heightmap[ny * width + nx];
+      float diff = h - nh;
+      if (diff > 0.0f)
+      {
+        float move = diff * strength;
 
-        water[y * width + x] *= (1.0f - evaporation);
+        NOISE_PROFILE_EROSION_ACTIVE(1);
+
+        heightmap[y * width + x] -= move;
+        heightmap[ny * width + nx] += move;
       }
     }
   }
@@ -961,35 +7005,565 @@ NOISE_API void noise_erosion_wind(
     float strength,
     int iterations)
 {
-  int iter, x, y;
+  int iter, y;
   int sx = (dir_x > 0) ? -1 : 1;
   int sy = (dir_y > 0) ? -1 : 1;
 
+  NOISE_PROFILE_BEGIN(NOISE_PROFILE_API_EROSION_WIND);
+
   for (iter = 0; iter < iterations; ++iter)
   {
     for (y = 1; y < height - 1; ++y)
     {
-      for (x = 1; x < width - 1; ++x)
+      noise_erosion_wind_span(heightmap, width, height, sx, sy, strength, y, 1, width - 1);
+    }
+  }
+
+  NOISE_PROFILE_END(NOISE_PROFILE_API_EROSION_WIND);
+}
+
+/* Erosion over a map in a tiled or Morton layout (see noise_layout). A pass sweeps the
+ * interior rows in the same order as the row-major functions, on a window of three rows
+ * (y - 1, y, y + 1) gathered into scratch with noise_layout_run. Row y - 1 is final once
+ * row y has been processed, so it is written back and the window slides down by one row.
+ * Results are bit identical to the row-major functions, and the window stays cache
+ * resident however the map is laid out. Row-major layouts run the row-major functions
+ * unchanged. scratch holds noise_layout_scratch_size floats. */
+NOISE_API NOISE_INLINE int noise_layout_scratch_size(noise_layout *layout)
+{
+  return layout->type == NOISE_LAYOUT_ROW_MAJOR ? 0 : 3 * layout->width;
+}
+
+typedef enum noise_erosion_pass
+{
+  NOISE_EROSION_PASS_THERMAL = 0,
+  NOISE_EROSION_PASS_HYDRAULIC,
+  NOISE_EROSION_PASS_WIND
+
+} noise_erosion_pass;
+
+typedef struct noise_erosion_params
+{
+  float talus;
+  float evaporation;
+  float sediment_capacity;
+  float deposition_rate;
+  float erosion_rate;
+  int sx;
+  int sy;
+  float strength;
+
+} noise_erosion_params;
+
+/* one pass over the interior cells of the map, in row order */
+NOISE_API NOISE_INLINE void noise_erosion_layout_pass(float *data, noise_layout *layout, noise_erosion_pass pass, noise_erosion_params *p, float *scratch)
+{
+  int width = layout->width;
+  int height = layout->height;
+  int y;
+
+  if (width < 3 || height < 3)
+  {
+    return;
+  }
+
+  noise_layout_run(data, layout, 0, 0, width, scratch, 0);
+  noise_layout_run(data, layout, 0, 1, width, scratch + width, 0);
+
+  for (y = 1; y < height - 1; ++y)
+  {
+    noise_layout_run(data, layout, 0, y + 1, width, scratch + 2 * width, 0);
+
+    switch (pass)
+    {
+    case NOISE_EROSION_PASS_THERMAL:
+      noise_erosion_thermal_span(scratch, width, p->talus, 1, 1, width - 1);
+      break;
+    case NOISE_EROSION_PASS_HYDRAULIC:
+      noise_erosion_hydraulic_span(scratch, width, p->evaporation, p->sediment_capacity, p->deposition_rate, p->erosion_rate, 1, 1, width - 1);
+      break;
+    case NOISE_EROSION_PASS_WIND:
+    default:
+      noise_erosion_wind_span(scratch, width, 3, p->sx, p->sy, p->strength, 1, 1, width - 1);
+      break;
+    }
+
+    /* row y - 1 is done, slide the window */
+    noise_layout_run(data, layout, 0, y - 1, width, scratch, 1);
+    noise_layout_copy(scratch, scratch + width, 2 * width, 1);
+  }
+
+  noise_layout_run(data, layout, 0, height - 2, width, scratch, 1);
+  noise_layout_run(data, layout, 0, height - 1, width, scratch + width, 1);
+}
+
+/* rainfall needs no neighbours: tiles inside the map are one contiguous range in either
+ * tiled layout, only tiles cut by the map border are walked by row */
+NOISE_API NOISE_INLINE void noise_erosion_layout_rain(float *data, noise_layout *layout, float rain_amount)
+{
+  int s = layout->tile_shift;
+  int tile = 1 << s;
+  int tx, ty, x, y, i;
+
+  for (ty = 0; ty < layout->tiles_y; ++ty)
+  {
+    for (tx = 0; tx < layout->tiles_x; ++tx)
+    {
+      float *t = data + ((ty * layout->tiles_x + tx) << (2 * s));
+
+      if ((tx + 1) * tile <= layout->width && (ty + 1) * tile <= layout->height)
+      {
+        noise_erosion_hydraulic_rain_span(t, 0, rain_amount, 0, 0, tile * tile);
+        continue;
+      }
+
+      for (y = ty * tile; y < (ty + 1) * tile && y < layout->height; ++y)
       {
-        float h = heightmap[y * width + x];
-        int nx = x + sx;
-        int ny = y + sy;
-        if (nx >= 0 && nx < width && ny >= 0 && ny < height)
+        for (x = tx * tile; x < (tx + 1) * tile && x < layout->width; ++x)
         {
-          float nh = heightmap[ny * width + nx];
-          float diff = h - nh;
-          if (diff > 0.0f)
-          {
-            float move = diff * strength;
-            heightmap[y * width + x] -= move;
-            heightmap[ny * width + nx] += move;
-          }
+          i = noise_layout_index(layout, x, y);
+          data[i] += rain_amount;
         }
       }
     }
   }
 }
 
+NOISE_API NOISE_INLINE void noise_erosion_thermal_layout(float *data, noise_layout *layout, float talus, int iterations, float *scratch)
+{
+  static noise_erosion_params zero;
+  noise_erosion_params p = zero;
+  int iter;
+
+  if (layout->type == NOISE_LAYOUT_ROW_MAJOR)
+  {
+    noise_erosion_thermal(data, layout->width, layout->height, talus, iterations);
+    return;
+  }
+
+  NOISE_PROFILE_BEGIN(NOISE_PROFILE_API_EROSION_THERMAL);
+
+  p.talus = talus;
+
+  for (iter = 0; iter < iterations; ++iter)
+  {
+    noise_erosion_layout_pass(data, layout, NOISE_EROSION_PASS_THERMAL, &p, scratch);
+  }
+
+  NOISE_PROFILE_END(NOISE_PROFILE_API_EROSION_THERMAL);
+}
+
+NOISE_API NOISE_INLINE void noise_erosion_hydraulic_layout(
+    float *data, noise_layout *layout,
+    int iterations,
+    float rain_amount,
+    float evaporation,
+    float sediment_capacity,
+    float deposition_rate,
+    float erosion_rate,
+    float *scratch)
+{
+  static noise_erosion_params zero;
+  noise_erosion_params p = zero;
+  int iter;
+
+  if (layout->type == NOISE_LAYOUT_ROW_MAJOR)
+  {
+    noise_erosion_hydraulic(data, layout->width, layout->height, iterations, rain_amount, evaporation, sediment_capacity, deposition_rate, erosion_rate);
+    return;
+  }
+
+  NOISE_PROFILE_BEGIN(NOISE_PROFILE_API_EROSION_HYDRAULIC);
+
+  p.evaporation = evaporation;
+  p.sediment_capacity = sediment_capacity;
+  p.deposition_rate = deposition_rate;
+  p.erosion_rate = erosion_rate;
+
+  for (iter = 0; iter < iterations; ++iter)
+  {
+    noise_erosion_layout_rain(data, layout, rain_amount);
+    noise_erosion_layout_pass(data, layout, NOISE_EROSION_PASS_HYDRAULIC, &p, scratch);
+  }
+
+  NOISE_PROFILE_END(NOISE_PROFILE_API_EROSION_HYDRAULIC);
+}
+
+NOISE_API NOISE_INLINE void noise_erosion_wind_layout(
+    float *data, noise_layout *layout,
+    float dir_x, float dir_y,
+    float strength,
+    int iterations,
+    float *scratch)
+{
+  static noise_erosion_params zero;
+  noise_erosion_params p = zero;
+  int iter;
+
+  if (layout->type == NOISE_LAYOUT_ROW_MAJOR)
+  {
+    noise_erosion_wind(data, layout->width, layout->height, dir_x, dir_y, strength, iterations);
+    return;
+  }
+
+  NOISE_PROFILE_BEGIN(NOISE_PROFILE_API_EROSION_WIND);
+
+  p.sx = (dir_x > 0) ? -1 : 1;
+  p.sy = (dir_y > 0) ? -1 : 1;
+  p.strength = strength;
+
+  for (iter = 0; iter < iterations; ++iter)
+  {
+    noise_erosion_layout_pass(data, layout, NOISE_EROSION_PASS_WIND, &p, scratch);
+  }
+
+  NOISE_PROFILE_END(NOISE_PROFILE_API_EROSION_WIND);
+}
+
+/* #############################################################################
+ * # Generation job functions
+ * #############################################################################
+ *
+ * Resumable, time-sliced versions of the full-map fill and the erosion passes for callers
+ * with a fixed per-frame budget:
+ *
+ *   noise_job job;
+ *   noise_job_erosion_thermal(&job, heightmap, width, height, 0.02f, 50);
+ *   while (noise_job_step(&job, 20000)) { ... render a frame ... }
+ *
+ * A job holds its progress (iteration, phase, row, column) and the fill's fBm plan, so a
+ * step picks up exactly where the last one stopped. The budget counts samples for fills
+ * and cells for erosion, and a step never processes more than the budget. Slices run the
+ * same span kernels in the same order as the run-to-completion functions, so the result
+ * is bit-identical however the work was sliced.
+ *
+ * A noise_job_queue shares one budget between several jobs, highest priority first and
+ * in push order among equal priorities. Priorities may change between steps, and
+ * cancelled jobs are dropped on the next step.
+ */
+#define NOISE_JOB_QUEUE_MAX 32
+
+typedef enum noise_job_type
+{
+  NOISE_JOB_FILL = 0,
+  NOISE_JOB_EROSION_THERMAL,
+  NOISE_JOB_EROSION_HYDRAULIC,
+  NOISE_JOB_EROSION_WIND
+
+} noise_job_type;
+
+typedef enum noise_job_status
+{
+  NOISE_JOB_RUNNING = 0,
+  NOISE_JOB_DONE,
+  NOISE_JOB_CANCELLED
+
+} noise_job_status;
+
+typedef struct noise_job
+{
+  noise_job_type type;
+  noise_job_status status;
+  int priority; /* higher runs first in a noise_job_queue */
+
+  float *heightmap;
+  int width;
+  int height;
+
+  /* progress */
+  int iterations;
+  int iteration;
+  int phase; /* hydraulic: 0 rainfall, 1 flow */
+  int row;
+  int column;
+  double done;  /* samples or cells processed so far */
+  double total; /* samples or cells of the whole job */
+
+  /* fill */
+  noise_channel channel;
+  noise_fbm_plan plan;
+  noise_2_function noise;
+  float origin_x;
+  float origin_y;
+  float spacing;
+
+  /* erosion */
+  float talus;
+  float rain_amount;
+  float evaporation;
+  float sediment_capacity;
+  float deposition_rate;
+  float erosion_rate;
+  float strength;
+  int wind_x;
+  int wind_y;
+
+} noise_job;
+
+typedef struct noise_job_queue
+{
+  noise_job *jobs[NOISE_JOB_QUEUE_MAX];
+  int count;
+
+} noise_job_queue;
+
+/* rows and columns [border, size - border) are visited in the current phase */
+NOISE_API NOISE_INLINE int noise_job_border(noise_job *job)
+{
+  return (job->type == NOISE_JOB_FILL || (job->type == NOISE_JOB_EROSION_HYDRAULIC && job->phase == 0)) ? 0 : 1;
+}
+
+NOISE_API NOISE_INLINE void noise_job_begin(noise_job *job, noise_job_type type, float *heightmap, int width, int height, int iterations)
+{
+  static noise_job zero;
+  double interior = width > 2 && height > 2 ? (double)(width - 2) * (double)(height - 2) : 0.0;
+
+  *job = zero;
+  job->type = type;
+  job->status = NOISE_JOB_RUNNING;
+  job->heightmap = heightmap;
+  job->width = width;
+  job->height = height;
+
+  switch (type)
+  {
+  case NOISE_JOB_FILL:
+    job->total = width > 0 && height > 0 ? (double)width * (double)height : 0.0;
+    break;
+  case NOISE_JOB_EROSION_HYDRAULIC:
+    job->total = interior > 0.0 ? (double)iterations * ((double)width * (double)height + interior) : 0.0;
+    break;
+  default:
+    job->total = (double)iterations * interior;
+    break;
+  }
+
+  /* nothing to do (empty map or no iterations) finishes on the first step */
+  job->iterations = job->total > 0.0 ? iterations : 0;
+  job->row = job->column = noise_job_border(job);
+}
+
+NOISE_API NOISE_INLINE int noise_job_fill(noise_job *job, float *heightmap, int width, int height, noise_channel *channel, float origin_x, float origin_y, float spacing)
+{
+  noise_job_begin(job, NOISE_JOB_FILL, heightmap, width, height, 1);
+  job->channel = *channel;
+  job->noise = noise_function_2(channel->type);
+  job->origin_x = origin_x;
+  job->origin_y = origin_y;
+  job->spacing = spacing;
+
+  /* a channel the plan cannot hold never starts */
+  if (!noise_fbm_plan_2(&job->plan, channel->frequency, channel->octaves, channel->lacunarity, channel->gain, channel->rotation))
+  {
+    job->status = NOISE_JOB_CANCELLED;
+    return 0;
+  }
+
+  return 1;
+}
+
+NOISE_API NOISE_INLINE void noise_job_erosion_thermal(noise_job *job, float *heightmap, int width, int height, float talus, int iterations)
+{
+  noise_job_begin(job, NOISE_JOB_EROSION_THERMAL, heightmap, width, height, iterations);
+  job->talus = talus;
+}
+
+NOISE_API NOISE_INLINE void noise_job_erosion_hydraulic(
+    noise_job *job, float *heightmap, int width, int height,
+    int iterations,
+    float rain_amount,
+    float evaporation,
+    float sediment_capacity,
+    float deposition_rate,
+    float erosion_rate)
+{
+  noise_job_begin(job, NOISE_JOB_EROSION_HYDRAULIC, heightmap, width, height, iterations);
+  job->rain_amount = rain_amount;
+  job->evaporation = evaporation;
+  job->sediment_capacity = sediment_capacity;
+  job->deposition_rate = deposition_rate;
+  job->erosion_rate = erosion_rate;
+}
+
+NOISE_API NOISE_INLINE void noise_job_erosion_wind(noise_job *job, float *heightmap, int width, int height, float dir_x, float dir_y, float strength, int iterations)
+{
+  noise_job_begin(job, NOISE_JOB_EROSION_WIND, heightmap, width, height, iterations);
+  job->wind_x = (dir_x > 0) ? -1 : 1;
+  job->wind_y = (dir_y > 0) ? -1 : 1;
+  job->strength = strength;
+}
+
+/* runs cells [x_begin, x_end) of row y in the current phase */
+NOISE_API NOISE_INLINE void noise_job_span(noise_job *job, int y, int x_begin, int x_end)
+{
+  float *row = job->heightmap + y * job->width;
+  float px[NOISE_BATCH_BLOCK];
+  int x, i, n;
+
+  switch (job->type)
+  {
+  case NOISE_JOB_FILL:
+    /* same coordinates as noise_channels_2 */
+    for (x = x_begin; x < x_end; x += NOISE_BATCH_BLOCK)
+    {
+      n = x_end - x < NOISE_BATCH_BLOCK ? x_end - x : NOISE_BATCH_BLOCK;
+
+      for (i = 0; i < n; ++i)
+      {
+        px[i] = job->origin_x + (float)(x + i) * job->spacing;
+      }
+
+      noise_channel_2_block(&job->plan, job->noise, px, n, job->channel.offset_x, job->origin_y + (float)y * job->spacing + job->channel.offset_y, row + x);
+    }
+    break;
+  case NOISE_JOB_EROSION_THERMAL:
+    noise_erosion_thermal_span(job->heightmap, job->width, job->talus, y, x_begin, x_end);
+    break;
+  case NOISE_JOB_EROSION_HYDRAULIC:
+    if (job->phase == 0)
+    {
+      noise_erosion_hydraulic_rain_span(job->heightmap, job->width, job->rain_amount, y, x_begin, x_end);
+    }
+    else
+    {
+      noise_erosion_hydraulic_span(job->heightmap, job->width, job->evaporation, job->sediment_capacity, job->deposition_rate, job->erosion_rate, y, x_begin, x_end);
+    }
+    break;
+  case NOISE_JOB_EROSION_WIND:
+    noise_erosion_wind_span(job->heightmap, job->width, job->height, job->wind_x, job->wind_y, job->strength, y, x_begin, x_end);
+    break;
+  }
+}
+
+/* advances the job by at most budget samples/cells and returns how many were processed */
+NOISE_API NOISE_INLINE int noise_job_run(noise_job *job, int budget)
+{
+  int phases = job->type == NOISE_JOB_EROSION_HYDRAULIC ? 2 : 1;
+  int used = 0;
+
+  if (job->status != NOISE_JOB_RUNNING)
+  {
+    return 0;
+  }
+
+  while (used < budget && job->iteration < job->iterations)
+  {
+    int border = noise_job_border(job);
+    int n = job->width - border - job->column;
+
+    n = n < budget - used ? n : budget - used;
+    noise_job_span(job, job->row, job->column, job->column + n);
+    job->column += n;
+    used += n;
+
+    if (job->column < job->width - border)
+    {
+      continue;
+    }
+
+    /* row finished, then the phase, then the iteration */
+    if (++job->row >= job->height - border)
+    {
+      if (++job->phase >= phases)
+      {
+        job->phase = 0;
+        job->iteration++;
+      }
+
+      job->row = noise_job_border(job);
+    }
+
+    job->column = noise_job_border(job);
+  }
+
+  job->done += (double)used;
+
+  if (job->iteration >= job->iterations)
+  {
+    job->status = NOISE_JOB_DONE;
+  }
+
+  return used;
+}
+
+/* returns 1 while the job has work left, 0 once it is done or cancelled */
+NOISE_API NOISE_INLINE int noise_job_step(noise_job *job, int budget)
+{
+  noise_job_run(job, budget);
+  return job->status == NOISE_JOB_RUNNING;
+}
+
+NOISE_API NOISE_INLINE void noise_job_cancel(noise_job *job)
+{
+  if (job->status == NOISE_JOB_RUNNING)
+  {
+    job->status = NOISE_JOB_CANCELLED;
+  }
+}
+
+/* fraction of the work done, in [0, 1] */
+NOISE_API NOISE_INLINE float noise_job_progress(noise_job *job)
+{
+  return job->total > 0.0 ? (float)(job->done / job->total) : 1.0f;
+}
+
+NOISE_API NOISE_INLINE void noise_job_queue_init(noise_job_queue *queue)
+{
+  queue->count = 0;
+}
+
+/* returns 0 when the queue is full */
+NOISE_API NOISE_INLINE int noise_job_queue_push(noise_job_queue *queue, noise_job *job)
+{
+  if (queue->count >= NOISE_JOB_QUEUE_MAX)
+  {
+    return 0;
+  }
+
+  queue->jobs[queue->count++] = job;
+  return 1;
+}
+
+/* spends up to budget samples/cells on the queued jobs and returns how many are left */
+NOISE_API NOISE_INLINE int noise_job_queue_step(noise_job_queue *queue, int budget)
+{
+  int i, n;
+
+  while (budget > 0)
+  {
+    noise_job *next = 0;
+
+    for (i = 0; i < queue->count; ++i)
+    {
+      noise_job *job = queue->jobs[i];
+
+      if (job->status == NOISE_JOB_RUNNING && (!next || job->priority > next->priority))
+      {
+        next = job;
+      }
+    }
+
+    if (!next)
+    {
+      break;
+    }
+
+    budget -= noise_job_run(next, budget);
+  }
+
+  /* drop finished and cancelled jobs, keeping push order */
+  for (i = 0, n = 0; i < queue->count; ++i)
+  {
+    if (queue->jobs[i]->status == NOISE_JOB_RUNNING)
+    {
+      queue->jobs[n++] = queue->jobs[i];
+    }
+  }
+
+  queue->count = n;
+  return n;
+}
+
 #endif /* NOISE_H */
 
 /*
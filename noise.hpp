@@ -0,0 +1,525 @@
+/* noise.hpp - v0.4 - public domain data structures - nickscha 2025
+
+C++14 companion of noise.h: compile-time specialized noise.
+
+  - permutation tables for fixed seeds built constexpr (zero startup cost, identical to noise_seed)
+  - fBm templated on dimension, base noise, octave count, lacunarity and rotation; the octave
+    loop is fully unrolled and a lacunarity of 2 scales exactly
+  - expression templates that fuse warp, remap and arithmetic into one inlined loop
+
+USAGE
+
+  static const noise::permutation_table &table = noise::seeded<1337>::table;
+
+  typedef noise::fbm_2<noise::simplex, 6> terrain;
+  float h = terrain::sample(table.p, x, y, 0.01f, 0.5f);
+
+  noise::fill(noise::remap(noise::warp(noise::fbm_expr<terrain>(table.p, 0.01f, 0.5f), ...), -1, 1, 0, 1),
+              out, width, height, 0.0f, 0.0f, 1.0f);
+
+LICENSE
+
+  Placed in the public domain and also MIT licensed.
+  See end of file for detailed license information.
+
+*/
+#ifndef NOISE_HPP
+#define NOISE_HPP
+
+#include "noise.h"
+
+#define NOISE_HPP_INLINE inline
+
+namespace noise
+{
+
+/* #############################################################################
+ * # Compile-time permutation tables
+ * #############################################################################
+ */
+struct permutation_table
+{
+  unsigned char p[512];
+};
+
+/* noise_random_u32 and noise_random_below, evaluated by the compiler */
+constexpr unsigned int random_mix(unsigned int x)
+{
+  x ^= x >> 16;
+  x *= 0x7feb352du;
+  x ^= x >> 15;
+  x *= 0x846ca68bu;
+  x ^= x >> 16;
+  return x;
+}
+
+constexpr unsigned int random_u32(unsigned int seed, unsigned int stream, unsigned int index)
+{
+  return random_mix(random_mix(seed ^ random_mix(stream + 0x632be5abu)) + index * 0x9e3779b9u);
+}
+
+constexpr unsigned int random_below(unsigned int r, unsigned int n)
+{
+  unsigned int t = (r >> 16) * (n & 0xffffu) + (((r & 0xffffu) * (n & 0xffffu)) >> 16);
+  unsigned int w = (t & 0xffffu) + (r & 0xffffu) * (n >> 16);
+
+  return (r >> 16) * (n >> 16) + (t >> 16) + (w >> 16);
+}
+
+/* same shuffle as noise_seed */
+constexpr permutation_table make_permutation_table(unsigned int seed)
+{
+  permutation_table t{};
+  int i = 0;
+
+  for (i = 0; i < 256; ++i)
+  {
+    t.p[i] = static_cast<unsigned char>(i);
+  }
+
+  for (i = 255; i > 0; --i)
+  {
+    unsigned int r = random_below(random_u32(seed, 0, static_cast<unsigned int>(i)), static_cast<unsigned int>(i + 1));
+    unsigned char swap = t.p[i];
+
+    t.p[i] = t.p[r];
+    t.p[r] = swap;
+  }
+
+  for (i = 0; i < 256; ++i)
+  {
+    t.p[256 + i] = t.p[i];
+  }
+
+  return t;
+}
+
+template <unsigned int Seed>
+struct seeded
+{
+  static constexpr permutation_table table = make_permutation_table(Seed);
+};
+
+template <unsigned int Seed>
+constexpr permutation_table seeded<Seed>::table;
+
+/* #############################################################################
+ * # Base noise policies
+ * #############################################################################
+ */
+struct perlin
+{
+  static NOISE_HPP_INLINE float sample(const unsigned char *perm, float x, float y)
+  {
+    return noise_perlin_2_table(perm, x, y, 1.0f);
+  }
+
+  static NOISE_HPP_INLINE float sample(const unsigned char *perm, float x, float y, float z)
+  {
+    return noise_perlin_3_table(perm, x, y, z, 1.0f);
+  }
+};
+
+struct simplex
+{
+  static NOISE_HPP_INLINE float sample(const unsigned char *perm, float x, float y)
+  {
+    return noise_simplex_2_table(perm, x, y, 1.0f);
+  }
+
+  static NOISE_HPP_INLINE float sample(const unsigned char *perm, float x, float y, float z)
+  {
+    return noise_simplex_3_table(perm, x, y, z, 1.0f);
+  }
+};
+
+/* value noise is hash based, the table is ignored and there is no 3D variant */
+struct value
+{
+  static NOISE_HPP_INLINE float sample(const unsigned char *, float x, float y)
+  {
+    return noise_value_2(x, y, 1.0f);
+  }
+};
+
+/* #############################################################################
+ * # Rotation policies
+ * #############################################################################
+ *
+ * A matrix type provides static constexpr float m00 .. m11 (2D) or m00 .. m22 (3D).
+ * Scalars instead of arrays keep them usable from headers without out-of-line definitions.
+ */
+struct standard_matrix_2
+{
+  static constexpr float m00 = 0.80f, m01 = -0.60f;
+  static constexpr float m10 = 0.60f, m11 = 0.80f;
+};
+
+struct standard_matrix_3
+{
+  static constexpr float m00 = 0.00f, m01 = 0.80f, m02 = 0.60f;
+  static constexpr float m10 = -0.80f, m11 = 0.36f, m12 = -0.48f;
+  static constexpr float m20 = -0.60f, m21 = -0.48f, m22 = 0.64f;
+};
+
+template <int Numerator, int Denominator>
+struct lacunarity
+{
+  static constexpr float value = static_cast<float>(Numerator) / static_cast<float>(Denominator);
+};
+
+/* advances the sample point to the next octave: scale only */
+struct no_rotation
+{
+  template <typename Lacunarity>
+  static NOISE_HPP_INLINE void next(float &x, float &y)
+  {
+    x *= Lacunarity::value;
+    y *= Lacunarity::value;
+  }
+
+  template <typename Lacunarity>
+  static NOISE_HPP_INLINE void next(float &x, float &y, float &z)
+  {
+    x *= Lacunarity::value;
+    y *= Lacunarity::value;
+    z *= Lacunarity::value;
+  }
+};
+
+/* rotate then scale, as the noise_*_fbm_rotation functions */
+template <typename Matrix>
+struct rotation
+{
+  template <typename Lacunarity>
+  static NOISE_HPP_INLINE void next(float &x, float &y)
+  {
+    float tx = Matrix::m00 * x + Matrix::m01 * y;
+    float ty = Matrix::m10 * x + Matrix::m11 * y;
+
+    x = tx * Lacunarity::value;
+    y = ty * Lacunarity::value;
+  }
+
+  template <typename Lacunarity>
+  static NOISE_HPP_INLINE void next(float &x, float &y, float &z)
+  {
+    float tx = Matrix::m00 * x + Matrix::m01 * y + Matrix::m02 * z;
+    float ty = Matrix::m10 * x + Matrix::m11 * y + Matrix::m12 * z;
+    float tz = Matrix::m20 * x + Matrix::m21 * y + Matrix::m22 * z;
+
+    x = tx * Lacunarity::value;
+    y = ty * Lacunarity::value;
+    z = tz * Lacunarity::value;
+  }
+};
+
+/* #############################################################################
+ * # Fixed-octave fBm
+ * #############################################################################
+ *
+ * The octave recursion is resolved at compile time, leaving a straight-line sum.
+ * With the default lacunarity of 2 every octave scale is exact, so the results match the
+ * runtime noise_*_fbm functions bit for bit; other ratios may differ in the last ulp.
+ */
+template <typename Noise, typename Rotation, typename Lacunarity, int Octave, int Octaves>
+struct fbm_octave
+{
+  static NOISE_HPP_INLINE void run_2(const unsigned char *perm, float x, float y, float amp, float gain, float &sum, float &norm)
+  {
+    sum += amp * Noise::sample(perm, x, y);
+    norm += amp;
+    Rotation::template next<Lacunarity>(x, y);
+    fbm_octave<Noise, Rotation, Lacunarity, Octave + 1, Octaves>::run_2(perm, x, y, amp * gain, gain, sum, norm);
+  }
+
+  static NOISE_HPP_INLINE void run_3(const unsigned char *perm, float x, float y, float z, float amp, float gain, float &sum, float &norm)
+  {
+    sum += amp * Noise::sample(perm, x, y, z);
+    norm += amp;
+    Rotation::template next<Lacunarity>(x, y, z);
+    fbm_octave<Noise, Rotation, Lacunarity, Octave + 1, Octaves>::run_3(perm, x, y, z, amp * gain, gain, sum, norm);
+  }
+};
+
+template <typename Noise, typename Rotation, typename Lacunarity, int Octaves>
+struct fbm_octave<Noise, Rotation, Lacunarity, Octaves, Octaves>
+{
+  static NOISE_HPP_INLINE void run_2(const unsigned char *, float, float, float, float, float &, float &) {}
+  static NOISE_HPP_INLINE void run_3(const unsigned char *, float, float, float, float, float, float &, float &) {}
+};
+
+template <typename Noise, int Octaves, typename Rotation = no_rotation, int LacunarityNumerator = 2, int LacunarityDenominator = 1>
+struct fbm_2
+{
+  static NOISE_HPP_INLINE float sample(const unsigned char *perm, float x, float y, float frequency, float gain)
+  {
+    float sum = 0.0f, norm = 0.0f;
+
+    fbm_octave<Noise, Rotation, lacunarity<LacunarityNumerator, LacunarityDenominator>, 0, Octaves>::run_2(perm, x * frequency, y * frequency, 1.0f, gain, sum, norm);
+
+    return sum / norm;
+  }
+};
+
+template <typename Noise, int Octaves, typename Rotation = no_rotation, int LacunarityNumerator = 2, int LacunarityDenominator = 1>
+struct fbm_3
+{
+  static NOISE_HPP_INLINE float sample(const unsigned char *perm, float x, float y, float z, float frequency, float gain)
+  {
+    float sum = 0.0f, norm = 0.0f;
+
+    fbm_octave<Noise, Rotation, lacunarity<LacunarityNumerator, LacunarityDenominator>, 0, Octaves>::run_3(perm, x * frequency, y * frequency, z * frequency, 1.0f, gain, sum, norm);
+
+    return sum / norm;
+  }
+};
+
+/* #############################################################################
+ * # Expression templates (2D)
+ * #############################################################################
+ *
+ * Every node is a small value type with float operator()(x, y); composing them builds one
+ * nested type the compiler inlines into a single loop body in fill().
+ */
+template <typename Derived>
+struct expression
+{
+  NOISE_HPP_INLINE const Derived &self() const
+  {
+    return static_cast<const Derived &>(*this);
+  }
+};
+
+struct constant : expression<constant>
+{
+  float v;
+
+  explicit constant(float value) : v(value) {}
+
+  NOISE_HPP_INLINE float operator()(float, float) const
+  {
+    return v;
+  }
+};
+
+template <typename Fbm>
+struct fbm_expr : expression<fbm_expr<Fbm>>
+{
+  const unsigned char *perm;
+  float frequency, gain;
+
+  fbm_expr(const unsigned char *table, float freq, float g) : perm(table), frequency(freq), gain(g) {}
+
+  NOISE_HPP_INLINE float operator()(float x, float y) const
+  {
+    return Fbm::sample(perm, x, y, frequency, gain);
+  }
+};
+
+/* base(x + amplitude * offset_x(x, y), y + amplitude * offset_y(x, y)) */
+template <typename Base, typename OffsetX, typename OffsetY>
+struct warp_expr : expression<warp_expr<Base, OffsetX, OffsetY>>
+{
+  Base base;
+  OffsetX offset_x;
+  OffsetY offset_y;
+  float amplitude;
+
+  warp_expr(const Base &b, const OffsetX &ox, const OffsetY &oy, float a) : base(b), offset_x(ox), offset_y(oy), amplitude(a) {}
+
+  NOISE_HPP_INLINE float operator()(float x, float y) const
+  {
+    return base(x + amplitude * offset_x(x, y), y + amplitude * offset_y(x, y));
+  }
+};
+
+/* translates the sample point, e.g. to decorrelate warp offsets */
+template <typename E>
+struct shift_expr : expression<shift_expr<E>>
+{
+  E e;
+  float dx, dy;
+
+  shift_expr(const E &inner, float x, float y) : e(inner), dx(x), dy(y) {}
+
+  NOISE_HPP_INLINE float operator()(float x, float y) const
+  {
+    return e(x + dx, y + dy);
+  }
+};
+
+template <typename E>
+struct remap_expr : expression<remap_expr<E>>
+{
+  E e;
+  float in_lo, scale, out_lo;
+
+  remap_expr(const E &inner, float a, float b, float c, float d) : e(inner), in_lo(a), scale(b != a ? (d - c) / (b - a) : 0.0f), out_lo(c) {}
+
+  NOISE_HPP_INLINE float operator()(float x, float y) const
+  {
+    return out_lo + (e(x, y) - in_lo) * scale;
+  }
+};
+
+template <typename E>
+struct smoothstep_expr : expression<smoothstep_expr<E>>
+{
+  E e;
+  float edge0, edge1;
+
+  smoothstep_expr(const E &inner, float a, float b) : e(inner), edge0(a), edge1(b) {}
+
+  NOISE_HPP_INLINE float operator()(float x, float y) const
+  {
+    return noise_smoothstep(edge0, edge1, e(x, y));
+  }
+};
+
+template <typename A, typename B, typename Op>
+struct binary_expr : expression<binary_expr<A, B, Op>>
+{
+  A a;
+  B b;
+
+  binary_expr(const A &l, const B &r) : a(l), b(r) {}
+
+  NOISE_HPP_INLINE float operator()(float x, float y) const
+  {
+    return Op::apply(a(x, y), b(x, y));
+  }
+};
+
+struct op_add
+{
+  static NOISE_HPP_INLINE float apply(float a, float b) { return a + b; }
+};
+
+struct op_sub
+{
+  static NOISE_HPP_INLINE float apply(float a, float b) { return a - b; }
+};
+
+struct op_mul
+{
+  static NOISE_HPP_INLINE float apply(float a, float b) { return a * b; }
+};
+
+template <typename Base, typename OffsetX, typename OffsetY>
+NOISE_HPP_INLINE warp_expr<Base, OffsetX, OffsetY> warp(const expression<Base> &base, const expression<OffsetX> &offset_x, const expression<OffsetY> &offset_y, float amplitude)
+{
+  return warp_expr<Base, OffsetX, OffsetY>(base.self(), offset_x.self(), offset_y.self(), amplitude);
+}
+
+template <typename E>
+NOISE_HPP_INLINE shift_expr<E> shift(const expression<E> &e, float dx, float dy)
+{
+  return shift_expr<E>(e.self(), dx, dy);
+}
+
+template <typename E>
+NOISE_HPP_INLINE remap_expr<E> remap(const expression<E> &e, float in_lo, float in_hi, float out_lo, float out_hi)
+{
+  return remap_expr<E>(e.self(), in_lo, in_hi, out_lo, out_hi);
+}
+
+template <typename E>
+NOISE_HPP_INLINE smoothstep_expr<E> smoothstep(const expression<E> &e, float edge0, float edge1)
+{
+  return smoothstep_expr<E>(e.self(), edge0, edge1);
+}
+
+template <typename A, typename B>
+NOISE_HPP_INLINE binary_expr<A, B, op_add> operator+(const expression<A> &a, const expression<B> &b)
+{
+  return binary_expr<A, B, op_add>(a.self(), b.self());
+}
+
+template <typename A, typename B>
+NOISE_HPP_INLINE binary_expr<A, B, op_sub> operator-(const expression<A> &a, const expression<B> &b)
+{
+  return binary_expr<A, B, op_sub>(a.self(), b.self());
+}
+
+template <typename A, typename B>
+NOISE_HPP_INLINE binary_expr<A, B, op_mul> operator*(const expression<A> &a, const expression<B> &b)
+{
+  return binary_expr<A, B, op_mul>(a.self(), b.self());
+}
+
+template <typename A>
+NOISE_HPP_INLINE binary_expr<A, constant, op_add> operator+(const expression<A> &a, float b)
+{
+  return binary_expr<A, constant, op_add>(a.self(), constant(b));
+}
+
+template <typename A>
+NOISE_HPP_INLINE binary_expr<A, constant, op_mul> operator*(const expression<A> &a, float b)
+{
+  return binary_expr<A, constant, op_mul>(a.self(), constant(b));
+}
+
+/* evaluates e over a row-major width x height grid in one fused loop */
+template <typename E>
+NOISE_HPP_INLINE void fill(const expression<E> &e, float *out, int width, int height, float origin_x, float origin_y, float spacing)
+{
+  const E &f = e.self();
+  int x, y;
+
+  for (y = 0; y < height; ++y)
+  {
+    float py = origin_y + static_cast<float>(y) * spacing;
+
+    for (x = 0; x < width; ++x)
+    {
+      out[y * width + x] = f(origin_x + static_cast<float>(x) * spacing, py);
+    }
+  }
+}
+
+} /* namespace noise */
+
+#endif /* NOISE_HPP */
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+*/
@@ -6,3 +6,8 @@ set SOURCE_NAME=noise_test
 
 clang -s -O2 %DEF_FLAGS_COMPILER% -o %SOURCE_NAME%.exe %SOURCE_NAME%.c %DEF_FLAGS_LINKER%
 %SOURCE_NAME%.exe
+
+set SOURCE_NAME=noise_test_profile
+
+clang -s -O2 %DEF_FLAGS_COMPILER% -o %SOURCE_NAME%.exe %SOURCE_NAME%.c %DEF_FLAGS_LINKER%
+%SOURCE_NAME%.exe
@@ -0,0 +1,8 @@
+@echo off
+
+set DEF_FLAGS_COMPILER=-std=c89 -pedantic -Wall -Wextra -Werror -Wvla -Wconversion -Wdouble-promotion -Wsign-conversion -Wmissing-field-initializers -Wuninitialized -Winit-self -Wunused -Wunused-macros -Wunused-local-typedefs -D_CRT_SECURE_NO_WARNINGS
+set DEF_FLAGS_LINKER=
+set SOURCE_NAME=noise_bench
+
+clang -s -O2 %DEF_FLAGS_COMPILER% -o %SOURCE_NAME%.exe %SOURCE_NAME%.c %DEF_FLAGS_LINKER%
+%SOURCE_NAME%.exe --csv %SOURCE_NAME%.csv %*
@@ -0,0 +1,622 @@
+/* noise.h - v0.4 - public domain data structures - nickscha 2025
+
+A C89 standard compliant, single header, nostdlib (no C Standard Library) Noise Generation (NOISE).
+
+This Benchmark measures the throughput of every noise, fBm, rotation, domain warp and erosion
+entry point so regressions between releases become visible.
+
+USAGE
+
+  noise_bench [--quick] [--min-time <seconds>] [--csv <file>] [--baseline <file>] [--threshold <fraction>]
+
+  --quick       smaller grids and shorter runs (CI smoke test)
+  --min-time    minimum measured time per case, default 0.25s
+  --csv         write all results as CSV (name,octaves,size,ns_per_item,items_per_sec)
+  --baseline    compare against a CSV written by an earlier run
+  --threshold   allowed slowdown against the baseline before failing, default 0.10 (10%)
+
+  Items are samples for the noise functions (all 8 seeds of a sample for the ensemble case),
+  cells x iterations for the erosion passes and rays for the heightfield queries.
+
+  Define NOISE_BENCH_THREADS (and link with -pthread) to also measure thread scaling of the
+  row-banded tile fill.
+
+LICENSE
+
+  Placed in the public domain and also MIT licensed.
+  See end of file for detailed license information.
+
+*/
+#ifdef NOISE_BENCH_THREADS
+#define _POSIX_C_SOURCE 199309L /* clock_gettime */
+#endif
+
+#include "../noise.h" /* Noise Generation */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef NOISE_BENCH_THREADS
+#include <pthread.h>
+#endif
+
+#define NOISE_BENCH_MAX_SIZE 512
+#define NOISE_BENCH_MAX_RESULTS 256
+#define NOISE_BENCH_NAME 64
+
+static float noise_bench_grid[NOISE_BENCH_MAX_SIZE * NOISE_BENCH_MAX_SIZE];
+static float noise_bench_scratch[NOISE_BENCH_MAX_SIZE * NOISE_BENCH_MAX_SIZE + 2 * NOISE_BENCH_MAX_SIZE];
+static float noise_bench_xs[NOISE_BENCH_MAX_SIZE * NOISE_BENCH_MAX_SIZE];
+static float noise_bench_ys[NOISE_BENCH_MAX_SIZE * NOISE_BENCH_MAX_SIZE];
+static volatile float noise_bench_sink;
+
+static float m2[2][2] = {
+    {0.80f, -0.60f},
+    {0.60f, 0.80f}};
+
+static float m3[3][3] = {
+    {0.00f, 0.80f, 0.60f},
+    {-0.80f, 0.36f, -0.48f},
+    {-0.60f, -0.48f, 0.64f}};
+
+typedef void (*noise_bench_function)(float *out, int size, int octaves);
+
+typedef struct noise_bench_case
+{
+  char *name;
+  noise_bench_function function;
+  int fbm; /* 1 if it is measured across octave counts */
+
+} noise_bench_case;
+
+typedef struct noise_bench_result
+{
+  char name[NOISE_BENCH_NAME];
+  int octaves;
+  int size;
+  double ns_per_item;
+  double items_per_sec;
+
+} noise_bench_result;
+
+static noise_bench_result noise_bench_results[NOISE_BENCH_MAX_RESULTS];
+static int noise_bench_result_count;
+
+/* one grid loop per entry point so the call inlines like it would in user code */
+#define NOISE_BENCH_GRID(name, call)                    \
+  static void name(float *out, int size, int octaves)   \
+  {                                                     \
+    int x, y;                                           \
+    (void)octaves;                                      \
+    for (y = 0; y < size; ++y)                          \
+    {                                                   \
+      for (x = 0; x < size; ++x)                        \
+      {                                                 \
+        float px = (float)x, py = (float)y, pz = 13.0f; \
+        (void)pz;                                       \
+        out[y * size + x] = call;                       \
+      }                                                 \
+    }                                                   \
+  }
+
+/* Base noise */
+NOISE_BENCH_GRID(noise_bench_perlin_2, noise_perlin_2(px, py, 0.01f))
+NOISE_BENCH_GRID(noise_bench_perlin_3, noise_perlin_3(px, py, pz, 0.01f))
+NOISE_BENCH_GRID(noise_bench_simplex_2, noise_simplex_2(px, py, 0.01f))
+NOISE_BENCH_GRID(noise_bench_simplex_3, noise_simplex_3(px, py, pz, 0.01f))
+NOISE_BENCH_GRID(noise_bench_value_2, noise_value_2(px, py, 0.01f))
+
+/* fBm */
+NOISE_BENCH_GRID(noise_bench_perlin_2_fbm, noise_perlin_2_fbm(px, py, 0.01f, octaves, 2.0f, 0.5f))
+NOISE_BENCH_GRID(noise_bench_perlin_3_fbm, noise_perlin_3_fbm(px, py, pz, 0.01f, octaves, 2.0f, 0.5f))
+NOISE_BENCH_GRID(noise_bench_simplex_2_fbm, noise_simplex_2_fbm(px, py, 0.01f, octaves, 2.0f, 0.5f))
+NOISE_BENCH_GRID(noise_bench_simplex_3_fbm, noise_simplex_3_fbm(px, py, pz, 0.01f, octaves, 2.0f, 0.5f))
+NOISE_BENCH_GRID(noise_bench_value_2_fbm, noise_value_2_fbm(px, py, 0.01f, octaves, 2.0f, 0.5f))
+
+/* fBm with rotation */
+NOISE_BENCH_GRID(noise_bench_perlin_2_fbm_rotation, noise_perlin_2_fbm_rotation(px, py, 0.01f, octaves, 2.0f, 0.5f, m2))
+NOISE_BENCH_GRID(noise_bench_perlin_3_fbm_rotation, noise_perlin_3_fbm_rotation(px, py, pz, 0.01f, octaves, 2.0f, 0.5f, m3))
+NOISE_BENCH_GRID(noise_bench_simplex_2_fbm_rotation, noise_simplex_2_fbm_rotation(px, py, 0.01f, octaves, 2.0f, 0.5f, m2))
+NOISE_BENCH_GRID(noise_bench_simplex_3_fbm_rotation, noise_simplex_3_fbm_rotation(px, py, pz, 0.01f, octaves, 2.0f, 0.5f, m3))
+NOISE_BENCH_GRID(noise_bench_value_2_fbm_rotation, noise_value_2_fbm_rotation(px, py, 0.01f, octaves, 2.0f, 0.5f, m2))
+
+/* Domain warp */
+NOISE_BENCH_GRID(noise_bench_simplex_2_domain_warp, noise_simplex_2_domain_warp(px, py, 0.01f, 4.0f))
+NOISE_BENCH_GRID(noise_bench_simplex_2_domain_warp_fbm, noise_simplex_2_domain_warp_fbm(px, py, 0.01f, octaves, 2.0f, 0.5f, 4.0f))
+NOISE_BENCH_GRID(noise_bench_simplex_2_domain_warp_fbm_rotation, noise_simplex_2_domain_warp_fbm_rotation(px, py, 0.01f, octaves, 2.0f, 0.5f, 4.0f, m2))
+
+/* Grid paths: batch, tile and spectral synthesis */
+static void noise_bench_simplex_2_fbm_batch(float *out, int size, int octaves)
+{
+  noise_simplex_2_fbm_batch(noise_bench_xs, noise_bench_ys, out, size * size, 0.01f, octaves, 2.0f, 0.5f);
+}
+
+static void noise_bench_simplex_2_fbm_tile(float *out, int size, int octaves)
+{
+  noise_simplex_2_fbm_tile(out, size, size, 0.0f, 0.0f, 1.0f, 0.01f, octaves, 2.0f, 0.5f, 0);
+}
+
+static void noise_bench_spectral_2(float *out, int size, int octaves)
+{
+  (void)octaves;
+  noise_spectral_2(out, noise_bench_scratch, size, size, 2.5f, 1337);
+}
+
+/* Fixed-point rows */
+static short noise_bench_q15[NOISE_BENCH_MAX_SIZE * NOISE_BENCH_MAX_SIZE];
+
+static void noise_bench_perlin_2_tile_q15(float *out, int size, int octaves)
+{
+  (void)out;
+  (void)octaves;
+  noise_tile_2_q15(noise_bench_q15, size, size, NOISE_TYPE_PERLIN, 0.0f, 0.0f, 1.0f, 0.01f);
+}
+
+static void noise_bench_simplex_2_tile_q15(float *out, int size, int octaves)
+{
+  (void)out;
+  (void)octaves;
+  noise_tile_2_q15(noise_bench_q15, size, size, NOISE_TYPE_SIMPLEX, 0.0f, 0.0f, 1.0f, 0.01f);
+}
+
+static void noise_bench_value_2_tile_q15(float *out, int size, int octaves)
+{
+  (void)out;
+  (void)octaves;
+  noise_tile_2_q15(noise_bench_q15, size, size, NOISE_TYPE_VALUE, 0.0f, 0.0f, 1.0f, 0.01f);
+}
+
+/* Heightfield rays: size * size rays sloping down over a size x size fBm map */
+static float noise_bench_nodes[3 * NOISE_BENCH_MAX_SIZE * NOISE_BENCH_MAX_SIZE]; /* >= noise_pyramid_size */
+static float noise_bench_heightfield[NOISE_BENCH_MAX_SIZE * NOISE_BENCH_MAX_SIZE];
+
+static void noise_bench_pyramid_raycast(float *out, int size, int octaves)
+{
+  static noise_pyramid pyramid;
+  static int built;
+  float origin[3], direction[3];
+  int x, y;
+
+  (void)octaves;
+
+  if (built != size)
+  {
+    noise_simplex_2_fbm_tile(noise_bench_heightfield, size, size, 0.0f, 0.0f, 1.0f, 0.01f, 6, 2.0f, 0.5f, 0);
+    noise_pyramid_build(&pyramid, noise_bench_heightfield, size, size, noise_bench_nodes);
+    built = size;
+  }
+
+  direction[0] = (float)size * 0.5f;
+  direction[1] = (float)size * 0.3f;
+  direction[2] = -1.5f;
+
+  for (y = 0; y < size; ++y)
+  {
+    for (x = 0; x < size; ++x)
+    {
+      origin[0] = (float)x;
+      origin[1] = (float)y;
+      origin[2] = 1.0f;
+
+      if (!noise_pyramid_raycast(&pyramid, origin, direction, 1.0f, &out[y * size + x]))
+      {
+        out[y * size + x] = -1.0f;
+      }
+    }
+  }
+}
+
+/* Seed ensembles: every sample is evaluated for 8 seeds into 8 planes */
+static float noise_bench_planes[8 * NOISE_BENCH_MAX_SIZE * NOISE_BENCH_MAX_SIZE];
+
+static void noise_bench_simplex_2_fbm_ensemble_8(float *out, int size, int octaves)
+{
+  static unsigned int seeds[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+  static noise_ensemble ensemble;
+  noise_channel channel = {NOISE_TYPE_SIMPLEX, 0.01f, 0, 2.0f, 0.5f, 0.0f, 0.0f, 0};
+
+  if (ensemble.count == 0)
+  {
+    noise_ensemble_init(&ensemble, seeds, 8);
+  }
+
+  channel.octaves = octaves;
+  noise_ensemble_channel_2(&ensemble, &channel, noise_bench_planes, size, size, 0.0f, 0.0f, 1.0f);
+  out[size / 2] = noise_bench_planes[7 * size * size + size / 2];
+}
+
+static noise_bench_case noise_bench_cases[] = {
+    {"perlin_2", noise_bench_perlin_2, 0},
+    {"perlin_3", noise_bench_perlin_3, 0},
+    {"simplex_2", noise_bench_simplex_2, 0},
+    {"simplex_3", noise_bench_simplex_3, 0},
+    {"value_2", noise_bench_value_2, 0},
+    {"perlin_2_fbm", noise_bench_perlin_2_fbm, 1},
+    {"perlin_3_fbm", noise_bench_perlin_3_fbm, 1},
+    {"simplex_2_fbm", noise_bench_simplex_2_fbm, 1},
+    {"simplex_3_fbm", noise_bench_simplex_3_fbm, 1},
+    {"value_2_fbm", noise_bench_value_2_fbm, 1},
+    {"perlin_2_fbm_rotation", noise_bench_perlin_2_fbm_rotation, 1},
+    {"perlin_3_fbm_rotation", noise_bench_perlin_3_fbm_rotation, 1},
+    {"simplex_2_fbm_rotation", noise_bench_simplex_2_fbm_rotation, 1},
+    {"simplex_3_fbm_rotation", noise_bench_simplex_3_fbm_rotation, 1},
+    {"value_2_fbm_rotation", noise_bench_value_2_fbm_rotation, 1},
+    {"simplex_2_domain_warp", noise_bench_simplex_2_domain_warp, 0},
+    {"simplex_2_domain_warp_fbm", noise_bench_simplex_2_domain_warp_fbm, 1},
+    {"simplex_2_domain_warp_fbm_rotation", noise_bench_simplex_2_domain_warp_fbm_rotation, 1},
+    {"simplex_2_fbm_batch", noise_bench_simplex_2_fbm_batch, 1},
+    {"simplex_2_fbm_tile", noise_bench_simplex_2_fbm_tile, 1},
+    {"spectral_2", noise_bench_spectral_2, 0},
+    {"perlin_2_tile_q15", noise_bench_perlin_2_tile_q15, 0},
+    {"simplex_2_tile_q15", noise_bench_simplex_2_tile_q15, 0},
+    {"value_2_tile_q15", noise_bench_value_2_tile_q15, 0},
+    {"pyramid_raycast", noise_bench_pyramid_raycast, 0},
+    {"simplex_2_fbm_ensemble_8", noise_bench_simplex_2_fbm_ensemble_8, 1}};
+
+static void noise_bench_record(char *name, int octaves, int size, double seconds, double items)
+{
+  noise_bench_result *r;
+
+  if (noise_bench_result_count >= NOISE_BENCH_MAX_RESULTS)
+  {
+    return;
+  }
+
+  r = &noise_bench_results[noise_bench_result_count++];
+  strncpy(r->name, name, NOISE_BENCH_NAME - 1);
+  r->name[NOISE_BENCH_NAME - 1] = 0;
+  r->octaves = octaves;
+  r->size = size;
+  r->ns_per_item = seconds * 1e9 / items;
+  r->items_per_sec = items / seconds;
+
+  printf("%-40s %3d %5d %12.2f ns %16.0f /s\n", r->name, octaves, size, r->ns_per_item, r->items_per_sec);
+}
+
+static double noise_bench_seconds(clock_t begin)
+{
+  return (double)(clock() - begin) / (double)CLOCKS_PER_SEC;
+}
+
+/* repeats a grid fill until min_time has passed */
+static void noise_bench_run(noise_bench_case *c, int size, int octaves, double min_time)
+{
+  double seconds, items = 0.0;
+  clock_t begin;
+
+  c->function(noise_bench_grid, size, octaves); /* warm up */
+
+  begin = clock();
+
+  do
+  {
+    c->function(noise_bench_grid, size, octaves);
+    items += (double)size * (double)size;
+    seconds = noise_bench_seconds(begin);
+  } while (seconds < min_time);
+
+  noise_bench_sink = noise_bench_grid[size / 2];
+  noise_bench_record(c->name, c->fbm ? octaves : 1, size, seconds, items);
+}
+
+static void noise_bench_terrain(int size)
+{
+  noise_simplex_2_fbm_tile(noise_bench_grid, size, size, 0.0f, 0.0f, 1.0f, 0.01f, 5, 2.0f, 0.5f, 0);
+}
+
+/* erosion is reported as cells/sec over all iterations */
+static void noise_bench_erosion(int size, double min_time)
+{
+  int kind;
+
+  for (kind = 0; kind < 4; ++kind)
+  {
+    static char *names[4] = {"erosion_thermal", "erosion_hydraulic", "erosion_wind", "erosion_thermal_tiled"};
+    static float scratch[3 * NOISE_BENCH_MAX_SIZE];
+    noise_layout row_major, tiled;
+    double seconds = 0.0, items = 0.0;
+    int iterations = 10;
+
+    noise_layout_init(&row_major, NOISE_LAYOUT_ROW_MAJOR, size, size, 0);
+    noise_layout_init(&tiled, NOISE_LAYOUT_TILED, size, size, 6);
+
+    do
+    {
+      clock_t begin;
+
+      noise_bench_terrain(size);
+
+      if (kind == 3)
+      {
+        noise_layout_convert(noise_bench_grid, &row_major, noise_bench_heightfield, &tiled);
+      }
+
+      begin = clock();
+
+      if (kind == 0)
+      {
+        noise_erosion_thermal(noise_bench_grid, size, size, 0.02f, iterations);
+      }
+      else if (kind == 1)
+      {
+        noise_erosion_hydraulic(noise_bench_grid, size, size, iterations, 0.05f, 0.1f, 0.05f, 0.4f, 0.2f);
+      }
+      else if (kind == 2)
+      {
+        noise_erosion_wind(noise_bench_grid, size, size, 1.0f, 0.5f, 0.02f, iterations);
+      }
+      else
+      {
+        noise_erosion_thermal_layout(noise_bench_heightfield, &tiled, 0.02f, iterations, scratch);
+      }
+
+      seconds += noise_bench_seconds(begin);
+      items += (double)size * (double)size * (double)iterations;
+    } while (seconds < min_time);
+
+    noise_bench_sink = noise_bench_grid[size / 2];
+    noise_bench_record(names[kind], 1, size, seconds, items);
+  }
+}
+
+#ifdef NOISE_BENCH_THREADS
+typedef struct noise_bench_band
+{
+  float *out;
+  int size;
+  int row_begin;
+  int row_end;
+
+} noise_bench_band;
+
+static void *noise_bench_band_run(void *user)
+{
+  noise_bench_band *b = (noise_bench_band *)user;
+
+  noise_simplex_2_fbm_tile(b->out + b->row_begin * b->size, b->size, b->row_end - b->row_begin, 0.0f, (float)b->row_begin, 1.0f, 0.01f, 6, 2.0f, 0.5f, 0);
+
+  return 0;
+}
+
+static double noise_bench_wall(void)
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+
+  return (double)t.tv_sec + (double)t.tv_nsec * 1e-9;
+}
+
+/* clock() sums CPU time over threads, so scaling is measured in wall time */
+static void noise_bench_threads(int size, double min_time)
+{
+  int threads;
+
+  for (threads = 1; threads <= 8; threads *= 2)
+  {
+    pthread_t handles[8];
+    noise_bench_band bands[8];
+    char name[NOISE_BENCH_NAME];
+    double items = 0.0, seconds;
+    double begin = noise_bench_wall();
+    int t;
+
+    do
+    {
+      for (t = 0; t < threads; ++t)
+      {
+        bands[t].out = noise_bench_grid;
+        bands[t].size = size;
+        bands[t].row_begin = size * t / threads;
+        bands[t].row_end = size * (t + 1) / threads;
+        pthread_create(&handles[t], 0, noise_bench_band_run, &bands[t]);
+      }
+
+      for (t = 0; t < threads; ++t)
+      {
+        pthread_join(handles[t], 0);
+      }
+
+      items += (double)size * (double)size;
+      seconds = noise_bench_wall() - begin;
+    } while (seconds < min_time);
+
+    sprintf(name, "simplex_2_fbm_tile_threads_%d", threads);
+    noise_bench_record(name, 6, size, seconds, items);
+  }
+}
+#endif
+
+static int noise_bench_write_csv(char *filename)
+{
+  FILE *f = fopen(filename, "w");
+  int i;
+
+  if (!f)
+  {
+    fprintf(stderr, "[bench] cannot write %s\n", filename);
+    return 0;
+  }
+
+  fprintf(f, "name,octaves,size,ns_per_item,items_per_sec\n");
+
+  for (i = 0; i < noise_bench_result_count; ++i)
+  {
+    noise_bench_result *r = &noise_bench_results[i];
+    fprintf(f, "%s,%d,%d,%.4f,%.1f\n", r->name, r->octaves, r->size, r->ns_per_item, r->items_per_sec);
+  }
+
+  fclose(f);
+  printf("[bench] %s written.\n", filename);
+
+  return 1;
+}
+
+/* returns the number of cases slower than the baseline by more than threshold */
+static int noise_bench_compare(char *filename, double threshold)
+{
+  FILE *f = fopen(filename, "r");
+  char line[256];
+  int regressions = 0;
+
+  if (!f)
+  {
+    fprintf(stderr, "[bench] cannot read baseline %s\n", filename);
+    return 1;
+  }
+
+  while (fgets(line, (int)sizeof(line), f))
+  {
+    char name[NOISE_BENCH_NAME];
+    int octaves, size, i;
+    double ns, per_sec;
+
+    if (sscanf(line, "%63[^,],%d,%d,%lf,%lf", name, &octaves, &size, &ns, &per_sec) != 5)
+    {
+      continue; /* header */
+    }
+
+    for (i = 0; i < noise_bench_result_count; ++i)
+    {
+      noise_bench_result *r = &noise_bench_results[i];
+
+      if (r->octaves == octaves && r->size == size && strcmp(r->name, name) == 0)
+      {
+        double change = r->ns_per_item / ns - 1.0;
+
+        if (change > threshold)
+        {
+          printf("[bench] REGRESSION %-40s %3d %5d %10.2f -> %10.2f ns (%+.1f%%)\n", name, octaves, size, ns, r->ns_per_item, change * 100.0);
+          ++regressions;
+        }
+      }
+    }
+  }
+
+  fclose(f);
+  printf("[bench] %d regression(s) above %.1f%% against %s\n", regressions, threshold * 100.0, filename);
+
+  return regressions;
+}
+
+int main(int argc, char **argv)
+{
+  static int sizes[] = {64, 256, 512};
+  static int octaves[] = {1, 4, 8};
+  char *csv = 0, *baseline = 0;
+  double min_time = 0.25, threshold = 0.10;
+  int size_count = 3, i, s, o, c;
+
+  for (i = 1; i < argc; ++i)
+  {
+    if (strcmp(argv[i], "--quick") == 0)
+    {
+      size_count = 1;
+      min_time = 0.02;
+    }
+    else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+    {
+      min_time = atof(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc)
+    {
+      csv = argv[++i];
+    }
+    else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)
+    {
+      baseline = argv[++i];
+    }
+    else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc)
+    {
+      threshold = atof(argv[++i]);
+    }
+    else
+    {
+      fprintf(stderr, "usage: %s [--quick] [--min-time s] [--csv file] [--baseline file] [--threshold fraction]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  noise_seed(1337);
+
+  for (i = 0; i < NOISE_BENCH_MAX_SIZE * NOISE_BENCH_MAX_SIZE; ++i)
+  {
+    noise_bench_xs[i] = (float)(i % NOISE_BENCH_MAX_SIZE);
+    noise_bench_ys[i] = (float)(i / NOISE_BENCH_MAX_SIZE);
+  }
+
+  printf("%-40s %3s %5s %15s %18s\n", "name", "oct", "size", "ns/item", "items/sec");
+
+  for (s = 0; s < size_count; ++s)
+  {
+    for (c = 0; c < (int)(sizeof(noise_bench_cases) / sizeof(noise_bench_cases[0])); ++c)
+    {
+      for (o = 0; o < (noise_bench_cases[c].fbm ? 3 : 1); ++o)
+      {
+        noise_bench_run(&noise_bench_cases[c], sizes[s], octaves[o], min_time);
+      }
+    }
+
+    noise_bench_erosion(sizes[s], min_time);
+  }
+
+#ifdef NOISE_BENCH_THREADS
+  noise_bench_threads(sizes[size_count - 1], min_time);
+#endif
+
+  if (csv && !noise_bench_write_csv(csv))
+  {
+    return 1;
+  }
+
+  if (baseline && noise_bench_compare(baseline, threshold) > 0)
+  {
+    return 1;
+  }
+
+  return 0;
+}
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+*/
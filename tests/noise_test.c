@@ -1,4 +1,4 @@
-/* noise.h - v0.3 - public domain data structures - nickscha 2025
+/* noise.h - v0.4 - public domain data structures - nickscha 2025
 
 A C89 standard compliant, single header, nostdlib (no C Standard Library) Noise Generation (NOISE).
 
@@ -15,6 +15,7 @@ LICENSE
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define WIDTH 512
 #define HEIGHT 512
@@ -269,6 +270,1895 @@ void noise_test_erosion(void)
   noise_export_ppm("erosion.ppm", heightmap, WIDTH, HEIGHT);
 }
 
+void noise_test_volume(void)
+{
+  static float dense[64 * 64 * 64];
+  float *volume = heightmap; /* 512 * 512 == 64 * 64 * 64 */
+  int i;
+  float max_error = 0.0f;
+
+  noise_seed(1337);
+
+  assert(noise_volume_3_fbm(dense, 64, 64, 64, 0.0f, 0.0f, 0.0f, 1.0f, 1, 1, 1, noise_simplex_3, 0.02f, 4, 2.0f, 0.5f, 0) == 1);
+  assert(noise_volume_3_fbm(volume, 64, 64, 64, 0.0f, 0.0f, 0.0f, 1.0f, 4, 4, 2, noise_simplex_3, 0.02f, 4, 2.0f, 0.5f, 0) == 1);
+
+  /* the block kernel samples the same fBm as the per-voxel function */
+  for (i = 0; i < 64 * 64 * 64; i += 97)
+  {
+    float e = dense[i] - noise_simplex_3_fbm((float)(i % 64), (float)((i / 64) % 64), (float)(i / 4096), 0.02f, 4, 2.0f, 0.5f);
+    e = e < 0.0f ? -e : e;
+    max_error = e > max_error ? e : max_error;
+  }
+
+  assert(max_error < 1e-5f);
+  max_error = 0.0f;
+
+  /* coarse lattice voxels are exact samples */
+  assert(volume[0] == dense[0]);
+  assert(volume[(8 * 64 + 4) * 64 + 12] == dense[(8 * 64 + 4) * 64 + 12]);
+  assert(volume[(63 * 64 + 63) * 64 + 63] == dense[(63 * 64 + 63) * 64 + 63]);
+
+  /* upsampled voxels stay close to the dense field */
+  for (i = 0; i < 64 * 64 * 64; ++i)
+  {
+    float e = volume[i] - dense[i];
+    e = e < 0.0f ? -e : e;
+    max_error = e > max_error ? e : max_error;
+  }
+
+  test(max_error < 0.25f);
+
+  /* an octave count that does not fit a plan leaves the volume untouched */
+  dense[0] = 42.0f;
+  assert(noise_volume_3_fbm(dense, 64, 64, 64, 0.0f, 0.0f, 0.0f, 1.0f, 1, 1, 1, noise_simplex_3, 0.02f, 0, 2.0f, 0.5f, 0) == 0);
+  assert(dense[0] == 42.0f);
+}
+
+void noise_test_batch(void)
+{
+  static float xs[1000], ys[1000], zs[1000], out[1000];
+  float m2[2][2] = {
+      {0.80f, -0.60f},
+      {0.60f, 0.80f}};
+  float m3[3][3] = {
+      {0.00f, 0.80f, 0.60f},
+      {-0.80f, 0.36f, -0.48f},
+      {-0.60f, -0.48f, 0.64f}};
+  float max_error = 0.0f;
+  int i;
+
+  noise_seed(1337);
+
+  /* 1000 is not a multiple of the block size so the tail path is covered */
+  for (i = 0; i < 1000; ++i)
+  {
+    xs[i] = (float)(i % 37) * 13.7f - 200.0f;
+    ys[i] = (float)(i % 91) * 5.3f;
+    zs[i] = (float)(i % 11) * 21.1f - 50.0f;
+  }
+
+#define NOISE_TEST_BATCH_CHECK(batch_call, scalar_call)     \
+  batch_call;                                               \
+  for (i = 0; i < 1000; ++i)                                \
+  {                                                         \
+    float e = out[i] - (scalar_call);                       \
+    e = e < 0.0f ? -e : e;                                  \
+    max_error = e > max_error ? e : max_error;              \
+  }
+
+  NOISE_TEST_BATCH_CHECK(noise_perlin_2_batch(xs, ys, out, 1000, 0.01f), noise_perlin_2(xs[i], ys[i], 0.01f))
+  NOISE_TEST_BATCH_CHECK(noise_perlin_3_batch(xs, ys, zs, out, 1000, 0.01f), noise_perlin_3(xs[i], ys[i], zs[i], 0.01f))
+  NOISE_TEST_BATCH_CHECK(noise_perlin_2_fbm_batch(xs, ys, out, 1000, 0.01f, 4, 2.0f, 0.5f), noise_perlin_2_fbm(xs[i], ys[i], 0.01f, 4, 2.0f, 0.5f))
+  NOISE_TEST_BATCH_CHECK(noise_perlin_2_fbm_rotation_batch(xs, ys, out, 1000, 0.01f, 9, 1.9f, 0.55f, m2), noise_perlin_2_fbm_rotation(xs[i], ys[i], 0.01f, 9, 1.9f, 0.55f, m2))
+  NOISE_TEST_BATCH_CHECK(noise_perlin_3_fbm_batch(xs, ys, zs, out, 1000, 0.01f, 4, 2.0f, 0.5f), noise_perlin_3_fbm(xs[i], ys[i], zs[i], 0.01f, 4, 2.0f, 0.5f))
+  NOISE_TEST_BATCH_CHECK(noise_perlin_3_fbm_rotation_batch(xs, ys, zs, out, 1000, 0.01f, 9, 1.9f, 0.55f, m3), noise_perlin_3_fbm_rotation(xs[i], ys[i], zs[i], 0.01f, 9, 1.9f, 0.55f, m3))
+  NOISE_TEST_BATCH_CHECK(noise_simplex_2_batch(xs, ys, out, 1000, 0.01f), noise_simplex_2(xs[i], ys[i], 0.01f))
+  NOISE_TEST_BATCH_CHECK(noise_simplex_3_batch(xs, ys, zs, out, 1000, 0.01f), noise_simplex_3(xs[i], ys[i], zs[i], 0.01f))
+  NOISE_TEST_BATCH_CHECK(noise_simplex_2_fbm_batch(xs, ys, out, 1000, 0.01f, 4, 2.0f, 0.5f), noise_simplex_2_fbm(xs[i], ys[i], 0.01f, 4, 2.0f, 0.5f))
+  NOISE_TEST_BATCH_CHECK(noise_simplex_2_fbm_rotation_batch(xs, ys, out, 1000, 0.01f, 9, 1.9f, 0.55f, m2), noise_simplex_2_fbm_rotation(xs[i], ys[i], 0.01f, 9, 1.9f, 0.55f, m2))
+  NOISE_TEST_BATCH_CHECK(noise_simplex_3_fbm_batch(xs, ys, zs, out, 1000, 0.01f, 4, 2.0f, 0.5f), noise_simplex_3_fbm(xs[i], ys[i], zs[i], 0.01f, 4, 2.0f, 0.5f))
+  NOISE_TEST_BATCH_CHECK(noise_simplex_3_fbm_rotation_batch(xs, ys, zs, out, 1000, 0.01f, 9, 1.9f, 0.55f, m3), noise_simplex_3_fbm_rotation(xs[i], ys[i], zs[i], 0.01f, 9, 1.9f, 0.55f, m3))
+  NOISE_TEST_BATCH_CHECK(noise_simplex_2_domain_warp_batch(xs, ys, out, 1000, 0.01f, 5.0f), noise_simplex_2_domain_warp(xs[i], ys[i], 0.01f, 5.0f))
+  NOISE_TEST_BATCH_CHECK(noise_simplex_2_domain_warp_fbm_batch(xs, ys, out, 1000, 0.01f, 4, 2.0f, 0.5f, -20.0f), noise_simplex_2_domain_warp_fbm(xs[i], ys[i], 0.01f, 4, 2.0f, 0.5f, -20.0f))
+  NOISE_TEST_BATCH_CHECK(noise_simplex_2_domain_warp_fbm_rotation_batch(xs, ys, out, 1000, 0.01f, 3, 2.0f, 0.5f, -20.0f, m2), noise_simplex_2_domain_warp_fbm_rotation(xs[i], ys[i], 0.01f, 3, 2.0f, 0.5f, -20.0f, m2))
+  NOISE_TEST_BATCH_CHECK(noise_value_2_batch(xs, ys, out, 1000, 0.01f), noise_value_2(xs[i], ys[i], 0.01f))
+  NOISE_TEST_BATCH_CHECK(noise_value_2_fbm_batch(xs, ys, out, 1000, 0.01f, 4, 2.0f, 0.5f), noise_value_2_fbm(xs[i], ys[i], 0.01f, 4, 2.0f, 0.5f))
+  NOISE_TEST_BATCH_CHECK(noise_value_2_fbm_rotation_batch(xs, ys, out, 1000, 0.01f, 9, 1.9f, 0.55f, m2), noise_value_2_fbm_rotation(xs[i], ys[i], 0.01f, 9, 1.9f, 0.55f, m2))
+
+#undef NOISE_TEST_BATCH_CHECK
+
+  assert(max_error < 1e-5f);
+}
+
+void noise_test_tile(void)
+{
+  float m2[2][2] = {
+      {0.80f, -0.60f},
+      {0.60f, 0.80f}};
+  float max_error = 0.0f;
+  int x, y;
+
+  noise_seed(1337);
+
+  noise_perlin_2_fbm_tile(heightmap, WIDTH, HEIGHT, 0.0f, 0.0f, 1.0f, 0.010f, 4, 2.0f, 0.5f, 0);
+
+  for (y = 0; y < HEIGHT; y += 7)
+  {
+    for (x = 0; x < WIDTH; x += 5)
+    {
+      float e = heightmap[y * WIDTH + x] - noise_perlin_2_fbm((float)x, (float)y, 0.010f, 4, 2.0f, 0.5f);
+      e = e < 0.0f ? -e : e;
+      max_error = e > max_error ? e : max_error;
+    }
+  }
+
+  noise_simplex_2_fbm_tile(heightmap, WIDTH, HEIGHT, 0.0f, 0.0f, 1.0f, 0.010f, 9, 1.9f, 0.55f, m2);
+
+  for (y = 0; y < HEIGHT; y += 7)
+  {
+    for (x = 0; x < WIDTH; x += 5)
+    {
+      float e = heightmap[y * WIDTH + x] - noise_simplex_2_fbm_rotation((float)x, (float)y, 0.010f, 9, 1.9f, 0.55f, m2);
+      e = e < 0.0f ? -e : e;
+      max_error = e > max_error ? e : max_error;
+    }
+  }
+
+  /* the per-octave affine map is composed once per tile, so only rounding differs */
+  assert(max_error < 1e-3f);
+
+  noise_normalize_heightmap();
+  noise_export_ppm("simplex_2_fbm_rotation_tile.ppm", heightmap, WIDTH, HEIGHT);
+}
+
+void noise_test_fbm_plan(void)
+{
+  float m2[2][2] = {
+      {0.80f, -0.60f},
+      {0.60f, 0.80f}};
+  float m3[3][3] = {
+      {0.00f, 0.80f, 0.60f},
+      {-0.80f, 0.36f, -0.48f},
+      {-0.60f, -0.48f, 0.64f}};
+  noise_fbm_plan plan_2, plan_2_rotation, plan_3, plan_3_rotation, plan_warp;
+  float max_error = 0.0f;
+  int i;
+
+  noise_seed(1337);
+
+  noise_fbm_plan_2(&plan_2, 0.010f, 4, 2.0f, 0.5f, 0);
+  noise_fbm_plan_2(&plan_2_rotation, 0.010f, 9, 1.9f, 0.55f, m2);
+  noise_fbm_plan_3(&plan_3, 0.010f, 4, 2.0f, 0.5f, 0);
+  noise_fbm_plan_3(&plan_3_rotation, 0.010f, 9, 1.9f, 0.55f, m3);
+  noise_fbm_plan_2(&plan_warp, 0.010f, 3, 2.0f, 0.5f, m2);
+
+  for (i = 0; i < 1000; ++i)
+  {
+    float x = (float)(i % 37) * 13.7f - 200.0f;
+    float y = (float)(i % 91) * 5.3f;
+    float z = (float)(i % 11) * 21.1f - 50.0f;
+    float e[11];
+    int k;
+
+    e[0] = noise_perlin_2_fbm_plan(&plan_2, x, y) - noise_perlin_2_fbm(x, y, 0.010f, 4, 2.0f, 0.5f);
+    e[1] = noise_perlin_2_fbm_plan(&plan_2_rotation, x, y) - noise_perlin_2_fbm_rotation(x, y, 0.010f, 9, 1.9f, 0.55f, m2);
+    e[2] = noise_perlin_3_fbm_plan(&plan_3, x, y, z) - noise_perlin_3_fbm(x, y, z, 0.010f, 4, 2.0f, 0.5f);
+    e[3] = noise_perlin_3_fbm_plan(&plan_3_rotation, x, y, z) - noise_perlin_3_fbm_rotation(x, y, z, 0.010f, 9, 1.9f, 0.55f, m3);
+    e[4] = noise_simplex_2_fbm_plan(&plan_2, x, y) - noise_simplex_2_fbm(x, y, 0.010f, 4, 2.0f, 0.5f);
+    e[5] = noise_simplex_2_fbm_plan(&plan_2_rotation, x, y) - noise_simplex_2_fbm_rotation(x, y, 0.010f, 9, 1.9f, 0.55f, m2);
+    e[6] = noise_simplex_3_fbm_plan(&plan_3, x, y, z) - noise_simplex_3_fbm(x, y, z, 0.010f, 4, 2.0f, 0.5f);
+    e[7] = noise_simplex_3_fbm_plan(&plan_3_rotation, x, y, z) - noise_simplex_3_fbm_rotation(x, y, z, 0.010f, 9, 1.9f, 0.55f, m3);
+    e[8] = noise_value_2_fbm_plan(&plan_2, x, y) - noise_value_2_fbm(x, y, 0.010f, 4, 2.0f, 0.5f);
+    e[9] = noise_value_2_fbm_plan(&plan_2_rotation, x, y) - noise_value_2_fbm_rotation(x, y, 0.010f, 9, 1.9f, 0.55f, m2);
+    e[10] = noise_simplex_2_domain_warp_fbm_plan(&plan_warp, x, y, -20.0f) - noise_simplex_2_domain_warp_fbm_rotation(x, y, 0.010f, 3, 2.0f, 0.5f, -20.0f, m2);
+
+    for (k = 0; k < 11; ++k)
+    {
+      float a = e[k] < 0.0f ? -e[k] : e[k];
+      max_error = a > max_error ? a : max_error;
+    }
+  }
+
+  /* composed transforms only differ from the iterative ones by rounding */
+  assert(max_error < 1e-3f);
+
+  /* octave counts a plan cannot hold are rejected, not clamped */
+  assert(noise_fbm_plan_2(&plan_2, 0.010f, NOISE_FBM_PLAN_MAX_OCTAVES, 2.0f, 0.5f, 0) == 1);
+  assert(noise_fbm_plan_2(&plan_2, 0.010f, NOISE_FBM_PLAN_MAX_OCTAVES + 1, 2.0f, 0.5f, 0) == 0);
+  assert(noise_perlin_2_fbm_plan(&plan_2, 3.0f, 4.0f) == 0.0f);
+  assert(noise_fbm_plan_3(&plan_3, 0.010f, 0, 2.0f, 0.5f, 0) == 0);
+}
+
+void noise_test_vec(void)
+{
+  float sum_ab = 0.0f, sum_aa = 0.0f, sum_bb = 0.0f, max_error = 0.0f;
+  int x, y;
+
+  noise_seed(1337);
+
+  for (y = 0; y < 128; ++y)
+  {
+    for (x = 0; x < 128; ++x)
+    {
+      float v[3], e;
+
+      noise_simplex_2_vec3((float)x, (float)y, 0.05f, v);
+
+      /* channel 0 is plain simplex noise */
+      e = v[0] - noise_simplex_2((float)x, (float)y, 0.05f);
+      e = e < 0.0f ? -e : e;
+      max_error = e > max_error ? e : max_error;
+
+      sum_ab += v[0] * v[1];
+      sum_aa += v[0] * v[0];
+      sum_bb += v[1] * v[1];
+    }
+  }
+
+  assert(max_error < 1e-5f);
+
+  /* the channels use independent gradients and must not be correlated */
+  test(sum_ab * sum_ab < 0.04f * sum_aa * sum_bb);
+}
+
+void noise_test_channels(void)
+{
+  static float planar[3 * 64 * 64];
+  static float interleaved[3 * 64 * 64];
+  float m2[2][2] = {
+      {0.80f, -0.60f},
+      {0.60f, 0.80f}};
+  noise_channel channels[3];
+  float max_error = 0.0f;
+  int mismatches = 0;
+  int x, y, c;
+
+  noise_seed(1337);
+
+  /* elevation, moisture, temperature */
+  channels[0].type = NOISE_TYPE_SIMPLEX;
+  channels[0].frequency = 0.010f;
+  channels[0].octaves = 9;
+  channels[0].lacunarity = 1.9f;
+  channels[0].gain = 0.55f;
+  channels[0].offset_x = 0.0f;
+  channels[0].offset_y = 0.0f;
+  channels[0].rotation = m2;
+
+  channels[1].type = NOISE_TYPE_PERLIN;
+  channels[1].frequency = 0.020f;
+  channels[1].octaves = 4;
+  channels[1].lacunarity = 2.0f;
+  channels[1].gain = 0.5f;
+  channels[1].offset_x = 1000.0f;
+  channels[1].offset_y = -300.0f;
+  channels[1].rotation = 0;
+
+  channels[2] = channels[1];
+  channels[2].type = NOISE_TYPE_VALUE;
+  channels[2].offset_x = -512.0f;
+
+  noise_channels_2(channels, 3, planar, 64, 64, 10.0f, 20.0f, 1.0f, 0);
+  noise_channels_2(channels, 3, interleaved, 64, 64, 10.0f, 20.0f, 1.0f, 1);
+
+  for (y = 0; y < 64; ++y)
+  {
+    for (x = 0; x < 64; ++x)
+    {
+      float px = 10.0f + (float)x, py = 20.0f + (float)y;
+      float e[3];
+
+      e[0] = planar[y * 64 + x] - noise_simplex_2_fbm_rotation(px, py, 0.010f, 9, 1.9f, 0.55f, m2);
+      e[1] = planar[64 * 64 + y * 64 + x] - noise_perlin_2_fbm(px + 1000.0f, py - 300.0f, 0.020f, 4, 2.0f, 0.5f);
+      e[2] = planar[2 * 64 * 64 + y * 64 + x] - noise_value_2_fbm(px - 512.0f, py - 300.0f, 0.020f, 4, 2.0f, 0.5f);
+
+      for (c = 0; c < 3; ++c)
+      {
+        float a = e[c] < 0.0f ? -e[c] : e[c];
+        max_error = a > max_error ? a : max_error;
+        mismatches += interleaved[(y * 64 + x) * 3 + c] != planar[c * 64 * 64 + y * 64 + x];
+      }
+    }
+  }
+
+  assert(mismatches == 0);
+  assert(max_error < 1e-3f);
+
+  /* more channels than supported fail instead of changing the interleaved stride */
+  assert(noise_channels_2(channels, NOISE_CHANNELS_MAX + 1, planar, 1, 1, 0.0f, 0.0f, 1.0f, 1) == 0);
+  assert(noise_channels_2(channels, 0, planar, 1, 1, 0.0f, 0.0f, 1.0f, 1) == 0);
+
+  /* a channel with more octaves than a plan holds fails the whole call */
+  channels[1].octaves = NOISE_FBM_PLAN_MAX_OCTAVES + 1;
+  assert(noise_channels_2(channels, 3, planar, 64, 64, 10.0f, 20.0f, 1.0f, 0) == 0);
+  assert(noise_simplex_2_fbm_tile(planar, 64, 64, 0.0f, 0.0f, 1.0f, 0.01f, NOISE_FBM_PLAN_MAX_OCTAVES + 1, 2.0f, 0.5f, 0) == 0);
+}
+
+void noise_test_curl(void)
+{
+  static float px[1000], py[1000], pz[1000];
+  float h = 0.01f;
+  int i, outliers = 0;
+
+  noise_seed(1337);
+
+  for (i = 0; i < 200; ++i)
+  {
+    float x = (float)(i % 17) * 3.7f - 20.0f;
+    float y = (float)(i % 23) * 2.3f;
+    float z = (float)(i % 7) * 5.1f - 9.0f;
+    float g2[2], g3[3], a[3], b[3], e[4], div;
+    int k;
+
+    /* analytic gradients against central differences */
+    e[0] = noise_simplex_2_derivative(x, y, 0.1f, g2) - noise_simplex_2(x, y, 0.1f);
+    e[1] = g2[0] - (noise_simplex_2(x + h, y, 0.1f) - noise_simplex_2(x - h, y, 0.1f)) / (2.0f * h);
+    e[2] = noise_simplex_3_derivative(x, y, z, 0.1f, g3) - noise_simplex_3(x, y, z, 0.1f);
+    e[3] = g3[2] - (noise_simplex_3(x, y, z + h, 0.1f) - noise_simplex_3(x, y, z - h, 0.1f)) / (2.0f * h);
+
+    for (k = 0; k < 4; ++k)
+    {
+      outliers += (e[k] < 0.0f ? -e[k] : e[k]) > 1e-2f;
+    }
+
+    /* the curl field is divergence free */
+    noise_curl_3(x + h, y, z, 0.1f, a);
+    noise_curl_3(x - h, y, z, 0.1f, b);
+    div = a[0] - b[0];
+    noise_curl_3(x, y + h, z, 0.1f, a);
+    noise_curl_3(x, y - h, z, 0.1f, b);
+    div += a[1] - b[1];
+    noise_curl_3(x, y, z + h, 0.1f, a);
+    noise_curl_3(x, y, z - h, 0.1f, b);
+    div += a[2] - b[2];
+    div /= 2.0f * h;
+    outliers += (div < 0.0f ? -div : div) > 1e-2f;
+  }
+
+  /* the 0.6 falloff radius of 3D simplex noise leaves tiny jumps on some simplex faces
+   * which central differences straddle for a handful of samples
+   */
+  assert(outliers < 5);
+
+  /* one advection step moves every particle by dt * strength * curl at its position */
+  outliers = 0;
+
+  for (i = 0; i < 1000; ++i)
+  {
+    px[i] = (float)(i % 40) * 12.0f + 0.37f;
+    py[i] = (float)(i / 40) * 12.0f + 0.71f;
+    pz[i] = 0.0f;
+  }
+
+  noise_advect_particles(px, py, 0, 1000, 0.01f, 100.0f, 0.016f, 0.5f);
+
+  for (i = 0; i < 1000; ++i)
+  {
+    float x = (float)(i % 40) * 12.0f + 0.37f, y = (float)(i / 40) * 12.0f + 0.71f;
+
+    /* 2D particles follow the curl of the simplex slice at z = time */
+    float vx = (noise_simplex_3(x, y + h, 0.5f, 0.01f) - noise_simplex_3(x, y - h, 0.5f, 0.01f)) / (2.0f * h);
+    float vy = -(noise_simplex_3(x + h, y, 0.5f, 0.01f) - noise_simplex_3(x - h, y, 0.5f, 0.01f)) / (2.0f * h);
+    float ex = px[i] - (x + 1.6f * vx), ey = py[i] - (y + 1.6f * vy);
+
+    outliers += (ex < 0.0f ? -ex : ex) > 1e-3f || (ey < 0.0f ? -ey : ey) > 1e-3f;
+  }
+
+  assert(outliers < 5);
+  outliers = 0;
+
+  for (i = 0; i < 1000; ++i)
+  {
+    px[i] = (float)(i % 40) * 12.0f;
+    py[i] = (float)(i / 40) * 12.0f;
+    pz[i] = (float)(i % 7) * 5.0f;
+  }
+
+  noise_advect_particles(px, py, pz, 1000, 0.01f, 100.0f, 0.016f, 0.5f);
+
+  for (i = 0; i < 1000; ++i)
+  {
+    float x = (float)(i % 40) * 12.0f, y = (float)(i / 40) * 12.0f, z = (float)(i % 7) * 5.0f;
+    float v[3], ex, ey, ez;
+
+    noise_curl_3(x, y, z + 0.5f, 0.01f, v);
+    ex = px[i] - (x + 1.6f * v[0]);
+    ey = py[i] - (y + 1.6f * v[1]);
+    ez = pz[i] - (z + 1.6f * v[2]);
+    outliers += (ex < 0.0f ? -ex : ex) > 1e-4f || (ey < 0.0f ? -ey : ey) > 1e-4f || (ez < 0.0f ? -ez : ez) > 1e-4f;
+  }
+
+  assert(outliers == 0);
+}
+
+void noise_test_heightmap_derive(void)
+{
+  static float plane[64 * 64], normal[64 * 64 * 3], slope[64 * 64], curvature[64 * 64], slope_bands[64 * 64];
+  static unsigned char flow[64 * 64];
+  noise_heightmap_attributes attributes = {0};
+  noise_heightmap_attributes bands = {0};
+  int x, y, i, mismatches = 0;
+
+  /* tilted plane falling towards -x */
+  for (y = 0; y < 64; ++y)
+  {
+    for (x = 0; x < 64; ++x)
+    {
+      plane[y * 64 + x] = 0.5f * (float)x;
+    }
+  }
+
+  attributes.normal = normal;
+  attributes.slope = slope;
+  attributes.curvature = curvature;
+  attributes.flow = flow;
+  noise_heightmap_derive(plane, 64, 64, 1.0f, 0, 64, &attributes);
+
+  i = 32 * 64 + 32;
+  assert_equalsf(slope[i], 0.5f, 1e-5f);
+  assert_equalsf(curvature[i], 0.0f, 1e-5f);
+  assert_equalsf(normal[i * 3 + 0], -0.5f / 1.118034f, 1e-4f);
+  assert_equalsf(normal[i * 3 + 2], 1.0f / 1.118034f, 1e-4f);
+  assert(flow[i] == 3);
+
+  /* row bands give the same result as one full sweep */
+  noise_seed(1337);
+  noise_simplex_2_fbm_tile(heightmap, WIDTH, HEIGHT, 0.0f, 0.0f, 1.0f, 0.010f, 4, 2.0f, 0.5f, 0);
+  attributes.normal = 0;
+  attributes.curvature = 0;
+  attributes.flow = 0;
+  bands.slope = slope_bands;
+  noise_heightmap_derive(heightmap, 64, 64, 10.0f, 0, 64, &attributes);
+  noise_heightmap_derive(heightmap, 64, 64, 10.0f, 0, 20, &bands);
+  noise_heightmap_derive(heightmap, 64, 64, 10.0f, 20, 64, &bands);
+
+  for (i = 0; i < 64 * 64; ++i)
+  {
+    mismatches += slope[i] != slope_bands[i];
+  }
+
+  assert(mismatches == 0);
+}
+
+void noise_test_quantize(void)
+{
+  static float reference[128 * 128];
+  static unsigned short u16[128 * 128], half[128 * 128];
+  static unsigned char u8[128 * 128];
+  noise_channel channel;
+  noise_stats stats, stats_float;
+  float max_error = 0.0f;
+  int i, lowest = 255, highest = 0;
+
+  noise_seed(1337);
+
+  channel.type = NOISE_TYPE_SIMPLEX;
+  channel.frequency = 0.02f;
+  channel.octaves = 5;
+  channel.lacunarity = 2.0f;
+  channel.gain = 0.5f;
+  channel.offset_x = 0.0f;
+  channel.offset_y = 0.0f;
+  channel.rotation = 0;
+
+  noise_channels_2(&channel, 1, reference, 128, 128, 0.0f, 0.0f, 1.0f, 0);
+
+  /* half floats round trip within half precision */
+  assert(noise_half_to_float(noise_float_to_half(1.0f)) == 1.0f);
+  assert(noise_half_to_float(noise_float_to_half(-0.5f)) == -0.5f);
+  assert(noise_float_to_half(65536.0f * 2.0f) == 0x7c00);
+  noise_channel_2_half(&channel, half, 128, 128, 0.0f, 0.0f, 1.0f, 0);
+
+  for (i = 0; i < 128 * 128; ++i)
+  {
+    float e = noise_half_to_float(half[i]) - reference[i];
+    e = e < 0.0f ? -e : e;
+    max_error = e > max_error ? e : max_error;
+  }
+
+  assert(max_error < 1e-3f);
+
+  /* fixed range and stats gathered during generation */
+  noise_channel_2_u16(&channel, u16, 128, 128, 0.0f, 0.0f, 1.0f, -1.0f, 1.0f, &stats);
+  noise_quantize_u16(reference, 128 * 128, -1.0f, 1.0f, u16, &stats_float);
+  assert(stats.min == stats_float.min && stats.max == stats_float.max);
+  assert_equalsf(stats.mean, stats_float.mean, 1e-4f);
+  test(stats.min >= -1.0f && stats.max <= 1.0f && stats.min < stats.max);
+
+  /* auto range stretches onto the full 8-bit range */
+  noise_channel_2_u8(&channel, u8, 128, 128, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0);
+
+  for (i = 0; i < 128 * 128; ++i)
+  {
+    lowest = u8[i] < lowest ? u8[i] : lowest;
+    highest = u8[i] > highest ? u8[i] : highest;
+  }
+
+  assert(lowest == 0 && highest == 255);
+
+  /* the generated auto range matches quantizing the float buffer */
+  noise_quantize_u8(reference, 128 * 128, 0.0f, 0.0f, (unsigned char *)half, &stats_float);
+  assert(memcmp(u8, half, sizeof(u8)) == 0);
+
+  /* auto range works in the data's own units: heightmaps far outside [-1, 1] */
+  for (i = 0; i < 1000; ++i)
+  {
+    reference[i] = 100.0f + (float)((i * 7) % 1000);
+  }
+
+  noise_quantize_u16(reference, 1000, 0.0f, 0.0f, u16, &stats);
+  assert(stats.min == 100.0f && stats.max == 1099.0f);
+
+  for (i = 0, highest = 0; i < 1000; ++i)
+  {
+    lowest = (int)(((reference[i] - 100.0f) * 65535.0f) / 999.0f + 0.5f);
+    lowest = u16[i] > lowest ? u16[i] - lowest : lowest - u16[i];
+    highest = lowest > highest ? lowest : highest;
+  }
+
+  assert(highest <= 1);
+
+  /* and a narrow range still uses every 8-bit level */
+  for (i = 0; i < 1000; ++i)
+  {
+    reference[i] = -0.25f + 0.5f * (float)i / 999.0f;
+  }
+
+  noise_quantize_u8(reference, 1000, 0.0f, 0.0f, u8, 0);
+  memset(half, 0, 256 * sizeof(half[0]));
+
+  for (i = 0; i < 1000; ++i)
+  {
+    half[u8[i]] = 1;
+  }
+
+  for (i = 0, highest = 0; i < 256; ++i)
+  {
+    highest += half[i];
+  }
+
+  assert(highest == 256);
+}
+
+static int noise_test_file_write(void *user, void *data, int size)
+{
+  return fwrite(data, 1, (size_t)size, (FILE *)user) == (size_t)size;
+}
+
+void noise_test_stream(void)
+{
+  static float band[16 * WIDTH];
+  static unsigned char band_bytes[64];
+  noise_stream stream;
+  unsigned char *mapped, *file_data;
+  size_t size = (size_t)noise_stream_size(NOISE_STREAM_PGM16, WIDTH, HEIGHT);
+  FILE *f;
+  int y, ok = 1;
+
+  noise_seed(1337);
+
+  /* sizes past 4 GiB stay exact: 65536^2 floats plus the header */
+  assert(noise_stream_size(NOISE_STREAM_PFM, 65536, 65536) == 17179869184.0 + (double)noise_stream_header(NOISE_STREAM_PFM, 65536, 65536, 0));
+  assert(noise_stream_row_pointer(band_bytes, 3, 5, 7) == band_bytes + 3 + 35);
+
+  f = fopen("simplex_2_fbm_stream.pgm", "wb");
+  mapped = (unsigned char *)malloc(size);
+  file_data = (unsigned char *)malloc(size);
+  assert(f != 0 && mapped != 0 && file_data != 0);
+
+  /* only one band of 16 rows is ever held in memory */
+  ok &= noise_stream_begin(&stream, NOISE_STREAM_PGM16, WIDTH, HEIGHT, -1.0f, 1.0f, noise_test_file_write, f);
+  noise_stream_header(NOISE_STREAM_PGM16, WIDTH, HEIGHT, mapped);
+
+  for (y = 0; y < HEIGHT; y += 16)
+  {
+    noise_simplex_2_fbm_tile(band, WIDTH, 16, 0.0f, (float)y, 1.0f, 0.010f, 4, 2.0f, 0.5f, 0);
+    ok &= noise_stream_rows(&stream, band, 16);
+    noise_stream_encode_rows(NOISE_STREAM_PGM16, WIDTH, HEIGHT, -1.0f, 1.0f, band, y, 16, mapped);
+  }
+
+  fclose(f);
+  assert(ok && stream.rows_written == HEIGHT);
+
+  /* stream and mapped mode produce the same file */
+  f = fopen("simplex_2_fbm_stream.pgm", "rb");
+  assert(f != 0);
+  assert(fread(file_data, 1, size, f) == size);
+  fclose(f);
+  assert(memcmp(file_data, mapped, size) == 0);
+
+  /* too many rows are rejected */
+  assert(!noise_stream_rows(&stream, band, 1));
+
+  free(mapped);
+  free(file_data);
+
+  printf("[noise] simplex_2_fbm_stream.pgm exported.\n");
+}
+
+/* open loads, every one must come back through the release callback */
+static int noise_test_tile_open;
+
+static void *noise_test_tile_load(void *user, char *name, long *size)
+{
+  char path[64];
+  void *data;
+  FILE *f;
+
+  (void)user;
+  sprintf(path, "tile_cache_%s.bin", name);
+  f = fopen(path, "rb");
+
+  if (!f)
+  {
+    return 0;
+  }
+
+  fseek(f, 0, SEEK_END);
+  *size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+
+  /* a real cache would memory-map the file instead */
+  data = malloc((size_t)*size);
+
+  if (data && fread(data, 1, (size_t)*size, f) != (size_t)*size)
+  {
+    *size = 0;
+  }
+
+  fclose(f);
+  noise_test_tile_open += data != 0;
+
+  return data;
+}
+
+static void noise_test_tile_release(void *user, void *data, long size)
+{
+  (void)user;
+  (void)size;
+  noise_test_tile_open--;
+  free(data);
+}
+
+static int noise_test_tile_save(void *user, char *name, void *data, long size)
+{
+  char path[64];
+  FILE *f;
+  int ok;
+
+  (void)user;
+  sprintf(path, "tile_cache_%s.bin", name);
+  f = fopen(path, "wb");
+
+  if (!f)
+  {
+    return 0;
+  }
+
+  ok = fwrite(data, 1, (size_t)size, f) == (size_t)size;
+  fclose(f);
+
+  return ok;
+}
+
+void noise_test_tile_cache(void)
+{
+  static float scratch[(sizeof(noise_tile_header) + 64 * 64 * sizeof(float)) / sizeof(float)];
+  static float generated[64 * 64];
+  noise_tile_store store;
+  noise_channel channel;
+  noise_tile_key a, b;
+  char name[17], path[64];
+  float *tile;
+  FILE *f;
+  int hit;
+
+  noise_seed(1337);
+
+  store.load = noise_test_tile_load;
+  store.save = noise_test_tile_save;
+  store.release = noise_test_tile_release;
+  store.user = 0;
+
+  channel.type = NOISE_TYPE_PERLIN;
+  channel.frequency = 0.01f;
+  channel.octaves = 6;
+  channel.lacunarity = 2.0f;
+  channel.gain = 0.5f;
+  channel.offset_x = 0.0f;
+  channel.offset_y = 0.0f;
+  channel.rotation = 0;
+
+  /* make sure a stale file from an earlier run does not count as the first hit */
+  noise_tile_key_name(noise_tile_key_compute(&channel, 3, -2, 64, 1.0f), name);
+  sprintf(path, "tile_cache_%s.bin", name);
+  remove(path);
+
+  tile = noise_tile_cache_get(&store, &channel, 3, -2, 64, 1.0f, scratch, &hit);
+  assert(!hit);
+  memcpy(generated, tile, sizeof(generated));
+  noise_tile_cache_release(&store, tile, 64, scratch);
+
+  tile = noise_tile_cache_get(&store, &channel, 3, -2, 64, 1.0f, scratch, &hit);
+  assert(hit);
+  assert(memcmp(generated, tile, sizeof(generated)) == 0);
+  noise_tile_cache_release(&store, tile, 64, scratch);
+  assert(noise_test_tile_open == 0);
+
+  /* a corrupt file is released, regenerated and rewritten */
+  f = fopen(path, "wb");
+  assert(f != 0 && fwrite("corrupt", 1, 7, f) == 7);
+  fclose(f);
+  tile = noise_tile_cache_get(&store, &channel, 3, -2, 64, 1.0f, scratch, &hit);
+  assert(!hit && memcmp(generated, tile, sizeof(generated)) == 0);
+  noise_tile_cache_release(&store, tile, 64, scratch);
+  assert(noise_test_tile_open == 0);
+  remove(path);
+
+  /* an invalid channel generates nothing and saves nothing */
+  channel.octaves = 20;
+  noise_tile_key_name(noise_tile_key_compute(&channel, 3, -2, 64, 1.0f), name);
+  sprintf(path, "tile_cache_%s.bin", name);
+  remove(path);
+  hit = 1;
+  assert(noise_tile_cache_get(&store, &channel, 3, -2, 64, 1.0f, scratch, &hit) == 0);
+  assert(!hit);
+  f = fopen(path, "rb");
+  assert(f == 0);
+  channel.octaves = 6;
+
+  /* any parameter change gives a different key */
+  a = noise_tile_key_compute(&channel, 3, -2, 64, 1.0f);
+  channel.gain = 0.55f;
+  b = noise_tile_key_compute(&channel, 3, -2, 64, 1.0f);
+  assert(a.hash[0] != b.hash[0] || a.hash[1] != b.hash[1]);
+
+  noise_seed(42);
+  channel.gain = 0.5f;
+  b = noise_tile_key_compute(&channel, 3, -2, 64, 1.0f);
+  assert(a.hash[0] != b.hash[0] || a.hash[1] != b.hash[1]);
+}
+
+static int noise_test_lock_depth;
+static int noise_test_lock_errors;
+
+static void noise_test_lock(void *user)
+{
+  (void)user;
+  noise_test_lock_errors += noise_test_lock_depth != 0; /* never locked recursively */
+  noise_test_lock_depth++;
+}
+
+static void noise_test_unlock(void *user)
+{
+  (void)user;
+  noise_test_lock_depth--;
+}
+
+/* stands in for a condition variable: the generating thread finishes while we wait */
+static noise_tile_lru_entry *noise_test_lru_pending;
+static noise_tile_lru_state noise_test_lru_outcome;
+static int noise_test_lru_waits;
+static int noise_test_lru_wakes;
+
+static void noise_test_lru_wait(void *user)
+{
+  (void)user;
+  noise_test_lock_errors += noise_test_lock_depth != 1; /* called with the lock held */
+  noise_test_lru_waits++;
+  noise_test_lru_pending->state = noise_test_lru_outcome;
+}
+
+static void noise_test_lru_wake(void *user)
+{
+  (void)user;
+  noise_test_lock_errors += noise_test_lock_depth != 1;
+  noise_test_lru_wakes++;
+}
+
+void noise_test_tile_lru(void)
+{
+  static double memory[2 * (32 * 32 + 16)]; /* double for pointer alignment of the entries */
+  noise_tile_lru cache;
+  noise_channel channel;
+  float *tiles[5];
+  float exact, cached;
+  int i;
+
+  noise_seed(1337);
+
+  channel.type = NOISE_TYPE_SIMPLEX;
+  channel.frequency = 0.01f;
+  channel.octaves = 4;
+  channel.lacunarity = 2.0f;
+  channel.gain = 0.5f;
+  channel.offset_x = 0.0f;
+  channel.offset_y = 0.0f;
+  channel.rotation = 0;
+
+  /* a budget of exactly four 32x32 tiles */
+  assert(noise_tile_lru_init(&cache, 32, 1.0f, memory, 4 * noise_tile_lru_entry_size(32)) == 4);
+  cache.lock = noise_test_lock;
+  cache.unlock = noise_test_unlock;
+
+  for (i = 0; i < 4; ++i)
+  {
+    tiles[i] = noise_tile_lru_acquire(&cache, &channel, i, 0);
+  }
+
+  /* everything is pinned */
+  assert(noise_tile_lru_acquire(&cache, &channel, 4, 0) == 0);
+
+  for (i = 0; i < 4; ++i)
+  {
+    noise_tile_lru_release(&cache, tiles[i]);
+  }
+
+  tiles[0] = noise_tile_lru_acquire(&cache, &channel, 0, 0);
+  noise_tile_lru_release(&cache, tiles[0]);
+  tiles[4] = noise_tile_lru_acquire(&cache, &channel, 4, 0);
+  noise_tile_lru_release(&cache, tiles[4]);
+
+  assert(cache.hits == 1 && cache.misses == 5 && cache.evictions == 1);
+  assert(noise_test_lock_depth == 0 && noise_test_lock_errors == 0);
+
+  /* a tile still loading in another thread is waited for through the callback */
+  cache.wait = noise_test_lru_wait;
+  cache.wake = noise_test_lru_wake;
+  noise_test_lru_pending = (noise_tile_lru_entry *)0;
+
+  for (i = 0; i < cache.capacity; ++i)
+  {
+    if (cache.entries[i].data == tiles[4])
+    {
+      noise_test_lru_pending = &cache.entries[i];
+    }
+  }
+
+  assert(noise_test_lru_pending != 0);
+  noise_test_lru_outcome = NOISE_TILE_LRU_READY;
+  noise_test_lru_pending->state = NOISE_TILE_LRU_LOADING;
+  assert(noise_tile_lru_acquire(&cache, &channel, 4, 0) == tiles[4]);
+  noise_tile_lru_release(&cache, tiles[4]);
+  assert(noise_test_lru_waits == 1 && noise_test_lru_wakes == 0);
+
+  /* finishing a generation wakes the waiters */
+  tiles[3] = noise_tile_lru_acquire(&cache, &channel, 9, 9);
+  noise_tile_lru_release(&cache, tiles[3]);
+  assert(noise_test_lru_wakes == 1);
+  assert(noise_test_lock_depth == 0 && noise_test_lock_errors == 0);
+
+  /* a generation that fails empties the slot, wakes the waiters and is never served */
+  channel.octaves = 20;
+  assert(noise_tile_lru_acquire(&cache, &channel, 7, 7) == 0);
+  assert(noise_test_lru_wakes == 2);
+  assert(noise_tile_lru_sample(&cache, &channel, 7.0f * 32.0f + 1.5f, 7.0f * 32.0f + 1.5f, 1, &cached) == -1);
+  channel.octaves = 4;
+
+  for (i = 0; i < cache.capacity; ++i)
+  {
+    assert(cache.entries[i].pins == 0);
+  }
+
+  /* a waiter whose tile failed in the other thread gives up and drops its pin */
+  noise_test_lru_outcome = NOISE_TILE_LRU_EMPTY;
+  noise_test_lru_pending->state = NOISE_TILE_LRU_LOADING;
+  assert(noise_tile_lru_acquire(&cache, &channel, 4, 0) == 0);
+  assert(noise_test_lru_waits == 2 && noise_test_lru_pending->pins == 0);
+  assert(noise_test_lock_depth == 0 && noise_test_lock_errors == 0);
+
+  /* point queries interpolate from a cached tile */
+  tiles[0] = noise_tile_lru_acquire(&cache, &channel, 0, 0);
+  assert(noise_tile_lru_sample(&cache, &channel, 10.5f, 7.25f, 1, &cached) == 1);
+  assert(noise_tile_lru_sample(&cache, &channel, 10.5f, 7.25f, 0, &exact) == 0);
+  assert_equalsf(cached, exact, 1e-2f);
+  assert_equalsf(tiles[0][7 * 32 + 10], noise_simplex_2_fbm(10.0f, 7.0f, 0.01f, 4, 2.0f, 0.5f), 1e-4f);
+  noise_tile_lru_release(&cache, tiles[0]);
+}
+
+void noise_test_compress(void)
+{
+  static float tile[64 * 64];
+  static float row[64];
+  long bound = noise_compress_bound(WIDTH, HEIGHT, 64);
+  unsigned char *packed = (unsigned char *)malloc((size_t)bound);
+  noise_decoder decoder;
+  long size;
+  int predictor, width, height, tile_size, x, y, errors;
+
+  assert(packed != 0);
+
+  noise_seed(1337);
+
+  for (y = 0; y < HEIGHT; ++y)
+  {
+    for (x = 0; x < WIDTH; ++x)
+    {
+      heightmap[y * WIDTH + x] = noise_simplex_2_fbm((float)x, (float)y, 0.01f, 4, 2.0f, 0.5f);
+    }
+  }
+
+  for (predictor = NOISE_PREDICT_PAETH; predictor <= NOISE_PREDICT_LINEAR; ++predictor)
+  {
+    size = noise_compress(heightmap, WIDTH, HEIGHT, 64, predictor, packed, bound);
+
+    /* at least 3x (linear) or 2.5x (Paeth) smaller than the raw float layer */
+    assert(size > 0);
+    assert(size * (predictor == NOISE_PREDICT_LINEAR ? 6 : 5) <= (long)(WIDTH * HEIGHT * sizeof(float)) * 2);
+    assert(noise_compress_info(packed, size, &width, &height, &tile_size) == 1);
+    assert(width == WIDTH && height == HEIGHT && tile_size == 64);
+
+    /* random tile access within the 16 bit quantization error */
+    errors = 0;
+    assert(noise_decompress_tile(packed, size, 5, 3, tile) == 1);
+
+    for (y = 0; y < 64; ++y)
+    {
+      for (x = 0; x < 64; ++x)
+      {
+        float d = tile[y * 64 + x] - heightmap[(3 * 64 + y) * WIDTH + 5 * 64 + x];
+        errors += (d > 1e-4f || d < -1e-4f);
+      }
+    }
+
+    assert(errors == 0);
+  }
+
+  /* streaming row decode of a clipped edge tile */
+  size = noise_compress(heightmap, WIDTH, 100, 64, NOISE_PREDICT_PAETH, packed, bound);
+  assert(size > 0);
+  assert(noise_decoder_begin(&decoder, packed, size, 7, 1) == 1);
+  assert(decoder.width == 64 && decoder.height == 36);
+
+  errors = 0;
+  y = 0;
+
+  while (noise_decoder_row(&decoder, row))
+  {
+    for (x = 0; x < 64; ++x)
+    {
+      float d = row[x] - heightmap[(64 + y) * WIDTH + 7 * 64 + x];
+      errors += (d > 1e-4f || d < -1e-4f);
+    }
+
+    ++y;
+  }
+
+  assert(y == 36 && errors == 0);
+  assert(noise_decoder_begin(&decoder, packed, size, 8, 0) == 0);
+
+  /* truncated or corrupted headers are rejected */
+  assert(noise_decoder_begin(&decoder, packed, size - 1, 7, 1) == 0); /* last tile runs past the end */
+  assert(noise_compress_info(packed, NOISE_COMPRESS_HEADER - 1, &width, &height, &tile_size) == 0);
+  assert(noise_compress_info(packed, NOISE_COMPRESS_HEADER + 4, &width, &height, &tile_size) == 0); /* no offset table */
+
+  packed[12] = 0; /* tile size 0 */
+  assert(noise_compress_info(packed, size, &width, &height, &tile_size) == 0);
+  packed[12] = 0x01;
+  packed[13] = 0x01; /* tile size 257 */
+  assert(noise_compress_info(packed, size, &width, &height, &tile_size) == 0);
+  packed[12] = 64;
+  packed[13] = 0;
+  packed[16] = 7; /* unknown predictor */
+  assert(noise_compress_info(packed, size, &width, &height, &tile_size) == 0);
+  packed[16] = NOISE_PREDICT_PAETH;
+  assert(noise_compress_info(packed, size, &width, &height, &tile_size) == 1);
+  packed[NOISE_COMPRESS_HEADER + 3] = 0xff; /* first tile offset far past the end */
+  assert(noise_decoder_begin(&decoder, packed, size, 0, 0) == 0);
+  packed[NOISE_COMPRESS_HEADER + 3] = 0;
+  packed[NOISE_COMPRESS_HEADER] = 0; /* first tile offset inside the offset table */
+  assert(noise_decoder_begin(&decoder, packed, size, 0, 0) == 0);
+  assert(noise_compress(heightmap, WIDTH, HEIGHT, 64, 7, packed, bound) == 0);
+
+  /* too small a buffer fails instead of overrunning */
+  assert(noise_compress(heightmap, WIDTH, HEIGHT, 64, NOISE_PREDICT_PAETH, packed, 1024) == 0);
+
+  free(packed);
+}
+
+void noise_test_tileable(void)
+{
+  static float texture[256 * 256];
+  float bilinear = 0.0f, bicubic = 0.0f;
+  int i, x, y, type, seams = 0;
+
+  noise_seed(1337);
+
+  /* the periodic lattices repeat exactly */
+  assert_equalsf(noise_perlin_2_periodic(1.3f, 2.7f, 4, 6), noise_perlin_2_periodic(5.3f, -3.3f, 4, 6), 1e-5f);
+  assert_equalsf(noise_value_2_periodic(1.3f, 2.7f, 4, 6), noise_value_2_periodic(-2.7f, 8.7f, 4, 6), 1e-5f);
+
+  /* periods above 256 cells repeat at the period, not at the 256 entry table */
+  for (i = 0, seams = 0; i < 256; ++i)
+  {
+    float x0 = (float)i + 0.375f, y0 = (float)(i * 7 % 300) + 0.625f; /* exact in float after the shifts */
+
+    seams += noise_perlin_2_periodic(x0, y0, 512, 300) == noise_perlin_2_periodic(x0 + 256.0f, y0, 512, 300);
+    seams += noise_perlin_2_periodic(x0, y0, 512, 300) != noise_perlin_2_periodic(x0 + 512.0f, y0 - 300.0f, 512, 300);
+    seams += noise_value_2_periodic(x0, y0, 400, 300) == noise_value_2_periodic(x0 + 317.0f, y0 - 1.0f, 400, 300);
+    seams += noise_value_2_periodic(x0, y0, 400, 300) != noise_value_2_periodic(x0 - 400.0f, y0 + 300.0f, 400, 300);
+  }
+
+  assert(seams < 4);
+  seams = 0;
+
+  /* baked textures wrap seamlessly: texel 0 equals the exact value one period further */
+  for (type = NOISE_TYPE_PERLIN; type <= NOISE_TYPE_VALUE; ++type)
+  {
+    noise_tileable_2_bake(texture, 256, 256, (noise_type)type, 8, 3, 2.0f, 0.5f);
+
+    for (i = 0; i < 256; i += 17)
+    {
+      float dx = texture[i * 256] - noise_tileable_2_fbm((noise_type)type, 256.0f, (float)i, 256, 256, 8, 3, 2.0f, 0.5f);
+      float dy = texture[i] - noise_tileable_2_fbm((noise_type)type, (float)i, 256.0f, 256, 256, 8, 3, 2.0f, 0.5f);
+      seams += (dx > 1e-4f || dx < -1e-4f || dy > 1e-4f || dy < -1e-4f);
+    }
+  }
+
+  assert(seams == 0);
+
+  /* 8 texels per finest Perlin cell: documented sampling error bounds */
+  noise_tileable_2_bake(texture, 256, 256, NOISE_TYPE_PERLIN, 8, 3, 2.0f, 0.5f);
+
+  for (i = 0; i < 4096; ++i)
+  {
+    float u = (float)(noise_lcg_next() % 51200u) * 0.01f - 256.0f;
+    float v = (float)(noise_lcg_next() % 51200u) * 0.01f - 256.0f;
+    float exact = noise_tileable_2_fbm(NOISE_TYPE_PERLIN, u, v, 256, 256, 8, 3, 2.0f, 0.5f);
+    float e1 = noise_texture_bilinear(texture, 256, 256, u, v) - exact;
+    float e3 = noise_texture_bicubic(texture, 256, 256, u, v) - exact;
+
+    e1 = e1 < 0.0f ? -e1 : e1;
+    e3 = e3 < 0.0f ? -e3 : e3;
+    bilinear = e1 > bilinear ? e1 : bilinear;
+    bicubic = e3 > bicubic ? e3 : bicubic;
+  }
+
+  assert(bilinear < 5e-3f);
+  assert(bicubic < 1e-3f);
+
+  /* 2x2 repeat of a seamless simplex texture */
+  noise_tileable_2_bake(texture, 256, 256, NOISE_TYPE_SIMPLEX, 8, 4, 2.0f, 0.5f);
+
+  for (y = 0; y < HEIGHT; ++y)
+  {
+    for (x = 0; x < WIDTH; ++x)
+    {
+      heightmap[y * WIDTH + x] = texture[(y & 255) * 256 + (x & 255)];
+    }
+  }
+
+  noise_normalize_heightmap();
+  noise_export_ppm("simplex_2_fbm_tileable.ppm", heightmap, WIDTH, HEIGHT);
+}
+
+void noise_test_spectral(void)
+{
+  static float scratch[512 * 512 + 2 * 512];
+  static float rough[64 * 64];
+  float re[16], im[16], dft_re[16], dft_im[16];
+  float inner = 0.0f, seam = 0.0f, smooth = 0.0f, coarse = 0.0f;
+  int i, k, x, y, errors = 0;
+
+  /* nostdlib math helpers */
+  assert_equalsf(noise_sin(NOISE_PI / 6.0f), 0.5f, 1e-6f);
+  assert_equalsf(noise_cos(-NOISE_PI / 3.0f), 0.5f, 1e-6f);
+  assert_equalsf(noise_sin(10.0f), -0.54402111f, 1e-5f);
+  assert_equalsf(noise_log2(8.0f), 3.0f, 1e-5f);
+  assert_equalsf(noise_exp2(-2.5f), 0.17677670f, 1e-6f);
+  assert_equalsf(noise_pow(2.0f, 0.5f), 1.41421356f, 1e-5f);
+
+  /* FFT against a naive DFT, then the inverse restores the input */
+  for (i = 0; i < 16; ++i)
+  {
+    re[i] = (float)(noise_lcg_next() % 1000u) * 0.001f - 0.5f;
+    im[i] = (float)(noise_lcg_next() % 1000u) * 0.001f - 0.5f;
+  }
+
+  for (k = 0; k < 16; ++k)
+  {
+    dft_re[k] = dft_im[k] = 0.0f;
+
+    for (i = 0; i < 16; ++i)
+    {
+      float a = -2.0f * NOISE_PI * (float)(i * k % 16) / 16.0f;
+      dft_re[k] += re[i] * noise_cos(a) - im[i] * noise_sin(a);
+      dft_im[k] += re[i] * noise_sin(a) + im[i] * noise_cos(a);
+    }
+  }
+
+  memcpy(scratch, re, sizeof(re));
+  memcpy(scratch + 16, im, sizeof(im));
+  noise_fft(scratch, scratch + 16, 16, 0);
+
+  for (k = 0; k < 16; ++k)
+  {
+    float dr = scratch[k] - dft_re[k], di = scratch[16 + k] - dft_im[k];
+    errors += (dr > 1e-4f || dr < -1e-4f || di > 1e-4f || di < -1e-4f);
+  }
+
+  noise_fft(scratch, scratch + 16, 16, 1);
+
+  for (k = 0; k < 16; ++k)
+  {
+    float dr = scratch[k] - re[k], di = scratch[16 + k] - im[k];
+    errors += (dr > 1e-5f || dr < -1e-5f || di > 1e-5f || di < -1e-5f);
+  }
+
+  assert(errors == 0);
+
+  /* only powers of two */
+  assert(noise_spectral_2(rough, scratch, 48, 64, 2.0f, 7) == 0);
+
+  /* a larger beta moves energy to low frequencies: smaller neighbour differences */
+  assert(noise_spectral_2(rough, scratch, 64, 64, 2.0f, 7) == 1);
+
+  for (i = 0; i < 64 * 63; ++i)
+  {
+    float d = rough[i + 64] - rough[i];
+    coarse += d < 0.0f ? -d : d;
+  }
+
+  assert(noise_spectral_2(heightmap, scratch, WIDTH, HEIGHT, 3.0f, 7) == 1);
+
+  for (y = 0; y < HEIGHT; ++y)
+  {
+    for (x = 0; x < WIDTH; ++x)
+    {
+      float h = heightmap[y * WIDTH + x];
+      errors += (h < -1.0f || h > 1.0f);
+    }
+
+    for (x = 0; x < WIDTH - 1; ++x)
+    {
+      float d = heightmap[y * WIDTH + x + 1] - heightmap[y * WIDTH + x];
+      inner += d < 0.0f ? -d : d;
+    }
+
+    /* across the wrap the step is no larger than an ordinary neighbour step */
+    seam += heightmap[y * WIDTH] > heightmap[y * WIDTH + WIDTH - 1] ? heightmap[y * WIDTH] - heightmap[y * WIDTH + WIDTH - 1] : heightmap[y * WIDTH + WIDTH - 1] - heightmap[y * WIDTH];
+  }
+
+  /* mean absolute neighbour steps */
+  smooth = inner / (float)(HEIGHT * (WIDTH - 1));
+  seam /= (float)HEIGHT;
+  coarse /= (float)(64 * 63);
+
+  assert(errors == 0);
+  assert(seam < 2.0f * smooth);
+  assert(smooth < coarse);
+
+  /* the same post-passes as the fBm heightmaps */
+  noise_erosion_thermal(heightmap, WIDTH, HEIGHT, 0.02f, 5);
+
+  noise_normalize_heightmap();
+  noise_export_ppm("spectral_2.ppm", heightmap, WIDTH, HEIGHT);
+}
+
+void noise_test_graph(void)
+{
+  static float xs[1000], ys[1000], zs[1000], out[1000];
+  static float scratch[(NOISE_GRAPH_MAX_NODES + 1) * NOISE_BATCH_BLOCK];
+  float m2[2][2] = {
+      {0.80f, -0.60f},
+      {0.60f, 0.80f}};
+  noise_graph graph;
+  noise_program program;
+  int x, y, px, py, e, cliffs, a, b, warp[2], i, errors = 0;
+
+  noise_seed(1337);
+
+  for (i = 0; i < 1000; ++i)
+  {
+    xs[i] = (float)(i % 40) * 50.0f;
+    ys[i] = (float)(i / 40) * 50.0f;
+    zs[i] = (float)(i % 7);
+  }
+
+  /* noise_value_2_terrain_stub as a graph */
+  noise_graph_init(&graph);
+  x = noise_graph_x(&graph);
+  y = noise_graph_y(&graph);
+  px = noise_graph_remap(&graph, x, 0.0f, 2000.0f, 1.0f, 2.0f);
+  py = noise_graph_remap(&graph, y, 0.0f, 2000.0f, -2.0f, -1.0f);
+  e = noise_graph_fbm_2(&graph, NOISE_TYPE_VALUE, px, py, 1.0f, 9, 1.9f, 0.55f, m2);
+  e = noise_graph_remap(&graph, e, 0.0f, 1.0f, 600.0f, 1200.0f);
+  cliffs = noise_graph_mul(&graph, noise_graph_smoothstep(&graph, e, 552.0f, 594.0f), noise_graph_const(&graph, 90.0f));
+  e = noise_graph_add(&graph, e, cliffs);
+
+  assert(noise_graph_compile(&graph, e, &program) == 1);
+  assert(noise_program_scratch_size(&program) <= (int)(sizeof(scratch) / sizeof(scratch[0])));
+  noise_program_run(&program, xs, ys, 0, out, 1000, scratch);
+
+  for (i = 0; i < 1000; ++i)
+  {
+    float d = out[i] - noise_value_2_terrain_stub((int)xs[i], (int)ys[i]);
+    errors += (d > 1e-2f || d < -1e-2f);
+  }
+
+  assert(errors == 0);
+
+  /* identical sub-expressions are shared and evaluated once */
+  a = noise_graph_fbm_2(&graph, NOISE_TYPE_SIMPLEX, x, y, 0.01f, 4, 2.0f, 0.5f, 0);
+  b = noise_graph_fbm_2(&graph, NOISE_TYPE_SIMPLEX, x, y, 0.01f, 4, 2.0f, 0.5f, 0);
+  assert(a == b);
+  assert(noise_graph_compile(&graph, noise_graph_mul(&graph, a, b), &program) == 1);
+  assert(program.count == 2); /* fbm and mul, the terrain nodes are dead */
+
+  /* warped 3D fBm minus a ridge mask; registers are recycled along the chain */
+  noise_graph_init(&graph);
+  x = noise_graph_x(&graph);
+  y = noise_graph_y(&graph);
+  noise_graph_warp_2(&graph, x, y, 0.01f, 3, 2.0f, 0.5f, 20.0f, warp);
+  e = noise_graph_fbm_3(&graph, NOISE_TYPE_PERLIN, warp[0], warp[1], noise_graph_z(&graph), 0.02f, 3, 2.0f, 0.5f, 0);
+  e = noise_graph_select(&graph, e, noise_graph_abs(&graph, e), noise_graph_noise_2(&graph, NOISE_TYPE_VALUE, x, y, 0.005f), 0.0f, 0.1f);
+
+  assert(noise_graph_compile(&graph, e, &program) == 1);
+  assert(program.registers - NOISE_GRAPH_INPUTS < program.count);
+  noise_program_run(&program, xs, ys, zs, out, 1000, scratch);
+
+  errors = 0;
+
+  for (i = 0; i < 1000; ++i)
+  {
+    float w[2], v, t, d;
+
+    noise_simplex_2_vec2_fbm(xs[i] + 5.2f, ys[i] + 1.3f, 0.01f, 3, 2.0f, 0.5f, w);
+    v = noise_perlin_3_fbm(xs[i] + 20.0f * w[0], ys[i] + 20.0f * w[1], zs[i], 0.02f, 3, 2.0f, 0.5f);
+    t = noise_smoothstep(-0.1f, 0.1f, noise_value_2(xs[i], ys[i], 0.005f));
+    d = out[i] - (v + t * ((v < 0.0f ? -v : v) - v));
+    errors += (d > 1e-4f || d < -1e-4f);
+  }
+
+  assert(errors == 0);
+
+  /* warp into simplex fBm is noise_simplex_2_domain_warp_fbm */
+  noise_graph_init(&graph);
+  noise_graph_warp_2(&graph, noise_graph_x(&graph), noise_graph_y(&graph), 0.01f, 4, 2.0f, 0.5f, 30.0f, warp);
+  e = noise_graph_fbm_2(&graph, NOISE_TYPE_SIMPLEX, warp[0], warp[1], 0.01f, 4, 2.0f, 0.5f, 0);
+
+  assert(noise_graph_compile(&graph, e, &program) == 1);
+  noise_program_run(&program, xs, ys, 0, out, 1000, scratch);
+
+  errors = 0;
+
+  for (i = 0; i < 1000; ++i)
+  {
+    float d = out[i] - noise_simplex_2_domain_warp_fbm(xs[i], ys[i], 0.01f, 4, 2.0f, 0.5f, 30.0f);
+    errors += (d > 1e-5f || d < -1e-5f);
+  }
+
+  assert(errors == 0);
+
+  /* only the x component consumed: the y output still gets a register, then frees it */
+  noise_graph_init(&graph);
+  noise_graph_vec2_fbm_2(&graph, noise_graph_x(&graph), noise_graph_y(&graph), 0.02f, 2, 2.0f, 0.5f, m2, warp);
+  e = noise_graph_abs(&graph, warp[0]);
+
+  assert(noise_graph_compile(&graph, e, &program) == 1);
+  assert(program.count == 2 && program.registers == NOISE_GRAPH_INPUTS + 2);
+  noise_program_run(&program, xs, ys, 0, out, 1000, scratch);
+
+  errors = 0;
+
+  for (i = 0; i < 1000; ++i)
+  {
+    float w[2], d;
+
+    noise_simplex_2_vec2_fbm_rotation(xs[i], ys[i], 0.02f, 2, 2.0f, 0.5f, m2, w);
+    d = out[i] - (w[0] < 0.0f ? -w[0] : w[0]);
+    errors += (d > 1e-5f || d < -1e-5f);
+  }
+
+  assert(errors == 0);
+
+  /* octave counts outside 1..NOISE_FBM_PLAN_MAX_OCTAVES fail the node and the compile */
+  noise_graph_init(&graph);
+  x = noise_graph_x(&graph);
+  y = noise_graph_y(&graph);
+  assert(noise_graph_fbm_2(&graph, NOISE_TYPE_SIMPLEX, x, y, 0.01f, 0, 2.0f, 0.5f, 0) == -1);
+  assert(noise_graph_fbm_3(&graph, NOISE_TYPE_PERLIN, x, y, noise_graph_z(&graph), 0.01f, NOISE_FBM_PLAN_MAX_OCTAVES + 1, 2.0f, 0.5f, 0) == -1);
+  noise_graph_warp_2(&graph, x, y, 0.01f, -3, 2.0f, 0.5f, 20.0f, warp);
+  assert(warp[0] == -1 && warp[1] == -1);
+  assert(noise_graph_compile(&graph, noise_graph_add(&graph, x, warp[0]), &program) == 0);
+
+  /* a full node array fails every later builder and the compile */
+  noise_graph_init(&graph);
+  e = noise_graph_x(&graph);
+
+  for (i = 0; i < NOISE_GRAPH_MAX_NODES; ++i)
+  {
+    e = noise_graph_add(&graph, e, noise_graph_const(&graph, (float)i));
+  }
+
+  assert(e == -1);
+  assert(noise_graph_compile(&graph, e, &program) == 0);
+}
+
+void noise_test_fixed_point(void)
+{
+  static short row[4096];
+  static short tile[64 * 64];
+  float frequencies[3] = {0.013f, 0.21f, 1.7f};
+  float bounds[3] = {4e-4f, 1.5e-3f, 6e-4f};
+  float max_error[3] = {0.0f, 0.0f, 0.0f};
+  short q[3] = {-32767, 0, 32767};
+  unsigned char bytes[3];
+  noise_2_function reference[3];
+  int i, f, t, x, y, errors = 0;
+
+  reference[NOISE_TYPE_PERLIN] = noise_perlin_2;
+  reference[NOISE_TYPE_SIMPLEX] = noise_simplex_2;
+  reference[NOISE_TYPE_VALUE] = noise_value_2;
+
+  /* fade endpoints and symmetry */
+  assert(noise_q15_fade(0) == 0);
+  assert(noise_q15_fade(NOISE_Q15_HALF) >= NOISE_Q15_HALF - 3 && noise_q15_fade(NOISE_Q15_HALF) <= NOISE_Q15_HALF);
+  assert(noise_q15_fade(10000) + noise_q15_fade(NOISE_Q15_ONE - 10000) == NOISE_Q15_ONE);
+  assert(noise_q15_fade(NOISE_Q15_ONE - 1) == NOISE_Q15_ONE - 1);
+
+  /* documented maximum error against the float kernels */
+  for (t = 0; t < 3; ++t)
+  {
+    for (f = 0; f < 3; ++f)
+    {
+      noise_tile_2_q15(tile, 64, 64, (noise_type)t, -40.3f, 25.7f, 1.37f, frequencies[f]);
+
+      for (y = 0; y < 64; ++y)
+      {
+        for (x = 0; x < 64; ++x)
+        {
+          float e = (float)tile[y * 64 + x] / 32768.0f - reference[t](-40.3f + (float)x * 1.37f, 25.7f + (float)y * 1.37f, frequencies[f]);
+          e = e < 0.0f ? -e : e;
+          max_error[t] = e > max_error[t] ? e : max_error[t];
+        }
+      }
+    }
+  }
+
+  assert(max_error[NOISE_TYPE_PERLIN] < bounds[NOISE_TYPE_PERLIN]);
+  assert(max_error[NOISE_TYPE_SIMPLEX] < bounds[NOISE_TYPE_SIMPLEX]);
+  assert(max_error[NOISE_TYPE_VALUE] < bounds[NOISE_TYPE_VALUE]);
+
+  /* stepping a long row does not drift away from the float coordinates */
+  noise_simplex_2_row_q15(row, 4096, -7.0f, 3.0f, 0.01f, 1.0f);
+
+  for (i = 4000; i < 4096; ++i)
+  {
+    float e = (float)row[i] / 32768.0f - noise_simplex_2(-7.0f + (float)i * 0.01f, 3.0f, 1.0f);
+    errors += (e > bounds[NOISE_TYPE_SIMPLEX] || e < -bounds[NOISE_TYPE_SIMPLEX]);
+  }
+
+  assert(errors == 0);
+
+  /* 8-bit layers */
+  noise_q15_to_u8(q, 3, bytes);
+  assert(bytes[0] == 0);
+  assert(bytes[1] == 128);
+  assert(bytes[2] == 255);
+}
+
+void noise_test_job(void)
+{
+  static float expected[128 * 96];
+  static float sliced[128 * 96];
+  static float second[128 * 96];
+  noise_channel channel = {NOISE_TYPE_SIMPLEX, 0.02f, 5, 2.0f, 0.5f, 3.0f, -7.0f, 0};
+  noise_job job, other;
+  noise_job_queue queue;
+  float progress = 0.0f;
+  int steps = 0, errors = 0;
+
+  /* a fill sliced into 37-sample steps matches the one-shot channel fill */
+  noise_channels_2(&channel, 1, expected, 128, 96, 10.0f, 20.0f, 0.5f, 0);
+  noise_job_fill(&job, sliced, 128, 96, &channel, 10.0f, 20.0f, 0.5f);
+
+  while (noise_job_step(&job, 37))
+  {
+    errors += job.done > 37.0 * (double)(steps + 1); /* never more than the budget */
+    errors += noise_job_progress(&job) < progress;
+    progress = noise_job_progress(&job);
+    steps++;
+  }
+
+  assert(errors == 0);
+  assert(job.status == NOISE_JOB_DONE);
+  assert(steps == (128 * 96 + 36) / 37 - 1);
+  assert(noise_job_progress(&job) == 1.0f);
+  assert(memcmp(expected, sliced, sizeof(expected)) == 0);
+
+  /* a fill whose plan cannot be built is cancelled up front */
+  channel.octaves = NOISE_FBM_PLAN_MAX_OCTAVES + 1;
+  assert(noise_job_fill(&other, sliced, 128, 96, &channel, 10.0f, 20.0f, 0.5f) == 0);
+  assert(other.status == NOISE_JOB_CANCELLED && noise_job_step(&other, 100) == 0);
+  channel.octaves = 5;
+
+  /* erosion passes in 100-cell slices are bit-identical to the run-to-completion functions */
+  noise_erosion_thermal(expected, 128, 96, 0.001f, 3);
+  noise_job_erosion_thermal(&job, sliced, 128, 96, 0.001f, 3);
+  while (noise_job_step(&job, 100))
+  {
+  }
+  assert(memcmp(expected, sliced, sizeof(expected)) == 0);
+
+  noise_erosion_hydraulic(expected, 128, 96, 3, 0.05f, 0.1f, 0.05f, 0.4f, 0.2f);
+  noise_job_erosion_hydraulic(&job, sliced, 128, 96, 3, 0.05f, 0.1f, 0.05f, 0.4f, 0.2f);
+  while (noise_job_step(&job, 100))
+  {
+  }
+  assert(job.done == job.total);
+  assert(memcmp(expected, sliced, sizeof(expected)) == 0);
+
+  noise_erosion_wind(expected, 128, 96, 1.0f, 0.5f, 0.02f, 2);
+  noise_job_erosion_wind(&job, sliced, 128, 96, 1.0f, 0.5f, 0.02f, 2);
+  while (noise_job_step(&job, 100))
+  {
+  }
+  assert(memcmp(expected, sliced, sizeof(expected)) == 0);
+
+  /* degenerate maps finish on the first step */
+  noise_job_erosion_thermal(&job, sliced, 2, 2, 0.001f, 3);
+  assert(noise_job_step(&job, 100) == 0);
+  assert(job.status == NOISE_JOB_DONE);
+
+  /* cancelling stops the work */
+  memcpy(second, sliced, sizeof(sliced));
+  noise_job_erosion_thermal(&job, sliced, 128, 96, 0.0f, 10);
+  noise_job_step(&job, 500);
+  noise_job_cancel(&job);
+  memcpy(expected, sliced, sizeof(sliced));
+  assert(noise_job_step(&job, 500) == 0);
+  assert(job.status == NOISE_JOB_CANCELLED);
+  assert(memcmp(expected, sliced, sizeof(sliced)) == 0);
+
+  /* the higher priority job gets the budget first, the other one takes the rest */
+  noise_job_fill(&job, sliced, 128, 96, &channel, 0.0f, 0.0f, 1.0f);
+  noise_job_fill(&other, second, 128, 96, &channel, 0.0f, 0.0f, 1.0f);
+  other.priority = 1;
+
+  noise_job_queue_init(&queue);
+  assert(noise_job_queue_push(&queue, &job) == 1);
+  assert(noise_job_queue_push(&queue, &other) == 1);
+
+  assert(noise_job_queue_step(&queue, 1000) == 2);
+  assert(other.done == 1000.0 && job.done == 0.0);
+
+  assert(noise_job_queue_step(&queue, 128 * 96) == 1);
+  assert(other.status == NOISE_JOB_DONE && job.done == 1000.0);
+
+  while (noise_job_queue_step(&queue, 4096))
+  {
+  }
+  assert(job.status == NOISE_JOB_DONE);
+  assert(memcmp(sliced, second, sizeof(sliced)) == 0);
+}
+
+void noise_test_random(void)
+{
+  static unsigned int values[16384];
+  static float floats[16384];
+  unsigned char seen[256];
+  int buckets[16], low[2] = {0, 0};
+  int i, errors = 0, matches = 0;
+  float chi2 = 0.0f;
+
+  /* stateless: same (seed, stream, index) gives the same value, in any order */
+  assert(noise_random_u32(7, 3, 1000) == noise_random_u32(7, 3, 1000));
+  assert(noise_random_u32(7, 3, 1000) != noise_random_u32(7, 4, 1000));
+  assert(noise_random_u32(7, 3, 1000) != noise_random_u32(8, 3, 1000));
+
+  /* bulk fills match the scalar calls from any starting index */
+  noise_random_fill_u32(values, 16384, 1337, 5, 100);
+  noise_random_fill_float(floats, 16384, 1337, 5, 100);
+
+  for (i = 0; i < 16384; ++i)
+  {
+    errors += values[i] != noise_random_u32(1337, 5, 100u + (unsigned int)i);
+    errors += floats[i] != noise_random_float(1337, 5, 100u + (unsigned int)i);
+    errors += floats[i] < 0.0f || floats[i] >= 1.0f;
+  }
+
+  assert(errors == 0);
+
+  /* uniform high bits (chi-square, 15 degrees of freedom, p = 0.001 at 37.7) and balanced low bits */
+  for (i = 0; i < 16; ++i)
+  {
+    buckets[i] = 0;
+  }
+
+  for (i = 0; i < 16384; ++i)
+  {
+    buckets[values[i] >> 28]++;
+    low[values[i] & 1u]++;
+  }
+
+  for (i = 0; i < 16; ++i)
+  {
+    float d = (float)buckets[i] - 1024.0f;
+    chi2 += d * d / 1024.0f;
+  }
+
+  assert(chi2 < 37.7f);
+  assert(low[0] > 7936 && low[1] > 7936);
+
+  /* neighbouring streams are uncorrelated */
+  noise_random_fill_u32(values, 4096, 1337, 6, 100);
+
+  for (i = 0; i < 4096; ++i)
+  {
+    matches += (values[i] >> 31) == (noise_random_u32(1337, 5, 100u + (unsigned int)i) >> 31);
+  }
+
+  assert(matches > 1848 && matches < 2248);
+
+  /* noise_random_below is the high word of r * n for any n */
+  assert(noise_random_below(0xffffffffu, 256) == 255);
+  assert(noise_random_below(0xffffffffu, 0xffffffffu) == 0xfffffffeu);
+  assert(noise_random_below(0x80000000u, 1000000u) == 500000u);
+  assert(noise_random_below(0x12345678u, 0x9abcdef0u) == 0x0b00ea4eu);
+
+  for (i = 0; i < 16; ++i)
+  {
+    buckets[i] = 0;
+  }
+
+  for (i = 0, errors = 0; i < 16384; ++i)
+  {
+    unsigned int v = noise_random_below(values[i], 1600000u);
+    errors += v >= 1600000u;
+    buckets[(v / 100000u) & 15u]++;
+  }
+
+  for (i = 0, chi2 = 0.0f; i < 16; ++i)
+  {
+    float d = (float)buckets[i] - 1024.0f;
+    chi2 += d * d / 1024.0f;
+  }
+
+  assert(errors == 0 && chi2 < 37.7f);
+
+  /* noise_seed still builds a permutation */
+  noise_seed(99);
+
+  for (i = 0; i < 256; ++i)
+  {
+    seen[i] = 0;
+  }
+
+  for (i = 0; i < 256; ++i)
+  {
+    seen[noise_permutations[i]]++;
+    errors += noise_permutations[256 + i] != noise_permutations[i];
+  }
+
+  for (i = 0; i < 256; ++i)
+  {
+    errors += seen[i] != 1;
+  }
+
+  assert(errors == 0);
+
+  noise_seed(1337);
+}
+
+/* brute force reference: every cell the ray's box touches, exact patch test */
+static int noise_test_pyramid_reference(noise_pyramid *pyramid, float origin[3], float direction[3], float *t_hit)
+{
+  int cx, cy, hit = 0;
+  float best = 1e30f;
+
+  for (cy = 0; cy < pyramid->height - 1; ++cy)
+  {
+    for (cx = 0; cx < pyramid->width - 1; ++cx)
+    {
+      float t0 = 0.0f, t1 = 1.0f, t;
+      float lo[2], hi[2];
+      int axis;
+
+      lo[0] = (float)cx;
+      lo[1] = (float)cy;
+      hi[0] = (float)(cx + 1);
+      hi[1] = (float)(cy + 1);
+
+      for (axis = 0; axis < 2; ++axis)
+      {
+        if (direction[axis] == 0.0f)
+        {
+          t0 = (origin[axis] < lo[axis] || origin[axis] > hi[axis]) ? 2.0f : t0;
+        }
+        else
+        {
+          float ta = (lo[axis] - origin[axis]) / direction[axis], tb = (hi[axis] - origin[axis]) / direction[axis];
+          t0 = (ta < tb ? ta : tb) > t0 ? (ta < tb ? ta : tb) : t0;
+          t1 = (ta < tb ? tb : ta) < t1 ? (ta < tb ? tb : ta) : t1;
+        }
+      }
+
+      if (t0 <= t1 && noise_pyramid_cell_hit(pyramid, cx, cy, origin, direction, t0, t1, &t) && t < best)
+      {
+        best = t;
+        hit = 1;
+      }
+    }
+  }
+
+  *t_hit = best;
+  return hit;
+}
+
+void noise_test_pyramid(void)
+{
+  static float map[97 * 75];
+  static float nodes[3 * 97 * 75];
+  static float fresh[3 * 97 * 75];
+  static float origins[3 * 256], directions[3 * 256], t_hit[256];
+  static unsigned char visible[256];
+  float from[3] = {10.0f, 10.0f, 5.0f}, to[3] = {80.0f, 60.0f, 5.0f};
+  noise_pyramid pyramid, reference;
+  int i, x, y, hits, errors = 0, misses = 0;
+
+  noise_seed(1337);
+
+  for (y = 0; y < 75; ++y)
+  {
+    for (x = 0; x < 97; ++x)
+    {
+      map[y * 97 + x] = noise_simplex_2_fbm((float)x, (float)y, 0.04f, 4, 2.0f, 0.5f);
+    }
+  }
+
+  assert(noise_pyramid_size(1, 10) == 0);
+  assert(noise_pyramid_size(97, 75) <= (int)(sizeof(nodes) / sizeof(nodes[0])));
+  assert(noise_pyramid_build(&pyramid, map, 97, 75, nodes) == 1);
+  assert(pyramid.level_width[pyramid.levels - 1] == 1 && pyramid.level_height[pyramid.levels - 1] == 1);
+
+  /* grazing random rays, including axis-aligned and vertical ones, against brute force */
+  for (i = 0; i < 256; ++i)
+  {
+    float *o = origins + 3 * i, *d = directions + 3 * i;
+
+    o[0] = noise_random_float(5, 0, (unsigned int)i) * 120.0f - 10.0f;
+    o[1] = noise_random_float(5, 1, (unsigned int)i) * 90.0f - 8.0f;
+    o[2] = noise_random_float(5, 2, (unsigned int)i) * 1.5f;
+    d[0] = (i % 7 == 0) ? 0.0f : noise_random_float(5, 3, (unsigned int)i) * 160.0f - 80.0f;
+    d[1] = (i % 11 == 0) ? 0.0f : noise_random_float(5, 4, (unsigned int)i) * 160.0f - 80.0f;
+    d[2] = noise_random_float(5, 5, (unsigned int)i) * 2.0f - 1.2f;
+  }
+
+  hits = noise_pyramid_raycast_batch(&pyramid, origins, directions, 1.0f, t_hit, 256);
+
+  for (i = 0; i < 256; ++i)
+  {
+    float expected;
+    int hit = noise_test_pyramid_reference(&pyramid, origins + 3 * i, directions + 3 * i, &expected);
+
+    errors += hit != (t_hit[i] >= 0.0f);
+    errors += hit && (t_hit[i] - expected > 1e-4f || expected - t_hit[i] > 1e-4f);
+    misses += !hit;
+  }
+
+  assert(errors == 0);
+  assert(hits > 32 && misses > 32);
+
+  /* line of sight: high above sees, through the terrain does not */
+  assert(noise_pyramid_visible(&pyramid, from, to) == 1);
+  from[2] = to[2] = -5.0f;
+  assert(noise_pyramid_visible(&pyramid, from, to) == 0);
+  assert(noise_pyramid_visible_batch(&pyramid, origins, directions, visible, 1) == (int)visible[0]);
+
+  /* a raised wall is picked up by an incremental update, matching a full rebuild */
+  for (y = 30; y < 40; ++y)
+  {
+    for (x = 50; x < 53; ++x)
+    {
+      map[y * 97 + x] = 10.0f;
+    }
+  }
+
+  from[0] = 20.0f;
+  from[1] = to[1] = 35.0f;
+  from[2] = to[2] = 5.0f;
+  assert(noise_pyramid_visible(&pyramid, from, to) == 1);
+
+  noise_pyramid_update(&pyramid, 50, 30, 53, 40);
+  noise_pyramid_build(&reference, map, 97, 75, fresh);
+
+  assert(memcmp(nodes, fresh, (size_t)noise_pyramid_size(97, 75) * sizeof(float)) == 0);
+  assert(noise_pyramid_visible(&pyramid, from, to) == 0);
+}
+
+typedef struct noise_test_sink
+{
+  unsigned char data[2 * 60 * 45 + 64];
+  int size;
+
+} noise_test_sink;
+
+static int noise_test_sink_write(void *user, void *data, int size)
+{
+  noise_test_sink *sink = (noise_test_sink *)user;
+
+  if (sink->size + size > (int)sizeof(sink->data))
+  {
+    return 0;
+  }
+
+  memcpy(sink->data + sink->size, data, (size_t)size);
+  sink->size += size;
+
+  return 1;
+}
+
+void noise_test_layout(void)
+{
+  static float plain[60 * 45], back[60 * 45], tiled[64 * 48], morton[64 * 64], eroded[60 * 45];
+  static float scratch[3 * 60], row[60];
+  static noise_test_sink a, b;
+  noise_layout row_major, tiled_layout, morton_layout, single;
+  noise_channel channel = {NOISE_TYPE_SIMPLEX, 0.03f, 4, 2.0f, 0.5f, 0.0f, 0.0f, 0};
+  noise_stream stream;
+  int x, y, errors = 0;
+
+  noise_seed(1337);
+
+  assert(noise_layout_init(&row_major, NOISE_LAYOUT_ROW_MAJOR, 60, 45, 0) == 1);
+  assert(noise_layout_init(&tiled_layout, NOISE_LAYOUT_TILED, 60, 45, 4) == 1);
+  assert(noise_layout_init(&morton_layout, NOISE_LAYOUT_MORTON, 60, 45, 6) == 1);
+  assert(noise_layout_init(&single, NOISE_LAYOUT_MORTON, 60, 45, 0) == 0);
+  assert(noise_layout_size(&row_major) == 60 * 45);
+  assert(noise_layout_size(&tiled_layout) == 64 * 48);
+  assert(noise_layout_size(&morton_layout) == 64 * 64);
+
+  /* z-order inside a tile, tiles row-major */
+  assert(noise_layout_index(&morton_layout, 3, 5) == 0x27);
+  assert(noise_layout_init(&single, NOISE_LAYOUT_MORTON, 8, 8, 2) == 1);
+  assert(noise_layout_index(&single, 5, 1) == 16 + 3);
+  assert(noise_layout_index(&tiled_layout, 17, 1) == 256 + 16 + 1);
+
+  /* generators write the same samples in every layout */
+  noise_channels_2(&channel, 1, plain, 60, 45, 3.0f, -2.0f, 0.5f, 0);
+  noise_channel_2_layout(&channel, tiled, &tiled_layout, 3.0f, -2.0f, 0.5f);
+  noise_channel_2_layout(&channel, morton, &morton_layout, 3.0f, -2.0f, 0.5f);
+
+  for (y = 0; y < 45; ++y)
+  {
+    for (x = 0; x < 60; ++x)
+    {
+      errors += tiled[noise_layout_index(&tiled_layout, x, y)] != plain[y * 60 + x];
+      errors += morton[noise_layout_index(&morton_layout, x, y)] != plain[y * 60 + x];
+    }
+  }
+
+  assert(errors == 0);
+
+  /* conversion round trips */
+  assert(noise_layout_convert(morton, &morton_layout, tiled, &tiled_layout) == 1);
+  assert(noise_layout_convert(tiled, &tiled_layout, back, &row_major) == 1);
+  assert(memcmp(back, plain, sizeof(plain)) == 0);
+  assert(noise_layout_convert(plain, &row_major, morton, &tiled_layout) == 1);
+  assert(noise_layout_init(&single, NOISE_LAYOUT_TILED, 71, 45, 4) == 1);
+  assert(noise_layout_convert(plain, &row_major, tiled, &single) == 0);
+
+  /* exporters read rows from any layout */
+  assert(noise_stream_begin(&stream, NOISE_STREAM_RAW16, 60, 45, -1.0f, 1.0f, noise_test_sink_write, &a) == 1);
+  assert(noise_stream_rows(&stream, plain, 45) == 1);
+  noise_channel_2_layout(&channel, morton, &morton_layout, 3.0f, -2.0f, 0.5f);
+  assert(noise_stream_begin(&stream, NOISE_STREAM_RAW16, 60, 45, -1.0f, 1.0f, noise_test_sink_write, &b) == 1);
+  assert(noise_stream_layout(&stream, morton, &morton_layout, row) == 1);
+  assert(a.size == b.size && memcmp(a.data, b.data, (size_t)a.size) == 0);
+
+  /* erosion sweeps a three row window in row order, bit identical to the row-major passes */
+  assert(noise_layout_scratch_size(&row_major) == 0);
+  assert(noise_layout_scratch_size(&morton_layout) == 3 * 60);
+  assert(noise_layout_scratch_size(&tiled_layout) <= (int)(sizeof(scratch) / sizeof(scratch[0])));
+  memcpy(eroded, plain, sizeof(plain));
+  noise_erosion_thermal(eroded, 60, 45, 0.01f, 4);
+  noise_erosion_hydraulic(eroded, 60, 45, 2, 0.01f, 0.5f, 0.05f, 0.3f, 0.01f);
+  noise_erosion_wind(eroded, 60, 45, 1.0f, -1.0f, 0.1f, 2);
+  noise_channel_2_layout(&channel, tiled, &tiled_layout, 3.0f, -2.0f, 0.5f);
+  noise_erosion_thermal_layout(morton, &morton_layout, 0.01f, 4, scratch);
+  noise_erosion_thermal_layout(tiled, &tiled_layout, 0.01f, 4, scratch);
+  noise_erosion_hydraulic_layout(morton, &morton_layout, 2, 0.01f, 0.5f, 0.05f, 0.3f, 0.01f, scratch);
+  noise_erosion_hydraulic_layout(tiled, &tiled_layout, 2, 0.01f, 0.5f, 0.05f, 0.3f, 0.01f, scratch);
+  noise_erosion_wind_layout(morton, &morton_layout, 1.0f, -1.0f, 0.1f, 2, scratch);
+  noise_erosion_wind_layout(tiled, &tiled_layout, 1.0f, -1.0f, 0.1f, 2, scratch);
+
+  for (y = 0; y < 45; ++y)
+  {
+    noise_layout_read_row(morton, &morton_layout, y, row);
+    errors += memcmp(row, eroded + y * 60, sizeof(row)) != 0;
+    noise_layout_read_row(tiled, &tiled_layout, y, row);
+    errors += memcmp(row, eroded + y * 60, sizeof(row)) != 0;
+  }
+
+  assert(errors == 0);
+}
+
+void noise_test_ensemble(void)
+{
+  static float planes[5 * 70 * 33], plain[70 * 33];
+  static float xs[100], ys[100], points[5 * 100];
+  unsigned int seeds[5] = {1337, 7, 42, 0, 123456789};
+  noise_channel channel = {NOISE_TYPE_PERLIN, 0.05f, 4, 2.0f, 0.5f, 3.0f, -1.0f, 0};
+  noise_ensemble ensemble;
+  noise_fbm_plan plan;
+  float rotation[2][2] = {{0.8f, -0.6f}, {0.6f, 0.8f}};
+  float single[5];
+  int i, k, t, errors = 0;
+
+  assert(noise_ensemble_init(&ensemble, seeds, 0) == 0);
+  assert(noise_ensemble_init(&ensemble, seeds, NOISE_ENSEMBLE_MAX + 1) == 0);
+  assert(noise_ensemble_init(&ensemble, seeds, 5) == 1);
+
+  /* every plane equals a reseeded single-seed fill, for every noise type */
+  for (t = 0; t < 3; ++t)
+  {
+    channel.type = (noise_type)t;
+    noise_ensemble_channel_2(&ensemble, &channel, planes, 70, 33, -12.5f, 4.0f, 0.75f);
+
+    for (k = 0; k < 5; ++k)
+    {
+      noise_seed(seeds[k]);
+      noise_channels_2(&channel, 1, plain, 70, 33, -12.5f, 4.0f, 0.75f, 0);
+      errors += memcmp(planes + k * 70 * 33, plain, sizeof(plain)) != 0;
+    }
+  }
+
+  assert(errors == 0);
+
+  /* value noise ignores the seed, the seeded types do not */
+  assert(memcmp(planes, planes + 70 * 33, sizeof(plain)) == 0);
+  channel.type = NOISE_TYPE_SIMPLEX;
+  noise_ensemble_channel_2(&ensemble, &channel, planes, 70, 33, -12.5f, 4.0f, 0.75f);
+  assert(memcmp(planes, planes + 70 * 33, sizeof(plain)) != 0);
+
+  /* scattered points through a rotated plan */
+  for (i = 0; i < 100; ++i)
+  {
+    xs[i] = noise_random_float(3, 0, (unsigned int)i) * 200.0f - 100.0f;
+    ys[i] = noise_random_float(3, 1, (unsigned int)i) * 200.0f - 100.0f;
+  }
+
+  noise_fbm_plan_2(&plan, 0.02f, 5, 2.0f, 0.5f, rotation);
+  noise_ensemble_2_fbm_plan(&ensemble, NOISE_TYPE_SIMPLEX, &plan, xs, ys, 100, points);
+
+  for (k = 0; k < 5; ++k)
+  {
+    noise_seed(seeds[k]);
+
+    for (i = 0; i < 100; ++i)
+    {
+      errors += points[k * 100 + i] != noise_simplex_2_fbm_plan(&plan, xs[i], ys[i]);
+    }
+  }
+
+  noise_ensemble_2_fbm_plan(&ensemble, NOISE_TYPE_PERLIN, &plan, xs, ys, 100, points);
+
+  for (k = 0; k < 5; ++k)
+  {
+    noise_seed(seeds[k]);
+
+    for (i = 0; i < 100; ++i)
+    {
+      errors += points[k * 100 + i] != noise_perlin_2_fbm_plan(&plan, xs[i], ys[i]);
+    }
+  }
+
+  assert(errors == 0);
+
+  /* single point against the explicit table kernels */
+  noise_ensemble_2(&ensemble, NOISE_TYPE_PERLIN, 3.7f, -8.1f, 0.3f, single);
+
+  for (k = 0; k < 5; ++k)
+  {
+    errors += single[k] != noise_perlin_2_table(ensemble.perm[k], 3.7f, -8.1f, 0.3f);
+  }
+
+  assert(errors == 0);
+
+  noise_seed(1337);
+}
+
 int main(void)
 {
   /* Setup the PRNG seeding */
@@ -298,6 +2188,70 @@ int main(void)
   /* Erosion simulation */
   noise_test_erosion();
 
+  /* Volume generation */
+  noise_test_volume();
+
+  /* Batch sampling */
+  noise_test_batch();
+
+  /* Tile fBm */
+  noise_test_tile();
+
+  /* fBm plans */
+  noise_test_fbm_plan();
+
+  /* Vector-valued noise */
+  noise_test_vec();
+
+  /* Multi-channel sampling */
+  noise_test_channels();
+
+  /* Curl noise */
+  noise_test_curl();
+
+  /* Heightmap attributes */
+  noise_test_heightmap_derive();
+
+  /* Quantized output */
+  noise_test_quantize();
+
+  /* Streaming export */
+  noise_test_stream();
+
+  /* Tile cache */
+  noise_test_tile_cache();
+  noise_test_tile_lru();
+
+  /* Compressed tile storage */
+  noise_test_compress();
+
+  /* Tileable textures */
+  noise_test_tileable();
+
+  /* Spectral synthesis */
+  noise_test_spectral();
+
+  /* Noise graph */
+  noise_test_graph();
+
+  /* Fixed-point rows */
+  noise_test_fixed_point();
+
+  /* Resumable jobs */
+  noise_test_job();
+
+  /* Counter-based random numbers */
+  noise_test_random();
+
+  /* Heightfield pyramid */
+  noise_test_pyramid();
+
+  /* Memory layouts */
+  noise_test_layout();
+
+  /* Seed ensembles */
+  noise_test_ensemble();
+
   if (img)
   {
     free(img);
@@ -0,0 +1,167 @@
+/* noise.hpp - v0.4 - public domain data structures - nickscha 2025
+
+A C89 standard compliant, single header, nostdlib (no C Standard Library) Noise Generation (NOISE).
+
+This Test class verifies that the C++ compile-time specializations of noise.hpp match the C functions.
+
+LICENSE
+
+  Placed in the public domain and also MIT licensed.
+  See end of file for detailed license information.
+
+*/
+/* the erosion functions in noise.h are static but not inline */
+#if defined(__GNUC__)
+#pragma GCC diagnostic ignored "-Wunused-function"
+#endif
+#include "../noise.hpp" /* Noise Generation (C++) */
+
+/* deps/test.h is written for C89: string literals into char* and {0} initializers */
+#if defined(__GNUC__)
+#pragma GCC diagnostic ignored "-Wwrite-strings"
+#pragma GCC diagnostic ignored "-Wmissing-field-initializers"
+#endif
+#include "../deps/test.h" /* Simple Testing framework    */
+
+#define WIDTH 64
+#define HEIGHT 64
+
+/* the table exists at compile time */
+static_assert(noise::seeded<1337>::table.p[256] == noise::seeded<1337>::table.p[0], "constexpr permutation table");
+
+static void noise_test_hpp_table(void)
+{
+  const noise::permutation_table &table = noise::seeded<1337>::table;
+  int i, mismatches = 0;
+
+  noise_seed(1337);
+
+  for (i = 0; i < 512; ++i)
+  {
+    mismatches += table.p[i] != noise_permutations[i];
+  }
+
+  assert(mismatches == 0);
+}
+
+static void noise_test_hpp_fbm(void)
+{
+  const unsigned char *perm = noise::seeded<1337>::table.p;
+  float m2[2][2] = {{0.80f, -0.60f}, {0.60f, 0.80f}};
+  float m3[3][3] = {{0.00f, 0.80f, 0.60f}, {-0.80f, 0.36f, -0.48f}, {-0.60f, -0.48f, 0.64f}};
+  int x, y, mismatches = 0;
+  float error = 0.0f;
+
+  noise_seed(1337);
+
+  for (y = 0; y < HEIGHT; ++y)
+  {
+    for (x = 0; x < WIDTH; ++x)
+    {
+      float fx = static_cast<float>(x) * 3.7f, fy = static_cast<float>(y) * 2.9f, e;
+
+      /* lacunarity 2 is exact: bit identical to the runtime loops */
+      mismatches += noise::fbm_2<noise::perlin, 4>::sample(perm, fx, fy, 0.01f, 0.5f) != noise_perlin_2_fbm(fx, fy, 0.01f, 4, 2.0f, 0.5f);
+      mismatches += noise::fbm_2<noise::simplex, 6>::sample(perm, fx, fy, 0.01f, 0.5f) != noise_simplex_2_fbm(fx, fy, 0.01f, 6, 2.0f, 0.5f);
+      mismatches += noise::fbm_2<noise::value, 5>::sample(perm, fx, fy, 0.01f, 0.5f) != noise_value_2_fbm(fx, fy, 0.01f, 5, 2.0f, 0.5f);
+      mismatches += noise::fbm_3<noise::simplex, 3>::sample(perm, fx, fy, 7.0f, 0.01f, 0.5f) != noise_simplex_3_fbm(fx, fy, 7.0f, 0.01f, 3, 2.0f, 0.5f);
+
+      /* compile-time rotation and a rational lacunarity of 19/10 */
+      e = noise::fbm_2<noise::simplex, 9, noise::rotation<noise::standard_matrix_2>, 19, 10>::sample(perm, fx, fy, 0.01f, 0.55f) -
+          noise_simplex_2_fbm_rotation(fx, fy, 0.01f, 9, 1.9f, 0.55f, m2);
+      error = e > error ? e : (-e > error ? -e : error);
+
+      e = noise::fbm_3<noise::perlin, 4, noise::rotation<noise::standard_matrix_3>>::sample(perm, fx, fy, 7.0f, 0.01f, 0.5f) -
+          noise_perlin_3_fbm_rotation(fx, fy, 7.0f, 0.01f, 4, 2.0f, 0.5f, m3);
+      error = e > error ? e : (-e > error ? -e : error);
+    }
+  }
+
+  assert(mismatches == 0);
+  assert(error < 1e-5f);
+}
+
+static void noise_test_hpp_expression(void)
+{
+  typedef noise::fbm_2<noise::simplex, 4> base;
+  const unsigned char *perm = noise::seeded<1337>::table.p;
+  static float out[WIDTH * HEIGHT];
+  noise::fbm_expr<base> fbm(perm, 0.01f, 0.5f);
+  float error = 0.0f;
+  int x, y;
+
+  noise_seed(1337);
+
+  /* warped fBm remapped to [0, 1] plus smoothstep cliffs, fused into one loop */
+  noise::fill(noise::remap(noise::warp(fbm, noise::shift(fbm, 5.2f, 1.3f), noise::shift(fbm, -1.7f, 9.2f), 20.0f), -1.0f, 1.0f, 0.0f, 1.0f) +
+                  noise::smoothstep(fbm, 0.2f, 0.3f) * 0.25f,
+              out, WIDTH, HEIGHT, 100.0f, 50.0f, 2.0f);
+
+  for (y = 0; y < HEIGHT; ++y)
+  {
+    for (x = 0; x < WIDTH; ++x)
+    {
+      float px = 100.0f + static_cast<float>(x) * 2.0f, py = 50.0f + static_cast<float>(y) * 2.0f;
+      float wx = px + 20.0f * noise_simplex_2_fbm(px + 5.2f, py + 1.3f, 0.01f, 4, 2.0f, 0.5f);
+      float wy = py + 20.0f * noise_simplex_2_fbm(px - 1.7f, py + 9.2f, 0.01f, 4, 2.0f, 0.5f);
+      float expected = (noise_simplex_2_fbm(wx, wy, 0.01f, 4, 2.0f, 0.5f) + 1.0f) * 0.5f +
+                       noise_smoothstep(0.2f, 0.3f, noise_simplex_2_fbm(px, py, 0.01f, 4, 2.0f, 0.5f)) * 0.25f;
+      float e = out[y * WIDTH + x] - expected;
+
+      error = e > error ? e : (-e > error ? -e : error);
+    }
+  }
+
+  assert(error < 1e-5f);
+}
+
+int main(void)
+{
+  noise_test_hpp_table();
+  noise_test_hpp_fbm();
+  noise_test_hpp_expression();
+
+  return 0;
+}
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+*/
@@ -0,0 +1,115 @@
+/* noise.h - v0.4 - public domain data structures - nickscha 2025
+
+A C89 standard compliant, single header, nostdlib (no C Standard Library) Noise Generation (NOISE).
+
+This Test class verifies the profiling counters. It is its own translation unit so that
+NOISE_PROFILE stays off for noise_test.c, which covers the library as users build it.
+
+LICENSE
+
+  Placed in the public domain and also MIT licensed.
+  See end of file for detailed license information.
+
+*/
+#define NOISE_PROFILE
+#include "../noise.h"     /* Noise Generation */
+#include "../deps/test.h" /* Simple Testing framework    */
+
+static double noise_test_ticks;
+
+static double noise_test_clock(void)
+{
+  noise_test_ticks += 1.0;
+  return noise_test_ticks;
+}
+
+void noise_test_profile(void)
+{
+  static float map[32 * 32];
+  noise_profile profile;
+  float sum = 0.0f;
+  int i;
+
+  noise_profile_set_clock(noise_test_clock);
+  noise_profile_reset();
+
+  for (i = 0; i < 10; ++i)
+  {
+    sum += noise_simplex_2_fbm((float)i, 3.0f, 0.01f, 4, 2.0f, 0.5f);
+  }
+
+  assert(sum > -10.0f && sum < 10.0f);
+
+  noise_profile_snapshot(&profile);
+  assert(profile.samples == 10.0);
+  assert(profile.octaves == 40.0);
+  assert(profile.lattice == 120.0); /* 3 simplex corners per octave */
+
+  noise_profile_reset();
+  noise_perlin_2_fbm_tile(map, 32, 32, 0.0f, 0.0f, 1.0f, 0.05f, 3, 2.0f, 0.5f, 0);
+  noise_erosion_thermal(map, 32, 32, 0.001f, 4);
+
+  noise_profile_snapshot(&profile);
+  assert(profile.samples == 32.0 * 32.0);
+  assert(profile.octaves == 3.0 * 32.0 * 32.0);
+  assert(profile.lattice == 4.0 * 3.0 * 32.0 * 32.0);
+  assert(profile.api_calls[NOISE_PROFILE_API_TILE] == 1.0);
+  assert(profile.api_ticks[NOISE_PROFILE_API_TILE] == 1.0); /* the test clock advances once per read */
+  assert(profile.api_calls[NOISE_PROFILE_API_EROSION_THERMAL] == 1.0);
+  assert(profile.erosion_cells == 4.0 * 30.0 * 30.0);
+  assert(profile.erosion_active > 0.0 && profile.erosion_active <= profile.erosion_cells);
+
+  noise_profile_set_clock(0);
+}
+
+int main(void)
+{
+  noise_seed(1337);
+
+  /* Profiling counters */
+  noise_test_profile();
+
+  return 0;
+}
+
+/*
+   -----------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+*/